@@ -0,0 +1,15 @@
+#pragma once
+
+/// @brief One route on the selection screen, see the registry in src/main.cpp
+struct AutonRoute
+{
+    const char* name;
+    void (*run)();
+    float startX, startY, startHeading;     // the pose the route's setPosition gives
+    float timeLimit;                        // ms, 15000 for a match auton and 60000 for skills
+};
+
+static const int AUTON_ROUTE_COUNT = 8;
+extern const AutonRoute autonRoutes[AUTON_ROUTE_COUNT];
+
+void prepareRoute(int route);
@@ -0,0 +1,129 @@
+#pragma once
+#include "vex.h"
+
+#ifdef VEX_SIM
+#include <chrono>
+#endif
+
+class Drive;
+
+/// @brief Wall clock for timing code, in nanoseconds. On the brain it is the
+/// microsecond system timer. In the simulator that timer is simulated and stands
+/// still while code runs, so the host's own clock is used instead.
+inline uint64_t benchmarkClockNs()
+{
+#ifdef VEX_SIM
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+    return vex::timer::systemHighResolution() * 1000;
+#endif
+}
+
+/// @brief What one kernel cost
+struct BenchmarkResult
+{
+    const char* name;
+    uint32_t iterations;
+    float nsPerOp;      // mean over the batched pass
+    float worstNs;      // slowest single call, to the clock's resolution (1 us on the brain)
+    float p999Ns;       // 99.9th percentile single call, to within 1/8 of an octave. Unlike the
+                        // worst case it isn't one preemption by the host or another task
+};
+
+// Calls per timed batch, enough that the clock's resolution and cost drop out of the mean
+static const uint32_t BENCHMARK_BATCH = 1000;
+
+// Call time histogram, 8 buckets per doubling up to 2^40 ns
+static const int BENCHMARK_SUBBUCKETS = 8;
+static const int BENCHMARK_BUCKETS = 40 * BENCHMARK_SUBBUCKETS;
+
+/// @brief Histogram bucket of a call time
+inline int benchmarkBucket(uint64_t ns)
+{
+    if(ns < BENCHMARK_SUBBUCKETS)
+        return ns;
+    int octave = 63 - __builtin_clzll(ns);
+    int bucket = octave * BENCHMARK_SUBBUCKETS + (int)((ns >> (octave - 3)) & (BENCHMARK_SUBBUCKETS - 1));
+    return bucket < BENCHMARK_BUCKETS ? bucket : BENCHMARK_BUCKETS - 1;
+}
+
+/// @brief Longest call time that lands in a bucket
+inline uint64_t benchmarkBucketLimit(int bucket)
+{
+    if(bucket < BENCHMARK_SUBBUCKETS)
+        return bucket;
+    int octave = bucket / BENCHMARK_SUBBUCKETS;
+    uint64_t step = 1ull << (octave - 3);
+    return (1ull << octave) + (bucket % BENCHMARK_SUBBUCKETS + 1) * step - 1;
+}
+
+/// @brief Times a kernel twice: in batches for the mean, then call by call
+/// for the worst case and the percentile, less what reading the clock costs.
+/// @param name Label for the report
+/// @param iterations Calls in each pass
+/// @param kernel Callable taking the call number, return something derived from
+/// its result so the compiler can't drop the work
+template <typename Kernel>
+BenchmarkResult runBenchmark(const char* name, uint32_t iterations, Kernel kernel)
+{
+    volatile float sink = 0;
+    float sum = 0;
+
+    uint64_t total = 0;
+    for(uint32_t done = 0; done < iterations; done += BENCHMARK_BATCH)
+    {
+        uint64_t start = benchmarkClockNs();
+        for(uint32_t i = done; i < done + BENCHMARK_BATCH; i++)
+            sum += kernel(i);
+        total += benchmarkClockNs() - start;
+    }
+    uint32_t batched = (iterations + BENCHMARK_BATCH - 1) / BENCHMARK_BATCH * BENCHMARK_BATCH;
+
+    // The cheapest back to back clock read is taken as its cost
+    uint64_t clockCost = ~0ull;
+    for(int i = 0; i < 1000; i++)
+    {
+        uint64_t start = benchmarkClockNs();
+        uint64_t elapsed = benchmarkClockNs() - start;
+        if(elapsed < clockCost)
+            clockCost = elapsed;
+    }
+
+    uint64_t worst = 0;
+    uint32_t histogram[BENCHMARK_BUCKETS] = {0};
+    for(uint32_t i = 0; i < iterations; i++)
+    {
+        uint64_t start = benchmarkClockNs();
+        sum += kernel(i);
+        uint64_t elapsed = benchmarkClockNs() - start;
+        elapsed = elapsed > clockCost ? elapsed - clockCost : 0;
+        if(elapsed > worst)
+            worst = elapsed;
+        histogram[benchmarkBucket(elapsed)]++;
+    }
+    uint64_t p999 = 0;
+    uint32_t below = 0;
+    for(int bucket = 0; bucket < BENCHMARK_BUCKETS; bucket++)
+    {
+        below += histogram[bucket];
+        if(below >= iterations - iterations / 1000)
+        {
+            p999 = benchmarkBucketLimit(bucket);
+            break;
+        }
+    }
+    sink = sum;
+    (void)sink;
+
+    BenchmarkResult result;
+    result.name = name;
+    result.iterations = batched;
+    result.nsPerOp = total / (float)batched;
+    result.worstNs = worst;
+    result.p999Ns = p999 < worst ? p999 : worst;
+    return result;
+}
+
+void printBenchmarkHeader();
+void printBenchmark(const BenchmarkResult& result);
+void runControlBenchmarks(Drive& chassis, uint32_t iterations);
@@ -0,0 +1,76 @@
+#pragma once
+#include "vex.h"
+#include <atomic>
+
+// The file starts with a CardLogHeader, then records back to back. A record is a
+// word holding its length in words (low 16 bits) and its channel (high 16 bits),
+// a word of microseconds since the header's startTime (wraps after 71 minutes), then
+// its values as floats.
+// Channel 0 defines a channel: its first value word is the new channel's number,
+// the rest the text "name\0field,field,...\0" padded to a whole word.
+static const uint32_t CARD_LOG_MAGIC = 0x474f4c43;    // "CLOG"
+static const uint32_t CARD_LOG_VERSION = 1;
+static const uint16_t CARD_LOG_DEFINE = 0;
+
+// Values one record can hold
+static const int CARD_LOG_MAX_VALUES = 64;
+// Bytes the flush task gathers before writing, and the most it waits to write what it has (ms)
+static const uint32_t CARD_LOG_BLOCK = 4096;
+static const uint32_t CARD_LOG_FLUSH_MS = 500;
+
+/// @brief Start of a card log file
+struct CardLogHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t startTime;     // microseconds, timer::systemHighResolution() when the log was made
+};
+
+/// @brief Binary log to the SD card that any task can write to. log copies a record
+/// into a preallocated ring buffer without locking or touching the card, a low priority
+/// task started by start writes the buffer out in CARD_LOG_BLOCK blocks. When the card
+/// falls behind records are dropped and counted, the caller never waits. Decoded to
+/// CSV on the host by tools/cardlog.cpp.
+class CardLog
+{
+    private:
+        uint32_t* ring;
+        uint32_t mask;                      // ring size in words, less one
+        std::atomic<uint32_t> head;         // words reserved by writers, free running
+        std::atomic<uint32_t> tail;         // words flushed
+        std::atomic<uint32_t> dropped;
+        std::atomic<uint16_t> channels;
+        uint64_t startTime;
+        uint32_t written;                   // bytes written to the card
+
+        FILE* file;
+        volatile bool running;
+        volatile bool flushing;
+        uint8_t block[CARD_LOG_BLOCK];
+        uint32_t blockUsed;
+
+        CardLog(const CardLog&);
+        CardLog& operator=(const CardLog&);
+
+        bool reserve(uint32_t words, uint32_t& start);
+        void commit(uint32_t start, uint32_t words, uint16_t channel);
+        void writeBlock();
+        static int flushTask(void* log);
+
+    public:
+        CardLog(uint32_t capacity = 32768);
+        ~CardLog();
+
+        bool start(const char* filename);
+        void stop();
+        void flush();
+
+        uint16_t addChannel(const char* name, const char* fields);
+        bool log(uint16_t channel, const float* values, uint16_t count);
+
+        uint32_t pending() const {return (head.load(std::memory_order_relaxed) - tail.load(std::memory_order_relaxed)) * 4;}
+        uint32_t getDropped() const {return dropped.load(std::memory_order_relaxed);}
+        uint32_t getWritten() const {return written;}
+        uint64_t getStartTime() const {return startTime;}
+        bool isRunning() const {return running;}
+};
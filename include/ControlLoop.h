@@ -0,0 +1,59 @@
+#pragma once
+#include "vex.h"
+#include "Benchmark.h"
+
+/// @brief Fixed-rate loop scheduler for the motion primitives.
+/// Wakes on absolute deadlines (start + n * period) instead of sleeping a fixed
+/// amount after the work is done, so compute and sensor-read time no longer
+/// stretch the period. Deadlines sit on the system clock grid so the loop stays
+/// in step with the 10 ms motor and 5 ms rotation sensor refresh.
+class ControlLoop
+{
+    private:
+        uint32_t periodUs;
+        uint32_t phaseUs;
+
+        uint64_t deadline;
+        uint64_t lastWake;
+
+        // Statistics for the current run
+        uint32_t cycles;
+        uint32_t overruns;
+        uint64_t totalPeriodUs;
+        uint32_t lastPeriodUs;
+        uint32_t maxPeriodUs;
+
+        // Time spent working between waking up and the next wait, on the benchmark clock
+        uint64_t wakeNs;
+        uint64_t totalBusyNs;
+        uint32_t maxBusyNs;
+
+    public:
+        ControlLoop(float periodMs);
+        ControlLoop(float periodMs, float phaseMs);
+
+        void start();
+        float waitForNextCycle();
+
+        /// @brief Runs step once per period until it returns false
+        /// @param step Callable returning true to keep running
+        template <typename Step>
+        void run(Step step)
+        {
+            start();
+            while(step())
+                waitForNextCycle();
+        }
+
+        float getPeriod(){return periodUs / 1000.0;}
+        float getDt(){return lastPeriodUs / 1000000.0;}
+        float getLastPeriod(){return lastPeriodUs / 1000.0;}
+        float getMaxPeriod(){return maxPeriodUs / 1000.0;}
+        float getAveragePeriod();
+        uint32_t getCycles(){return cycles;}
+        uint32_t getOverruns(){return overruns;}
+        float getAverageBusy();
+        float getMaxBusy(){return maxBusyNs / 1000.0;}
+
+        void printStats(const char* name);
+};
@@ -3,10 +3,26 @@
 #include "vex.h"
 #include "odom.h"
 #include "PID.h"
+#include "ControlLoop.h"
+#include "MotionConstraints.h"
+#include "MotionHandle.h"
+#include "Path.h"
+#include "MotionProfile.h"
+#include "Trajectory.h"
+#include "RoutePlan.h"
+#include "DriveKinematics.h"
+#include "VelocityController.h"
+#include "PoseEstimator.h"
+#include "FastMath.h"
+#include "SensorLog.h"
+#include "MotionLog.h"
+#include "CardLog.h"
 
 using namespace vex;
 
 enum MotorSpinType {VOLTS, PERCENTAGE, DPS, RPM};
+enum SwingSide {SWING_LEFT, SWING_RIGHT}; // the side that drives, the other one is locked
+enum MotionCommand {MOTION_NONE, MOTION_DRIVE, MOTION_TURN, MOTION_MOVE_TO, MOTION_MOVE_TO_POSE};
 
 class Drive
 {
@@ -15,13 +31,101 @@ class Drive
     motor_group leftDrive, rightDrive;
     inertial inertialSensor;
 
-    float driveMaxVoltage;
-    float turnMaxVoltage;
+    // Fixed 10 ms scheduler every motion primitive runs on
+    ControlLoop motionLoop;
 
-    float wheelRatio, wheelDiameter;
+    // Background odometry task
+    volatile bool odometryRunning;
+    static int odometryTask(void* chassis);
 
-    float driveKp, driveKi, driveKd, driveSettleError, driveTimeToSettle, driveEndTime;
-    float turnKp, turnKi, turnKd, turnSettleError, turnTimeToSettle, turnEndTime;
+    // Pose reset handed to the odometry task so it stays the only writer
+    volatile bool resetRequested;
+    float resetX, resetY, resetHeading;
+    void applyPosition(float x, float y, float heading);
+
+    // Fuses the pods, drive encoders, inertial and an optional GPS when enabled,
+    // in place of the single-source odometry. Only the odometry task touches it.
+    PoseEstimator estimator;
+    bool estimatorEnabled;
+    gps* gpsSensor;
+    float gpsDeviation, lastGpsX, lastGpsY;
+    volatile bool measurementPending;
+    float measuredX, measuredY, measuredDeviation;
+    void configureEstimator();
+    void updateEstimator(const SensorSample& sample);
+
+    // Sensor recording for replay, see SensorLog. Written by the odometry task only.
+    SensorLog* sensorLog;
+    volatile float commandedLeft, commandedRight;
+    void logSample(SensorSample& sample, float x, float y, float heading, uint32_t flags);
+
+    // State logging to the SD card every other odometry cycle, see CardLog
+    CardLog* cardLog;
+    uint16_t cardChannel;
+    uint32_t cardCycle;
+    void logState(const SensorSample& sample);
+
+    // Motion recording for tools/autonbench, written by whichever task runs the motion
+    MotionLog* motionLog;
+    uint64_t motionStartTime;
+
+    // One open loop straight or spin of calibrateOdometry
+    void logCalibrationSegment(std::string& log, int segment, bool spin, float target);
+
+    // Limits used by every move that does not set its own
+    MotionConstraints driveDefaults, turnDefaults;
+
+    // Wheel size, gearing and track width
+    DriveKinematics kinematics;
+
+    // Per-side speed control for driveVelocity
+    VelocityController leftVelocity, rightVelocity;
+
+    // Pure pursuit lookahead range in inches
+    float minLookahead, maxLookahead;
+
+    float driveKp, driveKi, driveKd;
+    float turnKp, turnKi, turnKd;
+
+    // Profiled motions, inches for drives and degrees for turns
+    Feedforward driveFeedforward, turnFeedforward;
+    ProfileLimits driveProfile, turnProfile;
+
+    // Profiles built ahead of the match by the route's planner, see PlanCache
+    const RoutePlan* routePlan;
+    MotionProfile planProfile(float distance, const ProfileLimits& limits);
+
+    // Set when the last motion exited chained, the next one starts from its target
+    bool chainPending;
+    Pose chainTarget;
+
+    // Motion running on its own task, see MotionHandle
+    struct AsyncMotion
+    {
+        MotionCommand command;
+        float a, b, c;
+        MotionConstraints constraints;
+    };
+    AsyncMotion asyncMotion;
+    volatile uint32_t motionsStarted, motionsFinished;
+    volatile int32_t asyncOwner;
+    volatile MotionCommand motionCommand;
+    volatile bool cancelRequested;
+    volatile float motionTraveled, motionTotal;
+    static int asyncMotionTask(void* chassis);
+    MotionHandle startAsync(MotionCommand command, float a, float b, float c, const MotionConstraints& constraints);
+    void waitForAsyncMotion();
+
+    Pose beginMotion();
+    void endMotion(const char* name, PID& pid);
+    void reportProgress(float traveled, float total){motionTraveled = traveled; motionTotal = total;}
+    void runTurn(float angle, float Kd, const MotionConstraints& constraints);
+    void runArc(float angle, float radius, bool lockLeft, bool lockRight, const MotionConstraints& constraints);
+    void chainFrom(float x, float y, float heading);
+    bool motionFinished(PID& pid, const MotionConstraints& limits);
+    bool motionFinished(PID& pid, const MotionConstraints& limits, bool canSettle);
+    void applyExits(PID& pid, const MotionConstraints& limits);
+    ExitReason lastExit;
 
     
     int odomType;
@@ -38,6 +142,21 @@ class Drive
     void setDriveConstants(float Kp, float Ki, float Kd, float settleError, float timeToSettle, float endTime);
     void setTurnConstants(float Kp, float Ki, float Kd, float settleError, float timeToSettle, float endTime);
 
+    void setDriveExitConditions(float settleVelocity, float largeError, float largeErrorTime, float stallProgress, float stallTime);
+    void setTurnExitConditions(float settleVelocity, float largeError, float largeErrorTime, float stallProgress, float stallTime);
+
+    void setDriveFeedforward(float kS, float kV, float kA);
+    void setTurnFeedforward(float kS, float kV, float kA);
+    void setDriveProfile(float maxVelocity, float maxAcceleration, float maxJerk);
+    void setTurnProfile(float maxVelocity, float maxAcceleration, float maxJerk);
+    ProfileLimits getDriveProfile(){return driveProfile;}
+    ProfileLimits getTurnProfile(){return turnProfile;}
+    void usePlan(const RoutePlan* plan){routePlan = plan;}
+
+    void setCartridge(float rpm);
+    void setVelocityConstants(float kP, float kI, float integralLimit);
+    const DriveKinematics& getKinematics(){return kinematics;}
+
     void arcade();
     void tank();
 
@@ -46,6 +165,13 @@ class Drive
     void driveMotors(float leftVolts, float rightVolts);
     void driveMotors(float leftVolts, float rightVolts, MotorSpinType spinType);
 
+    void driveVelocity(float leftSpeed, float rightSpeed);
+    void driveVelocity(float leftSpeed, float rightSpeed, float maxVoltage);
+    void driveChassisVelocity(float linear, float angular);
+    void driveChassisVelocity(float linear, float angular, float maxVoltage);
+    float getLeftSpeed();
+    float getRightSpeed();
+
     void brake();
     void brake(brakeType);
     void brake(bool left, bool right);
@@ -54,6 +180,7 @@ class Drive
     void driveDistance(float distance);
     void driveDistance(float distance, float maxVoltage);
     void driveDistanceWithOdom(float distance);
+    void driveDistanceWithOdom(float distance, const MotionConstraints& constraints);
     void driveDistanceWithOdomTime(float distance, float timeLimit);
     void driveDistanceWithOdomTime(float distance, float timeLimit, float maxVoltage);
     void driveDistanceWithOdomSettle(float distance, float settleTime, float settleError);
@@ -74,15 +201,73 @@ class Drive
 
     void turnToAngle(float angle);
     void turnToAngle(float angle, float maxVoltage);
+    void turnToAngle(float angle, const MotionConstraints& constraints);
     void turnToAngleTime(float angle, float timeLimit, float maxVoltage);
     void turnToAngleD(float angle, float maxVoltage, float turnKdUpdate);
+
+    void swingToAngle(float angle, SwingSide side);
+    void swingToAngle(float angle, SwingSide side, const MotionConstraints& constraints);
+    void arcToAngle(float angle, float radius);
+    void arcToAngle(float angle, float radius, const MotionConstraints& constraints);
     
     void moveToPosition(float, float);
+    void moveToPosition(float desX, float desY, const MotionConstraints& constraints);
     void turnToPosition(float desX, float desY);
+    void turnToPosition(float desX, float desY, const MotionConstraints& constraints);
+    Pose getMotionStart();
+
+    void moveToPose(float desX, float desY, float desHeading);
+    void moveToPose(float desX, float desY, float desHeading, const MotionConstraints& constraints);
+
+    MotionHandle driveDistanceWithOdomAsync(float distance);
+    MotionHandle driveDistanceWithOdomAsync(float distance, const MotionConstraints& constraints);
+    MotionHandle turnToAngleAsync(float angle);
+    MotionHandle turnToAngleAsync(float angle, const MotionConstraints& constraints);
+    MotionHandle moveToPositionAsync(float desX, float desY);
+    MotionHandle moveToPositionAsync(float desX, float desY, const MotionConstraints& constraints);
+    MotionHandle moveToPoseAsync(float desX, float desY, float desHeading);
+    MotionHandle moveToPoseAsync(float desX, float desY, float desHeading, const MotionConstraints& constraints);
+
+    uint32_t getMotionsStarted(){return motionsStarted;}
+    uint32_t getMotionsFinished(){return motionsFinished;}
+    float getMotionTraveled(){return motionTraveled;}
+    float getMotionProgress(){return motionTotal > 0 ? motionTraveled / motionTotal : 0;}
+    void cancelMotion();
+    ExitReason getLastExit(){return lastExit;}
 
     void bezierTurn(float, float, float, float, float, float, int);
 
+    void setTrackWidth(float trackWidth);
+    void setOdomGyroWeight(float weight);
+    void setOdomProfile(const OdomProfile& profile);
+    void calibrateOdometry(const char* filename);
+    void usePoseEstimator(bool enabled);
+    void useGPS(gps* sensor, float standardDeviation);
+    void addPositionMeasurement(float x, float y, float standardDeviation);
+    void setLookahead(float minLookahead, float maxLookahead);
+    void followPath(const Path& path);
+    void followPath(const Path& path, const MotionConstraints& constraints);
+    void followPath(const Path& path, const MotionConstraints& constraints, bool backwards);
+    bool followPlannedPath(int index);
+    bool followPlannedPath(int index, const MotionConstraints& constraints, bool backwards);
+
+    void followTrajectory(const Trajectory& trajectory);
+    void followTrajectory(const Trajectory& trajectory, const MotionConstraints& constraints);
+
     void updatePosition();
     void setPosition(float x, float y, float heading);
 
+    SensorSample readSensors();
+    void integrateSensors(const SensorSample& sample);
+    void resetToSensors(float x, float y, float heading, const SensorSample& sample);
+    void recordSensors(SensorLog* log);
+    void recordMotions(MotionLog* log);
+    void logToCard(CardLog* log);
+
+    void startOdometry();
+    void stopOdometry();
+    bool isOdometryRunning(){return odometryRunning;}
+
+    ControlLoop& getMotionLoop(){return motionLoop;}
+
 };
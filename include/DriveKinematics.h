@@ -0,0 +1,39 @@
+#pragma once
+#include <math.h>
+
+/// @brief Tank drive model that converts between motor speeds, wheel speeds
+/// and chassis motion. Speeds are in/s at the wheel, angular speeds are deg/s
+/// with clockwise positive like the headings.
+struct DriveKinematics
+{
+    float wheelDiameter;    // inches
+    float wheelRatio;       // wheel turns per motor turn, 0.6 for a 36:60 reduction
+    float cartridgeRPM;     // free speed of the motor cartridge (100, 200 or 600)
+    float trackWidth;       // inches between the left and right wheels
+
+    DriveKinematics() : wheelDiameter(0), wheelRatio(1), cartridgeRPM(600), trackWidth(12) {}
+
+    /// @brief Converts motor shaft rotation to distance at the wheel
+    float motorDegreesToInches(float degrees) const {return degrees / 360 * wheelRatio * M_PI * wheelDiameter;}
+
+    float motorRPMToSpeed(float rpm) const {return rpm / 60 * wheelRatio * M_PI * wheelDiameter;}
+    float speedToMotorRPM(float speed) const {return speed * 60 / (wheelRatio * M_PI * wheelDiameter);}
+
+    /// @brief Fastest a side can go with the motors at free speed
+    float maxSpeed() const {return motorRPMToSpeed(cartridgeRPM);}
+
+    /// @brief Splits a chassis motion into the speed each side has to run at
+    /// @param linear Forward speed in in/s
+    /// @param angular Turn rate in deg/s, clockwise positive
+    /// @param left Left side speed in in/s
+    /// @param right Right side speed in in/s
+    void toWheelSpeeds(float linear, float angular, float& left, float& right) const
+    {
+        float turnSpeed = angular * (M_PI / 180) * trackWidth / 2;
+        left = linear + turnSpeed;
+        right = linear - turnSpeed;
+    }
+
+    float linearSpeed(float left, float right) const {return (left + right) / 2;}
+    float angularSpeed(float left, float right) const {return (left - right) / trackWidth * (180 / M_PI);}
+};
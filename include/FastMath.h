@@ -0,0 +1,26 @@
+#pragma once
+
+/// @brief sin, cos and atan2 for the odometry and motion loops, a table lookup
+/// corrected by a short polynomial instead of the full libm routines.
+///
+/// sin and cos look up the nearest of 256 points around the circle and rotate
+/// by the remainder (under 0.0123 rad) with its Taylor series, atan2 looks up
+/// the nearest of 65 points on [0, 1] and adds the atan of the leftover angle.
+/// The series are cut where the first dropped term is below 1e-19, so the error
+/// is double rounding, checked against libm by tools/mathbench (make mathbench):
+///
+///   fastSin, fastCos, fastSinCos   within 1e-15 absolute for |x| <= 1e4 rad
+///   fastAtan2                      within 1e-15 rad
+///
+/// Beyond 1e6 rad sin and cos hand over to libm. The tables are filled on the
+/// first call, so these work from static constructors in other files too.
+
+double fastSin(double radians);
+double fastCos(double radians);
+void fastSinCos(double radians, double& sine, double& cosine);
+
+/// @brief atan2, the arguments in libm's order, (y, x)
+/// @param y The second coordinate of the point
+/// @param x The first coordinate of the point
+/// @return Returns the angle of (x, y) in radians, -pi to pi
+double fastAtan2(double y, double x);
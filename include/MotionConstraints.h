@@ -0,0 +1,61 @@
+#pragma once
+
+/// @brief Decides what ends a motion
+enum ExitPolicy
+{
+    EXIT_ON_SETTLE,     // the error stays inside the settle window for the settle time, or the timeout runs out
+    EXIT_ON_TIMEOUT,    // only the timeout or a stall ends the motion, for driving into a wall or goal
+    EXIT_CHAINED        // leaves at speed once the error is inside exitError and does not brake, the next command takes over
+};
+
+/// @brief Limits for a single move. Anything left at 0 uses the chassis defaults
+/// set with setDriveConstants/setTurnConstants and setDriveMaxVoltage/setTurnMaxVoltage.
+///
+/// chassis.driveDistanceWithOdom(16, MotionConstraints().withTimeout(1000).withMaxVoltage(8));
+struct MotionConstraints
+{
+    float maxVoltage;   // volts (0 - 12)
+    float minVoltage;   // volts, smallest output while the motion is running
+    float timeout;      // milliseconds
+    float settleError;  // inches for drives, degrees for turns
+    float settleTime;   // milliseconds
+    float exitError;    // inches for drives, degrees for turns, used by EXIT_CHAINED
+    float settleVelocity;   // inches or degrees per second, the error must also change slower than this to settle
+    float largeError;       // inches or degrees, a wider window that ends the motion after largeErrorTime
+    float largeErrorTime;   // milliseconds
+    float stallProgress;    // inches or degrees the error has to shrink by every stallTime
+    float stallTime;        // milliseconds without progress before the motion gives up
+    ExitPolicy exitPolicy;
+    bool profiled;      // follows a velocity profile with feedforward instead of raw PID output
+
+    MotionConstraints() : maxVoltage(0), minVoltage(0), timeout(0), settleError(0), settleTime(0), exitError(0),
+        settleVelocity(0), largeError(0), largeErrorTime(0), stallProgress(0), stallTime(0), exitPolicy(EXIT_ON_SETTLE), profiled(false) {}
+
+    MotionConstraints& withMaxVoltage(float volts){maxVoltage = volts; return *this;}
+    MotionConstraints& withMinVoltage(float volts){minVoltage = volts; return *this;}
+    MotionConstraints& withTimeout(float ms){timeout = ms; return *this;}
+    MotionConstraints& withSettle(float error, float ms){settleError = error; settleTime = ms; return *this;}
+    MotionConstraints& withSettleVelocity(float velocity){settleVelocity = velocity; return *this;}
+    MotionConstraints& withLargeErrorExit(float error, float ms){largeError = error; largeErrorTime = ms; return *this;}
+    MotionConstraints& withStallExit(float progress, float ms){stallProgress = progress; stallTime = ms; return *this;}
+    MotionConstraints& withExitPolicy(ExitPolicy policy){exitPolicy = policy; return *this;}
+    MotionConstraints& chained(float error){exitError = error; exitPolicy = EXIT_CHAINED; return *this;}
+    MotionConstraints& withProfile(){profiled = true; return *this;}
+
+    /// @brief Fills every unset field from the defaults
+    /// @param defaults The chassis defaults for this kind of motion
+    /// @return The constraints the motion actually runs with
+    MotionConstraints resolve(const MotionConstraints& defaults) const
+    {
+        MotionConstraints resolved = *this;
+        if(resolved.maxVoltage <= 0) resolved.maxVoltage = defaults.maxVoltage;
+        if(resolved.minVoltage <= 0) resolved.minVoltage = defaults.minVoltage;
+        if(resolved.timeout <= 0) resolved.timeout = defaults.timeout;
+        if(resolved.settleError <= 0) resolved.settleError = defaults.settleError;
+        if(resolved.settleTime <= 0) resolved.settleTime = defaults.settleTime;
+        if(resolved.settleVelocity <= 0) resolved.settleVelocity = defaults.settleVelocity;
+        if(resolved.largeError <= 0) {resolved.largeError = defaults.largeError; resolved.largeErrorTime = defaults.largeErrorTime;}
+        if(resolved.stallTime <= 0) {resolved.stallProgress = defaults.stallProgress; resolved.stallTime = defaults.stallTime;}
+        return resolved;
+    }
+};
@@ -0,0 +1,32 @@
+#pragma once
+#include "vex.h"
+
+class Drive;
+
+/// @brief Handle to a motion started with one of the Drive ...Async functions.
+/// The motion runs on its own task, so the auton can run mechanisms while the
+/// chassis moves and then wait for whichever it needs next.
+///
+/// MotionHandle move = chassis.driveDistanceWithOdomAsync(40);
+/// move.waitUntilDistance(30);
+/// toggleLift();
+/// move.waitUntilDone();
+class MotionHandle
+{
+    private:
+        Drive* drive;
+        uint32_t id;
+
+    public:
+        MotionHandle() : drive(0), id(0) {}
+        MotionHandle(Drive* drive, uint32_t id) : drive(drive), id(id) {}
+
+        bool isDone();
+        bool isRunning();
+
+        void waitUntilDone();
+        void waitUntilDistance(float distance);
+        void waitUntilProgress(float progress);
+
+        void cancel();
+};
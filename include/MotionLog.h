@@ -0,0 +1,44 @@
+#pragma once
+#include "vex.h"
+#include "PID.h"
+
+// Motions a log keeps, a long skills route runs well under this
+static const int MOTION_LOG_SIZE = 256;
+
+/// @brief How one motion went, from beginMotion to the end of its loop
+struct MotionRecord
+{
+    const char* name;       // the Drive function that ran the loop
+    float start;            // ms from the start of recording
+    float duration;         // ms
+    float settling;         // ms after the error first came inside the settle window, or
+                            // since it last improved for a motion that never got there
+    float error;            // error left at the end, inches for drives and degrees for turns
+    ExitReason exit;
+    float x, y, heading;    // odometry pose at the end
+};
+
+/// @brief The motions of a route, in the order they ran. Drive::recordMotions adds one
+/// every time a motion finishes. Read by tools/autonbench.cpp, print shows it on the terminal.
+class MotionLog
+{
+    private:
+        MotionRecord records[MOTION_LOG_SIZE];
+        volatile uint32_t count;
+        uint32_t dropped;
+        uint64_t startTime;
+
+    public:
+        MotionLog() : count(0), dropped(0), startTime(0) {}
+
+        void record(const MotionRecord& record);
+        void clear(){count = 0; dropped = 0;}
+        void setStartTime(uint64_t time){startTime = time;}
+
+        uint32_t size() const {return count;}
+        uint32_t getDropped() const {return dropped;}
+        uint64_t getStartTime() const {return startTime;}
+        const MotionRecord& operator[](uint32_t index) const {return records[index];}
+
+        void print() const;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+/// @brief Where a profile wants the robot to be at one point in time
+struct ProfilePoint
+{
+    float position;     // inches or degrees
+    float velocity;     // per second
+    float acceleration; // per second squared
+};
+
+/// @brief Motor voltage needed to move at a velocity and acceleration
+/// V = kS * sign(v) + kV * v + kA * a
+struct Feedforward
+{
+    float kS;   // volts to overcome friction
+    float kV;   // volts per unit/s
+    float kA;   // volts per unit/s^2
+
+    Feedforward() : kS(0), kV(0), kA(0) {}
+    Feedforward(float kS, float kV, float kA) : kS(kS), kV(kV), kA(kA) {}
+
+    float compute(float velocity, float acceleration) const
+    {
+        float friction = velocity > 0 ? kS : (velocity < 0 ? -kS : 0);
+        return friction + kV * velocity + kA * acceleration;
+    }
+};
+
+/// @brief Velocity, acceleration and jerk limits for a profile. A jerk of 0
+/// gives a trapezoidal profile, anything else an S-curve.
+struct ProfileLimits
+{
+    float maxVelocity;
+    float maxAcceleration;
+    float maxJerk;
+
+    ProfileLimits() : maxVelocity(0), maxAcceleration(0), maxJerk(0) {}
+    ProfileLimits(float maxVelocity, float maxAcceleration, float maxJerk) : maxVelocity(maxVelocity), maxAcceleration(maxAcceleration), maxJerk(maxJerk) {}
+
+    /// @brief A profile needs a velocity and an acceleration limit, the jerk is optional
+    bool isSet() const {return maxVelocity > 0 && maxAcceleration > 0 && maxJerk >= 0;}
+};
+
+/// @brief Rest-to-rest motion profile over a distance. The acceleration ramps
+/// at the jerk limit up to the acceleration limit, the robot cruises at the
+/// velocity limit, and the stop mirrors the start. Short moves that can't
+/// reach the limits get a lower peak velocity instead. Without limits set the
+/// profile is over before it starts, it holds the end from the first sample.
+class MotionProfile
+{
+    private:
+        float distance;         // always positive, direction holds the sign
+        float direction;
+        float jerk;
+        float peakVelocity;
+        float peakAcceleration;
+        float jerkTime;         // time spent ramping the acceleration, each end of the speed up
+        float holdTime;         // time at peak acceleration
+        float accelTime;        // length of the whole speed up
+        float accelDistance;
+        float cruiseTime;
+        float totalTime;
+
+        void shape(float velocity, const ProfileLimits& limits);
+        ProfilePoint speedUp(float t) const;
+
+    public:
+        MotionProfile();
+        MotionProfile(float distance, const ProfileLimits& limits);
+
+        ProfilePoint sample(float t) const;
+        float getDuration() const {return totalTime;}
+        float getPeakVelocity() const {return peakVelocity * direction;}
+};
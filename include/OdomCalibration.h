@@ -0,0 +1,11 @@
+#pragma once
+// Hand-tuned values from before the first calibration run. Regenerate with make odomprofile CAL=<log>, see tools/odomfit
+#include "OdomProfile.h"
+
+const OdomProfile ODOM_CALIBRATION = {
+    1.9550, 1.9550,     // pod diameters (in)
+    48.000, -48.000,     // pod angles (deg)
+    -3.867, 3.867,     // pod levers (in/rad)
+    2.6600,             // drive wheel diameter (in)
+    12.000              // track width (in)
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+/// @brief Measured geometry of the tracking pods and drive, written by tools/odomfit
+/// from a Drive::calibrateOdometry log. Applied with Drive::setOdomProfile.
+///
+/// Each pod reads forward * cos(angle) + lateral * sin(angle) + lever * turn,
+/// with the turn in radians clockwise. Vertical pods have an angle of 0 and a
+/// lever of their distance from the tracking center, positive for the left pod.
+struct OdomProfile
+{
+    float leftDiameter;         // rotation1 tracking wheel, inches
+    float rightDiameter;        // rotation2 tracking wheel, inches
+    float leftAngle;            // degrees from robot forward toward robot right
+    float rightAngle;
+    float leftLever;            // inches of pod travel per radian of clockwise turn
+    float rightLever;
+    float driveWheelDiameter;   // inches, 0 keeps the constructor value
+    float trackWidth;           // inches, 0 keeps setTrackWidth
+};
@@ -1,20 +1,54 @@
 #pragma once
 #include "deltaTime.h"
+#include "util.h"
+
+/// @brief What ended a motion
+enum ExitReason
+{
+    EXITED_NONE,        // still running
+    EXITED_SETTLED,     // inside the settle window, and slow enough if a settle velocity is set
+    EXITED_LARGE_ERROR, // inside the large error window for its whole time
+    EXITED_STALLED,     // the error stopped shrinking, usually pushed against a wall or goal
+    EXITED_TIMEOUT,     // ran out of time
+    EXITED_CANCELLED,   // cancelled from another task
+    EXITED_CHAINED      // reached the exit error of a chained motion
+};
+
+const char* exitReasonName(ExitReason reason);
 
 //PID Class
 class PID
 {
     private:
-    
+
     float Kp, Ki, Kd, settleError;
 
     DeltaTime deltaTime;
 
     float prevError = 0;
+    float prevMeasurement = 0;
     float integral = 0, derivative = 0;
     float output = 0;
     float timeToSettle = 0, endTime = 0;
     float timeSpentSettled = 0, runTime = 0;
+    float timeToWindow = -1;    // run time when the error first came inside the settle window, -1 until then
+    bool firstSample = true;
+
+    // Optional limits, 0 disables them
+    float integralLimit = 0;
+    float outputLimit = 0;
+    float slewRate = 0;         // output units per second
+    float derivativeFilter = 5; // low-pass time constant in milliseconds
+
+    // Optional exit conditions, 0 disables them
+    float settleVelocity = 0;   // error units per second, settling also needs the error to change slower than this
+    float largeError = 0, largeErrorTime = 0;
+    float stallProgress = 0, stallTime = 0;
+
+    float errorRate = 0;        // error units per second, filtered
+    float timeInLargeError = 0, timeStalled = 0;
+    float bestError = 0;
+    ExitReason exitReason = EXITED_NONE;
 
     public:
 
@@ -23,9 +57,28 @@ class PID
     PID(float Kp, float Ki, float Kd, float settleError, float timeToSettle, float endTime);
 
     float compute(float error);
+    float compute(float setpoint, float measurement);
     float computeDebug(float error);
 
     bool isSettled();
+    ExitReason checkExit();
+    ExitReason getExitReason(){return exitReason;}
+    void reset();
+    void resetExitTimers();
+    void resetSettleTimer();
+
+    void setIntegralLimit(float limit){integralLimit = limit;}
+    void setOutputLimit(float limit){outputLimit = limit;}
+    void setSlewRate(float unitsPerSecond){slewRate = unitsPerSecond;}
+    void setDerivativeFilter(float timeConstant){derivativeFilter = timeConstant;}
+    void setSettleVelocity(float unitsPerSecond){settleVelocity = unitsPerSecond;}
+    void setLargeErrorExit(float error, float time){largeError = error; largeErrorTime = time;}
+    void setStallExit(float progress, float time){stallProgress = progress; stallTime = time;}
 
     float getTimeSpentSettled(){return timeSpentSettled;}
-};
\ No newline at end of file
+    float getRunTime(){return runTime;}
+    float getTimeToWindow(){return timeToWindow;}
+    float getTimeStalled(){return timeStalled;}
+    float getError(){return prevError;}
+    float getErrorRate(){return errorRate;}
+};
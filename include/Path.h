@@ -0,0 +1,39 @@
+#pragma once
+#include <vector>
+
+/// @brief A point on a path with the distance travelled along the path to reach it
+struct PathPoint
+{
+    float x;        // inches
+    float y;        // inches
+    float distance; // inches from the first point
+};
+
+/// @brief Polyline for the pure pursuit follower. Curves are added as sampled
+/// Bezier segments, so the follower only ever deals with straight pieces.
+///
+/// Path path(0, 0);
+/// path.addQuadratic(12, 24, 36, 24, 10);
+/// chassis.followPath(path);
+class Path
+{
+    private:
+        std::vector<PathPoint> points;
+
+    public:
+        Path();
+        Path(float startX, float startY);
+
+        void addPoint(float x, float y);
+        void addQuadratic(float midX, float midY, float endX, float endY, int samples);
+        void addCubic(float control1X, float control1Y, float control2X, float control2Y, float endX, float endY, int samples);
+
+        int size() const {return points.size();}
+        const PathPoint& operator[](int i) const {return points[i];}
+        const PathPoint& back() const {return points.back();}
+        float length() const {return points.empty() ? 0 : points.back().distance;}
+
+        float closest(float x, float y, float from) const;
+        float distanceAt(float index) const;
+        bool lookahead(float x, float y, float radius, float& index, float& outX, float& outY) const;
+};
@@ -0,0 +1,112 @@
+#pragma once
+#include "vex.h"
+#include "PoseSnapshot.h"
+#include "OdomProfile.h"
+
+/// @brief One read of every sensor the estimator fuses
+struct EstimatorReadings
+{
+    uint64_t time;          // microseconds, timer::systemHighResolution()
+    float pods[2];          // rotation1 and rotation2 degrees
+    float leftMotor;        // drive motor group degrees
+    float rightMotor;
+    float inertialRotation; // unwrapped inertial degrees, clockwise
+};
+
+/// @brief Finite difference of a sensor that refreshes slower than it is read.
+/// A reading only counts once the value changes, or once it has held long
+/// enough that the sensor is really standing still.
+struct SensorRate
+{
+    float last;
+    uint64_t lastTime;
+    bool primed;
+
+    SensorRate() : last(0), lastTime(0), primed(false) {}
+
+    /// @param value The sensor reading
+    /// @param time Microseconds now
+    /// @param staleTime Microseconds an unchanged reading is trusted to mean stopped
+    /// @param rate Change per second since the last counted reading
+    /// @return Returns true when rate holds a new measurement
+    bool sample(float value, uint64_t time, float staleTime, float& rate)
+    {
+        if(!primed || time <= lastTime)
+        {
+            last = value;
+            lastTime = time;
+            primed = true;
+            return false;
+        }
+        float elapsed = time - lastTime;
+        if(value == last && elapsed < staleTime)
+            return false;
+        rate = (value - last) * 1e6f / elapsed;
+        last = value;
+        lastTime = time;
+        return true;
+    }
+};
+
+/// @brief Extended Kalman filter for the pose. The state is x, y (in), heading
+/// (rad, clockwise), forward and lateral speed (in/s) and turn rate (rad/s),
+/// carried forward at constant speed between reads.
+///
+/// Every sensor is a measurement of the state, each with its own noise:
+/// - the tracking pods see forward * cos(angle) + lateral * sin(angle) + lever * turn rate
+/// - the drive encoders see the forward speed plus or minus the turn at half the track,
+///   with extra noise while turning (scrub) and inflated further when a side disagrees
+///   with the filter by more than 3 sigma (wheel slip)
+/// - the inertial sensor sees the turn rate, from the change in rotation between its refreshes, and the heading
+/// - an absolute sensor such as the GPS sees x and y, see correctPosition
+class PoseEstimator
+{
+    public:
+        static const int STATES = 6;
+
+    private:
+        float state[STATES];
+        float covariance[STATES][STATES];
+
+        // Pod geometry, see OdomProfile
+        bool podsUsed[2];
+        float podDiameter[2], podAngle[2], podLever[2];
+
+        // Drive encoders, inches per motor degree and half the track width
+        float motorInches, halfTrack;
+
+        // Inertial rotation at the heading of 0
+        float inertialOffset;
+
+        // What a measurement outside the gate does
+        enum GateMode {GATE_REJECT, GATE_INFLATE, GATE_NONE};
+
+        SensorRate podRates[2], leftRate, rightRate, inertialRateSample;
+        int rejectedPositions;
+        uint64_t lastTime;
+        bool primed;
+
+        float forwardAcceleration, lateralAcceleration, turnAcceleration;
+        float podNoise, motorNoise, scrubNoise, rateNoise, headingNoise;
+
+        void predict(float dt);
+        bool correct(const float row[STATES], float innovation, float variance, GateMode gate);
+
+    public:
+        PoseEstimator();
+
+        void setPods(const OdomProfile& geometry, bool leftUsed, bool rightUsed);
+        void setDrive(float motorInchesPerDegree, float trackWidth);
+        void setProcessNoise(float forwardAcceleration, float lateralAcceleration, float turnAcceleration);
+        void setSensorNoise(float pod, float motor, float scrub, float rate, float heading);
+
+        void reset(float x, float y, float heading, float inertialRotation);
+        void update(const EstimatorReadings& readings);
+        bool correctPosition(float x, float y, float standardDeviation);
+        bool correctHeading(float heading, float standardDeviation);
+
+        Pose getPose() const;
+        float getForwardSpeed() const {return state[3];}
+        float getLateralSpeed() const {return state[4];}
+        float getTurnRate() const {return state[5] * 180 / M_PI;}
+};
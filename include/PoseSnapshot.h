@@ -0,0 +1,76 @@
+#pragma once
+#include "vex.h"
+
+/// @brief Robot pose on the field at a point in time
+struct Pose
+{
+    float x;            // inches
+    float y;            // inches
+    float heading;      // degrees
+    uint64_t timestamp; // microseconds, timer::systemHighResolution()
+
+    // Covariance of x, y and heading (in^2, in deg, deg^2), all 0 unless the pose estimator is running
+    float covXX, covXY, covYY;
+    float covXHeading, covYHeading, covHeading;
+};
+
+/// @brief Single-writer, multi-reader pose shared between the odometry task and
+/// everything else (motion loops, the macro thread, driver control, the screen).
+/// A sequence lock: the writer makes the counter odd while it copies the pose in
+/// and even again when done, a reader retries if the counter was odd or changed
+/// under it. Readers never block the writer and never see a torn x/y/heading.
+class PoseSnapshot
+{
+    private:
+        volatile uint32_t sequence;
+        Pose pose;
+
+    public:
+        PoseSnapshot() : sequence(0)
+        {
+            pose.x = 0; pose.y = 0; pose.heading = 0; pose.timestamp = 0;
+            pose.covXX = 0; pose.covXY = 0; pose.covYY = 0;
+            pose.covXHeading = 0; pose.covYHeading = 0; pose.covHeading = 0;
+        }
+
+        /// @brief Publishes a new pose. Only the odometry task may call this.
+        void write(float x, float y, float heading)
+        {
+            Pose next = pose;
+            next.x = x;
+            next.y = y;
+            next.heading = heading;
+            next.covXX = 0; next.covXY = 0; next.covYY = 0;
+            next.covXHeading = 0; next.covYHeading = 0; next.covHeading = 0;
+            write(next);
+        }
+
+        /// @brief Publishes a new pose with its covariance, stamped now. Only the odometry task may call this.
+        void write(const Pose& next)
+        {
+            sequence = sequence + 1;
+            __sync_synchronize();
+            pose = next;
+            pose.timestamp = vex::timer::systemHighResolution();
+            __sync_synchronize();
+            sequence = sequence + 1;
+        }
+
+        /// @brief Returns the latest consistent pose
+        Pose read() const
+        {
+            Pose copy;
+            uint32_t before, after;
+            do
+            {
+                before = sequence;
+                __sync_synchronize();
+                copy = pose;
+                __sync_synchronize();
+                after = sequence;
+            } while((before & 1) || before != after);
+            return copy;
+        }
+
+        uint32_t getSequence() const {return sequence;}
+};
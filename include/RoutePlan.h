@@ -0,0 +1,72 @@
+#pragma once
+#include "vex.h"
+#include "Path.h"
+#include "MotionProfile.h"
+#include <vector>
+
+/// @brief Paths and profiles an auton route needs, built ahead of the match
+/// so the route never plans while the robot waits.
+///
+/// void planAuton_4(RoutePlan& plan){
+///     Path& path = plan.addPath(-55.5, -19);
+///     path.addCubic(-55.5, -45, -45, -60, -29.5, -60, 20);
+///     plan.addProfile(24, chassis.getDriveProfile());
+/// }
+class RoutePlan
+{
+    private:
+        struct CachedProfile
+        {
+            float distance;
+            ProfileLimits limits;
+            MotionProfile profile;
+        };
+
+        std::vector<Path> paths;
+        std::vector<CachedProfile> profiles;
+        bool background;
+
+        void pause();
+
+    public:
+        RoutePlan() : background(false) {}
+
+        Path& addPath(float startX, float startY);
+        void addProfile(float distance, const ProfileLimits& limits);
+
+        const Path& path(int index) const {return paths[index];}
+        int pathCount() const {return paths.size();}
+        const MotionProfile* findProfile(float distance, const ProfileLimits& limits) const;
+
+        void clear();
+        void setBackground(bool background){this->background = background;}
+};
+
+/// @brief Builds the plan for a route
+typedef void (*RoutePlanner)(RoutePlan& plan);
+
+/// @brief Keeps the plan for the selected route ready. Picking a route starts
+/// building its plan on a low priority task while preAuton waits on the
+/// screen, picking another throws it away and starts over. autonomous() then
+/// takes the finished plan, or builds it on the spot if none was ready.
+class PlanCache
+{
+    private:
+        const RoutePlanner* planners;
+        int routeCount;
+        RoutePlan plan;
+
+        volatile int requested;     // route the plan should be for, -1 for none
+        volatile int built;         // route the plan holds, -1 while it is being built
+        volatile bool building;
+
+        static int buildTask(void* cache);
+        void build(int route);
+
+    public:
+        PlanCache(const RoutePlanner* planners, int routeCount);
+
+        void select(int route);
+        bool isReady(int route) const {return !building && built == route;}
+        const RoutePlan& acquire(int route);
+};
@@ -0,0 +1,77 @@
+#pragma once
+#include "vex.h"
+
+// Marks a sample read by a pose reset (setPosition) instead of an odometry update
+static const uint32_t SENSOR_SAMPLE_RESET = 1;
+
+/// @brief One read of every odometry sensor, as the odometry task saw it, and what
+/// came of it. Fixed size and 8 byte aligned so the brain and the host agree on the layout.
+struct SensorSample
+{
+    uint64_t time;              // microseconds, timer::systemHighResolution()
+    double pods[2];             // rotation1 and rotation2 position, degrees
+    double leftMotor;           // drive encoders, degrees
+    double rightMotor;
+    double inertialHeading;     // degrees, 0 - 360
+    double inertialRotation;    // degrees, unwrapped
+    float leftVolts;            // last voltage commanded to each side of the drive
+    float rightVolts;
+    float x;                    // pose published after the update, or the pose a reset set
+    float y;
+    float heading;
+    uint32_t flags;             // SENSOR_SAMPLE_RESET
+};
+static_assert(sizeof(SensorSample) == 80, "SensorSample layout changed, bump SENSOR_LOG_VERSION");
+
+static const uint32_t SENSOR_LOG_MAGIC = 0x474f4c53;   // "SLOG"
+static const uint32_t SENSOR_LOG_VERSION = 1;
+
+/// @brief Start of a sensor log file, followed by count samples
+struct SensorLogHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sampleSize;
+    uint32_t count;
+    int32_t odomType;           // the Drive's odom type while recording
+    uint32_t estimator;         // 1 when the pose estimator made the poses
+    uint64_t startTime;         // microseconds, when recording started
+};
+
+/// @brief Fixed size in-memory recording of odometry sensor samples. Drive::recordSensors
+/// appends one every odometry cycle, save writes them to the SD card once the run is over
+/// so the odometry task never waits on the card. At 5 ms a cycle 12000 samples is a minute.
+/// Replayed on the host by tools/replay.cpp and by the simulator's SIM_REPLAY.
+class SensorLog
+{
+    private:
+        SensorSample* samples;
+        uint32_t capacity;
+        volatile uint32_t count;
+        uint32_t dropped;
+        int32_t odomType;
+        bool estimator;
+        uint64_t startTime;
+
+        SensorLog(const SensorLog&);
+        SensorLog& operator=(const SensorLog&);
+
+    public:
+        SensorLog(uint32_t capacity);
+        ~SensorLog();
+
+        void record(const SensorSample& sample);
+        void clear();
+        void setSource(int32_t odomType, bool estimator);
+        void setStartTime(uint64_t time){startTime = time;}
+
+        uint32_t size() const {return count;}
+        uint32_t getDropped() const {return dropped;}
+        int32_t getOdomType() const {return odomType;}
+        bool usedEstimator() const {return estimator;}
+        uint64_t getStartTime() const {return startTime;}
+        const SensorSample& operator[](uint32_t index) const {return samples[index];}
+
+        bool save(const char* filename) const;
+        bool load(const char* filename);
+};
@@ -0,0 +1,256 @@
+#pragma once
+// Generated by tools/trajgen from the routes folder, run make trajectories after editing a route
+#include "Trajectory.h"
+
+namespace trajectories {
+
+// auton4_park: 110.8 in, 2.43 s
+constexpr TrajectoryPoint auton4_park_points[] = {
+    {32.000, 34.500, 270.00, 0.00, 150.0, 0.00358},
+    {31.993, 34.500, 270.00, 1.50, 150.0, 0.00358},
+    {31.970, 34.500, 270.01, 3.00, 150.0, 0.00357},
+    {31.933, 34.500, 270.01, 4.50, 150.0, 0.00355},
+    {31.880, 34.500, 270.02, 6.00, 150.0, 0.00353},
+    {31.813, 34.500, 270.04, 7.50, 150.0, 0.00351},
+    {31.730, 34.500, 270.05, 9.00, 150.0, 0.00347},
+    {31.633, 34.500, 270.07, 10.50, 150.0, 0.00344},
+    {31.520, 34.500, 270.10, 12.00, 150.0, 0.00339},
+    {31.393, 34.501, 270.12, 13.50, 150.0, 0.00334},
+    {31.250, 34.501, 270.15, 15.00, 150.0, 0.00329},
+    {31.093, 34.501, 270.18, 16.50, 150.0, 0.00323},
+    {30.920, 34.502, 270.21, 18.00, 150.0, 0.00317},
+    {30.733, 34.503, 270.24, 19.50, 150.0, 0.00310},
+    {30.530, 34.504, 270.28, 21.00, 150.0, 0.00303},
+    {30.313, 34.505, 270.32, 22.50, 150.0, 0.00296},
+    {30.080, 34.506, 270.35, 24.00, 150.0, 0.00288},
+    {29.833, 34.508, 270.39, 25.50, 150.0, 0.00280},
+    {29.570, 34.510, 270.44, 27.00, 150.0, 0.00272},
+    {29.293, 34.512, 270.48, 28.50, 150.0, 0.00264},
+    {29.000, 34.514, 270.52, 30.00, 150.0, 0.00255},
+    {28.693, 34.517, 270.57, 31.50, 150.0, 0.00246},
+    {28.370, 34.521, 270.61, 33.00, 150.0, 0.00237},
+    {28.033, 34.524, 270.66, 34.50, 150.0, 0.00228},
+    {27.680, 34.529, 270.70, 36.00, 150.0, 0.00219},
+    {27.313, 34.533, 270.75, 37.50, 150.0, 0.00210},
+    {26.930, 34.538, 270.79, 39.00, 150.0, 0.00201},
+    {26.533, 34.544, 270.84, 40.50, 150.0, 0.00191},
+    {26.120, 34.550, 270.88, 42.00, 150.0, 0.00182},
+    {25.693, 34.557, 270.92, 43.50, 150.0, 0.00173},
+    {25.250, 34.564, 270.97, 45.00, 150.0, 0.00163},
+    {24.793, 34.572, 271.01, 46.50, 150.0, 0.00154},
+    {24.321, 34.581, 271.05, 48.00, 150.0, 0.00145},
+    {23.833, 34.590, 271.09, 49.50, 150.0, 0.00136},
+    {23.331, 34.599, 271.12, 51.00, 150.0, 0.00126},
+    {22.813, 34.610, 271.16, 52.50, 150.0, 0.00117},
+    {22.281, 34.621, 271.20, 54.00, 150.0, 0.00108},
+    {21.734, 34.632, 271.23, 55.50, 150.0, 0.00100},
+    {21.171, 34.644, 271.26, 57.00, 150.0, 0.00091},
+    {20.594, 34.657, 271.29, 58.50, 150.0, 0.00082},
+    {20.002, 34.671, 271.31, 59.74, 3.0, 0.00073},
+    {19.405, 34.684, 271.34, 59.77, 3.0, 0.00065},
+    {18.807, 34.699, 271.36, 59.80, 2.9, 0.00057},
+    {18.209, 34.713, 271.38, 59.82, 2.8, 0.00049},
+    {17.611, 34.727, 271.39, 59.85, 2.7, 0.00041},
+    {17.012, 34.742, 271.40, 59.88, 2.6, 0.00034},
+    {16.414, 34.757, 271.41, 59.90, 2.6, 0.00027},
+    {15.815, 34.771, 271.42, 59.93, 2.5, 0.00020},
+    {15.215, 34.786, 271.43, 59.95, 2.4, 0.00013},
+    {14.616, 34.801, 271.43, 59.98, 2.4, 0.00006},
+    {14.016, 34.816, 271.43, 60.00, -2.3, -0.00001},
+    {13.417, 34.831, 271.43, 59.97, -2.3, -0.00007},
+    {12.817, 34.846, 271.43, 59.95, -2.3, -0.00013},
+    {12.218, 34.861, 271.42, 59.93, -2.2, -0.00020},
+    {11.619, 34.876, 271.41, 59.91, -2.2, -0.00026},
+    {11.020, 34.891, 271.40, 59.89, -2.1, -0.00032},
+    {10.422, 34.905, 271.39, 59.87, -2.1, -0.00038},
+    {9.823, 34.920, 271.38, 59.84, -2.1, -0.00043},
+    {9.225, 34.934, 271.36, 59.82, -2.0, -0.00049},
+    {8.627, 34.948, 271.34, 59.80, -2.0, -0.00055},
+    {8.029, 34.962, 271.32, 59.78, -2.0, -0.00060},
+    {7.432, 34.976, 271.30, 59.76, -2.0, -0.00066},
+    {6.834, 34.989, 271.28, 59.74, -2.0, -0.00072},
+    {6.237, 35.002, 271.25, 59.72, -2.0, -0.00077},
+    {5.640, 35.015, 271.23, 59.70, -1.9, -0.00082},
+    {5.043, 35.028, 271.20, 59.69, -1.9, -0.00088},
+    {4.447, 35.040, 271.17, 59.67, -1.9, -0.00093},
+    {3.850, 35.052, 271.13, 59.65, -1.9, -0.00099},
+    {3.254, 35.064, 271.10, 59.63, -1.9, -0.00104},
+    {2.658, 35.075, 271.06, 59.61, -1.9, -0.00110},
+    {2.062, 35.086, 271.02, 59.59, -1.9, -0.00115},
+    {1.466, 35.097, 270.98, 59.57, -1.9, -0.00120},
+    {0.871, 35.107, 270.94, 59.55, -1.9, -0.00126},
+    {0.275, 35.116, 270.90, 59.53, -1.9, -0.00131},
+    {-0.320, 35.125, 270.85, 59.51, -1.9, -0.00137},
+    {-0.915, 35.134, 270.81, 59.49, -2.0, -0.00142},
+    {-1.509, 35.142, 270.76, 59.47, -2.0, -0.00148},
+    {-2.104, 35.149, 270.70, 59.45, -2.0, -0.00153},
+    {-2.698, 35.157, 270.65, 59.43, -2.0, -0.00159},
+    {-3.293, 35.163, 270.60, 59.41, -2.0, -0.00165},
+    {-3.887, 35.169, 270.54, 59.39, -2.0, -0.00171},
+    {-4.480, 35.174, 270.48, 59.37, -2.1, -0.00176},
+    {-5.074, 35.179, 270.42, 59.35, -2.1, -0.00182},
+    {-5.667, 35.183, 270.36, 59.33, -2.1, -0.00188},
+    {-6.261, 35.186, 270.29, 59.31, -2.1, -0.00194},
+    {-6.853, 35.189, 270.22, 59.29, -2.2, -0.00200},
+    {-7.446, 35.191, 270.15, 59.26, -2.2, -0.00207},
+    {-8.039, 35.192, 270.08, 59.24, -2.2, -0.00213},
+    {-8.631, 35.192, 270.01, 59.22, -2.3, -0.00220},
+    {-9.223, 35.192, 269.93, 59.20, -2.3, -0.00226},
+    {-9.815, 35.191, 269.86, 59.17, -2.4, -0.00233},
+    {-10.407, 35.189, 269.78, 59.15, -2.4, -0.00240},
+    {-10.998, 35.186, 269.69, 59.13, -2.5, -0.00247},
+    {-11.589, 35.183, 269.61, 59.10, -2.5, -0.00254},
+    {-12.180, 35.178, 269.52, 59.08, -2.6, -0.00261},
+    {-12.771, 35.173, 269.43, 59.05, -2.6, -0.00268},
+    {-13.361, 35.167, 269.34, 59.02, -2.7, -0.00276},
+    {-13.951, 35.159, 269.25, 59.00, -2.7, -0.00284},
+    {-14.541, 35.151, 269.15, 58.97, -2.8, -0.00291},
+    {-15.130, 35.142, 269.05, 58.94, -2.8, -0.00300},
+    {-15.719, 35.132, 268.95, 58.91, -2.9, -0.00308},
+    {-16.308, 35.120, 268.84, 58.88, -3.0, -0.00317},
+    {-16.897, 35.108, 268.73, 58.85, -3.1, -0.00325},
+    {-17.485, 35.094, 268.62, 58.82, -3.2, -0.00334},
+    {-18.073, 35.080, 268.51, 58.79, -3.2, -0.00344},
+    {-18.660, 35.064, 268.39, 58.76, -3.4, -0.00353},
+    {-19.248, 35.046, 268.27, 58.72, -3.4, -0.00363},
+    {-19.834, 35.028, 268.15, 58.69, -3.5, -0.00373},
+    {-20.421, 35.009, 268.02, 58.65, -3.7, -0.00384},
+    {-21.007, 34.988, 267.89, 58.61, -3.8, -0.00394},
+    {-21.592, 34.965, 267.75, 58.58, -3.9, -0.00405},
+    {-22.177, 34.942, 267.62, 58.54, -4.0, -0.00417},
+    {-22.762, 34.917, 267.47, 58.50, -4.1, -0.00429},
+    {-23.346, 34.890, 267.33, 58.45, -4.2, -0.00441},
+    {-23.930, 34.862, 267.18, 58.41, -4.4, -0.00454},
+    {-24.513, 34.833, 267.02, 58.36, -4.6, -0.00467},
+    {-25.095, 34.802, 266.87, 58.32, -4.7, -0.00481},
+    {-25.677, 34.769, 266.70, 58.27, -4.9, -0.00495},
+    {-26.259, 34.734, 266.54, 58.22, -5.1, -0.00509},
+    {-26.840, 34.698, 266.36, 58.17, -5.2, -0.00525},
+    {-27.420, 34.661, 266.19, 58.12, -5.5, -0.00540},
+    {-27.999, 34.621, 266.00, 58.06, -5.7, -0.00557},
+    {-28.578, 34.580, 265.82, 58.00, -5.8, -0.00574},
+    {-29.156, 34.536, 265.62, 57.94, -6.1, -0.00592},
+    {-29.734, 34.491, 265.42, 57.88, -6.4, -0.00610},
+    {-30.310, 34.444, 265.22, 57.82, -6.6, -0.00630},
+    {-30.886, 34.395, 265.01, 57.75, -6.9, -0.00650},
+    {-31.461, 34.343, 264.79, 57.68, -7.2, -0.00671},
+    {-32.035, 34.290, 264.56, 57.60, -7.5, -0.00693},
+    {-32.608, 34.234, 264.33, 57.53, -7.9, -0.00716},
+    {-33.180, 34.176, 264.09, 57.45, -8.2, -0.00740},
+    {-33.750, 34.116, 263.84, 57.36, -8.5, -0.00766},
+    {-34.320, 34.053, 263.59, 57.28, -8.8, -0.00792},
+    {-34.889, 33.988, 263.32, 57.19, -9.4, -0.00820},
+    {-35.456, 33.920, 263.05, 57.09, -9.8, -0.00849},
+    {-36.022, 33.850, 262.77, 56.99, -10.2, -0.00880},
+    {-36.587, 33.777, 262.47, 56.89, -10.8, -0.00912},
+    {-37.150, 33.701, 262.17, 56.78, -11.3, -0.00946},
+    {-37.712, 33.622, 261.86, 56.66, -11.8, -0.00982},
+    {-38.272, 33.540, 261.53, 56.54, -12.3, -0.01020},
+    {-38.830, 33.455, 261.20, 56.41, -13.2, -0.01060},
+    {-39.387, 33.367, 260.85, 56.28, -13.8, -0.01102},
+    {-39.941, 33.276, 260.49, 56.14, -14.4, -0.01147},
+    {-40.494, 33.182, 260.11, 55.99, -15.1, -0.01194},
+    {-41.044, 33.084, 259.72, 55.83, -16.2, -0.01244},
+    {-41.593, 32.982, 259.31, 55.67, -17.0, -0.01297},
+    {-42.138, 32.877, 258.89, 55.49, -17.8, -0.01354},
+    {-42.682, 32.769, 258.45, 55.31, -18.7, -0.01414},
+    {-43.222, 32.656, 257.99, 55.11, -20.2, -0.01478},
+    {-43.760, 32.539, 257.52, 54.91, -21.3, -0.01546},
+    {-44.294, 32.419, 257.02, 54.69, -22.4, -0.01618},
+    {-44.826, 32.294, 256.50, 54.46, -23.6, -0.01695},
+    {-45.353, 32.164, 255.96, 54.22, -24.8, -0.01778},
+    {-45.878, 32.031, 255.40, 53.96, -26.9, -0.01866},
+    {-46.398, 31.892, 254.81, 53.69, -28.4, -0.01960},
+    {-46.914, 31.749, 254.19, 53.40, -30.0, -0.02061},
+    {-47.425, 31.601, 253.55, 53.09, -31.6, -0.02170},
+    {-47.932, 31.448, 252.87, 52.76, -33.4, -0.02286},
+    {-48.433, 31.290, 252.16, 52.42, -35.3, -0.02411},
+    {-48.930, 31.127, 251.42, 52.05, -37.3, -0.02544},
+    {-49.420, 30.959, 250.65, 51.67, -39.4, -0.02688},
+    {-49.904, 30.785, 249.83, 51.26, -41.6, -0.02843},
+    {-50.382, 30.605, 248.98, 50.82, -44.0, -0.03009},
+    {-50.853, 30.420, 248.08, 50.37, -46.4, -0.03187},
+    {-51.317, 30.229, 247.14, 49.88, -48.9, -0.03380},
+    {-51.772, 30.033, 246.15, 49.38, -51.5, -0.03586},
+    {-52.220, 29.830, 245.11, 48.84, -54.1, -0.03808},
+    {-52.658, 29.621, 244.01, 48.28, -56.8, -0.04045},
+    {-53.087, 29.407, 242.87, 47.69, -59.5, -0.04300},
+    {-53.507, 29.186, 241.66, 47.08, -62.1, -0.04573},
+    {-53.916, 28.960, 240.40, 46.45, -64.6, -0.04864},
+    {-54.314, 28.727, 239.07, 45.79, -66.9, -0.05173},
+    {-54.701, 28.489, 237.68, 45.11, -68.9, -0.05501},
+    {-55.077, 28.245, 236.23, 44.42, -70.6, -0.05848},
+    {-55.440, 27.995, 234.71, 43.71, -71.2, -0.06213},
+    {-55.790, 27.740, 233.11, 42.99, -72.1, -0.06596},
+    {-56.127, 27.479, 231.46, 42.27, -72.2, -0.06993},
+    {-56.451, 27.214, 229.73, 41.55, -72.0, -0.07403},
+    {-56.761, 26.942, 227.93, 40.83, -70.9, -0.07824},
+    {-57.057, 26.666, 226.07, 40.13, -68.7, -0.08251},
+    {-57.339, 26.385, 224.14, 39.45, -67.2, -0.08680},
+    {-57.607, 26.100, 222.14, 38.80, -63.3, -0.09106},
+    {-57.860, 25.810, 220.09, 38.18, -60.9, -0.09523},
+    {-58.098, 25.516, 217.98, 37.61, -55.2, -0.09924},
+    {-58.323, 25.218, 215.82, 37.08, -51.8, -0.10304},
+    {-58.532, 24.914, 213.60, 36.61, -44.3, -0.10652},
+    {-58.728, 24.608, 211.35, 36.19, -40.1, -0.10967},
+    {-58.909, 24.296, 209.06, 35.84, -31.0, -0.11238},
+    {-59.076, 23.981, 206.74, 35.55, -26.2, -0.11462},
+    {-59.229, 23.662, 204.39, 35.34, -16.0, -0.11632},
+    {-59.368, 23.337, 202.03, 35.20, -10.7, -0.11744},
+    {-59.493, 23.009, 199.66, 35.13, -5.4, -0.11800},
+    {-59.604, 22.676, 197.28, 35.14, 5.4, -0.11788},
+    {-59.702, 22.338, 194.91, 35.23, 10.7, -0.11720},
+    {-59.785, 21.995, 192.55, 35.39, 21.2, -0.11591},
+    {-59.855, 21.647, 190.21, 35.62, 26.2, -0.11406},
+    {-59.912, 21.294, 187.90, 35.92, 35.7, -0.11171},
+    {-59.954, 20.935, 185.62, 36.30, 40.1, -0.10886},
+    {-59.983, 20.572, 183.37, 36.72, 44.3, -0.10564},
+    {-59.997, 20.202, 181.17, 37.22, 51.7, -0.10204},
+    {-60.028, 19.828, 188.84, 38.36, 150.0, -0.00293},
+    {-60.089, 19.441, 189.09, 39.86, 150.0, 0.00000},
+    {-60.154, 19.040, 189.09, 41.36, 150.0, 0.00000},
+    {-60.220, 18.625, 189.09, 42.86, 150.0, 0.00000},
+    {-60.289, 18.194, 189.09, 44.36, 150.0, 0.00000},
+    {-60.360, 17.748, 189.09, 45.86, 150.0, 0.00000},
+    {-60.434, 17.288, 189.09, 47.36, 150.0, 0.00000},
+    {-60.510, 16.813, 189.09, 48.86, 150.0, 0.00000},
+    {-60.588, 16.323, 189.09, 50.36, 150.0, 0.00000},
+    {-60.668, 15.823, 189.09, 50.29, -150.0, 0.00000},
+    {-60.747, 15.334, 189.09, 48.79, -150.0, 0.00000},
+    {-60.822, 14.860, 189.09, 47.29, -150.0, 0.00000},
+    {-60.896, 14.400, 189.09, 45.79, -150.0, 0.00000},
+    {-60.967, 13.955, 189.09, 44.29, -150.0, 0.00000},
+    {-61.036, 13.525, 189.09, 42.79, -150.0, 0.00000},
+    {-61.102, 13.110, 189.09, 41.29, -150.0, 0.00000},
+    {-61.166, 12.710, 189.09, 39.79, -150.0, 0.00000},
+    {-61.228, 12.325, 189.09, 38.29, -150.0, 0.00000},
+    {-61.287, 11.954, 189.09, 36.79, -150.0, 0.00000},
+    {-61.344, 11.598, 189.09, 35.29, -150.0, 0.00000},
+    {-61.399, 11.257, 189.09, 33.79, -150.0, 0.00000},
+    {-61.451, 10.931, 189.09, 32.29, -150.0, 0.00000},
+    {-61.501, 10.620, 189.09, 30.79, -150.0, 0.00000},
+    {-61.548, 10.323, 189.09, 29.29, -150.0, 0.00000},
+    {-61.593, 10.041, 189.09, 27.79, -150.0, 0.00000},
+    {-61.636, 9.774, 189.09, 26.29, -150.0, 0.00000},
+    {-61.676, 9.522, 189.09, 24.79, -150.0, 0.00000},
+    {-61.714, 9.285, 189.09, 23.29, -150.0, 0.00000},
+    {-61.750, 9.062, 189.09, 21.79, -150.0, 0.00000},
+    {-61.783, 8.855, 189.09, 20.29, -150.0, 0.00000},
+    {-61.814, 8.662, 189.09, 18.79, -150.0, 0.00000},
+    {-61.843, 8.484, 189.09, 17.29, -150.0, 0.00000},
+    {-61.869, 8.320, 189.09, 15.79, -150.0, 0.00000},
+    {-61.893, 8.172, 189.09, 14.29, -150.0, 0.00000},
+    {-61.914, 8.038, 189.09, 12.79, -150.0, 0.00000},
+    {-61.933, 7.919, 189.09, 11.29, -150.0, 0.00000},
+    {-61.950, 7.815, 189.09, 9.79, -150.0, 0.00000},
+    {-61.964, 7.726, 189.09, 8.29, -150.0, 0.00000},
+    {-61.976, 7.652, 189.09, 6.79, -150.0, 0.00000},
+    {-61.985, 7.592, 189.09, 5.29, -150.0, 0.00000},
+    {-61.992, 7.547, 189.09, 3.79, -150.0, 0.00000},
+    {-61.997, 7.517, 189.09, 2.29, -150.0, 0.00000},
+    {-62.000, 7.502, 189.09, 0.79, -150.0, 0.00000},
+    {-62.000, 7.500, 189.09, 0.00, -150.0, 0.00000},
+};
+constexpr Trajectory auton4_park = {auton4_park_points, 244, 0.010f};
+
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+/// @brief One 10 ms tick of a baked trajectory, generated by tools/trajgen
+struct TrajectoryPoint
+{
+    float x;            // inches
+    float y;            // inches
+    float heading;      // degrees, the way the robot faces
+    float velocity;     // in/s, negative when driving backwards
+    float acceleration; // in/s^2
+    float curvature;    // 1/in, positive curving clockwise
+};
+
+/// @brief A trajectory table compiled into the program
+struct Trajectory
+{
+    const TrajectoryPoint* points;
+    int length;
+    float dt;           // seconds between points
+
+    constexpr float duration() const {return length > 0 ? (length - 1) * dt : 0;}
+};
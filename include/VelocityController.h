@@ -0,0 +1,32 @@
+#pragma once
+#include "deltaTime.h"
+#include "MotionProfile.h"
+
+/// @brief Holds one side of the drive at a commanded speed. The feedforward
+/// supplies the voltage the model says the speed needs and a PI loop on the
+/// measured speed makes up whatever the model misses (load, friction, battery).
+/// Call compute once per motion loop cycle.
+class VelocityController
+{
+    private:
+        Feedforward feedforward;
+        float kP, kI;
+        float integralLimit;    // volts the integral term may add
+
+        DeltaTime deltaTime;
+        float integral;
+        float measured;         // filtered speed in in/s
+        float lastTarget;
+        bool firstSample;
+
+    public:
+        VelocityController();
+
+        void setFeedforward(const Feedforward& feedforward){this->feedforward = feedforward;}
+        void setGains(float kP, float kI, float integralLimit);
+
+        float compute(float target, float speed);
+        void reset();
+
+        float getMeasured(){return measured;}
+};
@@ -5,20 +5,22 @@ struct DeltaTime
 {
     private:
 
-        float preTime;
-
-        vex::brain clock;
+        uint64_t preTime;
 
     public:
 
-        DeltaTime() {preTime = 0; updateTime();}
+        DeltaTime() {reset();}
+
+        /// @brief Restarts the measurement from the current time
+        void reset() {preTime = vex::timer::systemHighResolution();}
 
         /// @brief Updates the time of the DeltaTime variable
-        /// @return Returns the difference in time passed since the last call
-        float updateTime() 
+        /// @return Returns the difference in time passed since the last call in milliseconds (microsecond resolution)
+        float updateTime()
         {
-            float time = clock.Timer.time() - preTime;
-            preTime = clock.Timer.time();
+            uint64_t now = vex::timer::systemHighResolution();
+            float time = (now - preTime) / 1000.0;
+            preTime = now;
             return time;
         }
 
@@ -27,4 +29,4 @@ struct DeltaTime
         bool operator==(float DELTATIME) {return updateTime() == DELTATIME;}
         bool operator==(double DELTATIME) {return updateTime() == DELTATIME;}
         bool operator==(int DELTATIME) {return updateTime() == DELTATIME;}
-};
\ No newline at end of file
+};
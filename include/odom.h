@@ -1,22 +1,41 @@
 #pragma once
 
 #include "util.h"
+#include "PoseSnapshot.h"
+#include "OdomProfile.h"
 
 class Odom
 {
     private:
-        //Variables to hold the degrees turned
-        float lateralDegrees;
-        float forwardDegreesR;
-        float forwardDegreesL;
+        //Raw sensor degrees at the last update, the deltas are scaled to inches once per update
+        double lateralDegrees;
+        double forwardDegreesR;
+        double forwardDegreesL;
 
         //Variables to store the current position and heading
-        float xPosition;
-        float yPosition;
-        float heading;
+        //Kept in double, a float stops resolving the 5 ms steps of a long run to better than a thousandth of an inch
+        double xPosition;
+        double yPosition;
+        double heading;
+
+        //Worked out from the diameters and pod angles by precompute() whenever they change
+        double forwardRightScale;   //inches per degree
+        double forwardLeftScale;
+        double lateralScale;
+        double leftPodSin, leftPodCos, rightPodSin, rightPodCos, podDeterminantInverse;
+        double podSpacingInverse;
+        void precompute();
+        void advance(double globalDeltaX, double globalDeltaY, double newHeading);
+
+        //Published copy of the pose for every other task to read
+        PoseSnapshot snapshot;
+
+        //Share of the gap to the inertial heading closed every update by the two vertical pod tracker,
+        //0 tracks the heading from the pods alone, 1 takes the inertial heading as it is
+        float gyroWeight = 0;
     
     public:
-        //Wheel diameters for the odometry pods
+        //Wheel diameters for the odometry pods, change them after construction through setProfile
         float forwardRightWheelDiameter;
         float forwardLeftWheelDiameter;
         float lateralWheelDiameter;
@@ -26,11 +45,10 @@ class Odom
         float forwardLeftRotationDistance;
         float lateralRotationDistance;
 
-        //Variables for two pods at 45
-        //In inches
-        float wheelDiameter45;
-        float leftRotationDistance;
-        float rightRotationDistance;
+        //Mounting angles of the two pods, degrees from forward toward the right
+        //The two pods at 45 use the forward left and right diameters and distances with these
+        float leftPodAngle = 0;
+        float rightPodAngle = 0;
 
         Odom();
         Odom(float forwardRightWheelDiameter, float forwardLeftWheelDiameter, float lateralWheelDiameter, float forwardRightRotationDistance, float forwardLeftRotationDistance, float lateralRotationDistance);
@@ -43,22 +61,29 @@ class Odom
         float getXPosition();
         float getYPosition();
         float getHeading();
+        Pose getPose();
+        uint32_t getUpdateCount();
 
-        float getLateralDegrees();
-        float getForwardRightDegrees();
-        float getForwardLeftDegrees();
+        double getLateralDegrees();
+        double getForwardRightDegrees();
+        double getForwardLeftDegrees();
 
         //Mutators
         void setPosition(float xPosition, float yPosition, float heading);
         void setHeading(float heading);
 
-        void setForwardRightDegrees(float forwardDegreesR);
-        void setForwardLeftDegrees(float forwardDegreesL);
-        void setLateralDegrees(float lateralDegrees);
+        void setForwardRightDegrees(double forwardDegreesR);
+        void setForwardLeftDegrees(double forwardDegreesL);
+        void setLateralDegrees(double lateralDegrees);
+        void setGyroWeight(float gyroWeight);
+        void setProfile(const OdomProfile& profile);
+        OdomProfile getProfile();
+        void setEstimate(const Pose& pose);
 
         //Updaters
-        void updatePositionTwoForward(float currentForwardRightPosition, float currentForwardLeftPosition, float currentLateralPosition);
-        void updatePositionOneForward(float currentForwardPosition, float currentLateralPosition, float headingGyro);
-        void updatePositionTwoAt45(float currentLeftDegrees, float currentRightDegrees, float headingGyro);
+        void updatePositionTwoForward(double currentForwardRightDegrees, double currentForwardLeftDegrees, double currentLateralDegrees);
+        void updatePositionOneForward(double currentForwardDegrees, double currentLateralDegrees, double headingGyro);
+        void updatePositionTwoAt45(double currentLeftDegrees, double currentRightDegrees, double headingGyro);
+        void updatePositionTwoVertical(double currentLeftDegrees, double currentRightDegrees, double headingGyro);
 
 };
\ No newline at end of file
@@ -0,0 +1,119 @@
+#pragma once
+
+// Host simulator core used by the vex:: stand-in.
+//
+// Time is virtual: every vex thread/task is a real OS thread, but only one of
+// them runs at a time (the V5 user processor is single core and cooperative),
+// and the clock only moves when every task is blocked in wait()/sleep. The
+// physics model is stepped up to the next wake-up time before that task runs,
+// so a run is deterministic and finishes as fast as the host can compute it.
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+
+namespace vexsim {
+
+////////////////////////////// Scheduler //////////////////////////////
+
+/// @brief Current simulated time in microseconds since program start
+uint64_t nowUs();
+
+/// @brief Blocks the calling task for the given simulated time, letting others run
+void sleepUs(uint64_t us);
+
+/// @brief Starts a new task
+/// @param body Function the task runs
+/// @param priority VEX task priority (higher runs first when tasks wake together)
+/// @return Id of the task, never 0
+int spawn(std::function<void()> body, int priority);
+
+/// @brief Id of the calling task
+int currentTask();
+
+bool isFinished(int id);
+void interrupt(int id);
+void setPriority(int id, int priority);
+int getPriority(int id);
+
+/// @brief Flushes output and terminates the whole simulation
+void finish(int exitCode);
+
+/////////////////////////////// Physics ///////////////////////////////
+
+/// @brief Field pose in inches and degrees, heading clockwise from +Y like the inertial sensor
+struct Pose
+{
+    double x;
+    double y;
+    double heading;
+};
+
+Pose truePose();
+void setTruePose(const Pose& pose);
+
+/// @brief Left and right wheel surface speeds in inches per second
+void trueWheelSpeeds(double& left, double& right);
+
+/// @brief Advances the physics model from its current time to the given time
+void physicsAdvanceTo(uint64_t timeUs);
+
+//////////////////////////////// Devices ////////////////////////////////
+
+enum MotorMode {MOTOR_STOPPED, MOTOR_VOLTAGE, MOTOR_VELOCITY};
+
+/// @brief Everything the simulator knows about one smart motor port
+struct MotorState
+{
+    MotorMode mode;
+    int brakeMode;          // vex::brakeType as int
+    double commandVolts;
+    double commandRpm;
+    double defaultVelocityPct;
+    double maxRpm;          // free speed of the cartridge
+    double shaftDeg;        // output shaft angle, sample-and-hold at the encoder rate
+    double liveShaftDeg;    // output shaft angle at the current physics step
+    double zeroDeg;
+    double holdDeg;
+    double rpm;
+    double volts;
+    double amps;
+    double velocityIntegral;
+    bool drive;             // part of the simulated drivetrain
+};
+
+MotorState& motorState(int port);
+
+/// @brief Raw (never reset) angle of a rotation sensor in degrees at its 5 ms sample
+double rotationRawDeg(int port);
+
+/// @brief True (unwrapped) inertial rotation in degrees at its last sample
+double inertialRawDeg();
+double inertialRateDps();
+
+/// @brief Pose the GPS sensor reports at its 20 ms sample, SIM_GPS_NOISE inches of noise on x and y
+Pose gpsPose();
+bool inertialCalibrating();
+void inertialStartCalibration();
+
+/////////////////////////////// Replay ///////////////////////////////
+
+/// @brief From now on the pods, inertial and drive encoders read the SensorLog named by
+/// SIM_REPLAY, lined up with the moment it started recording. The physics model
+/// keeps running on the robot's commands for everything else (velocities, GPS).
+/// Does nothing without SIM_REPLAY.
+void startReplay();
+
+/// @brief Prints how many samples were played and how far the drive's voltage
+/// commands were from the recorded ones
+void reportReplay();
+
+////////////////////////////// Environment //////////////////////////////
+
+/// @brief Reads a numeric SIM_* environment variable, or the fallback if unset
+double envNumber(const char* name, double fallback);
+
+/// @brief Reads a string SIM_* environment variable, or the fallback if unset
+std::string envString(const char* name, const std::string& fallback);
+
+} // namespace vexsim
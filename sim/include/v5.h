@@ -0,0 +1,21 @@
+#pragma once
+
+// Host stand-in for the VEX SDK C header.
+// Only the handful of system calls the robot code touches are provided,
+// everything else comes from the class API in v5_vcs.h.
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @brief Simulated system time in milliseconds
+uint32_t vexSystemTimeGet(void);
+
+/// @brief Simulated system time in microseconds
+uint64_t vexSystemHighResTimeGet(void);
+
+#ifdef __cplusplus
+}
+#endif
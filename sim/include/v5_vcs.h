@@ -0,0 +1,563 @@
+#pragma once
+
+// Host stand-in for the VEX SDK class API (vex::).
+// Implements the subset of the V5 API used by this project on top of the
+// simulator in sim.h so the robot sources in src/ build and run on Linux.
+// Devices are handles to per-port state, the same way they are on the brain,
+// so copies of a motor or sensor all see the same hardware.
+
+#include <stdint.h>
+#include <string>
+
+namespace vex {
+
+////////////////////////////// Units //////////////////////////////
+
+enum class timeUnits { sec, msec };
+enum class rotationUnits { deg, rev, raw };
+enum class velocityUnits { pct, rpm, dps };
+enum class voltageUnits { volt, mV };
+enum class percentUnits { pct };
+enum class currentUnits { amp };
+enum class torqueUnits { Nm, InLb };
+enum class temperatureUnits { celsius, fahrenheit };
+enum class directionType { fwd, rev, undefined };
+enum class brakeType { coast, brake, hold, undefined };
+enum class gearSetting { ratio36_1, ratio18_1, ratio6_1 };
+enum class turnType { left, right };
+enum class axisType { xaxis, yaxis, zaxis };
+enum class distanceUnits { mm, in, cm };
+enum class ledState { off, on };
+enum fontType { mono12, mono15, mono20, mono30, mono40, mono60, prop20, prop30, prop40, prop60 };
+
+const timeUnits sec = timeUnits::sec;
+const timeUnits seconds = timeUnits::sec;
+const timeUnits msec = timeUnits::msec;
+
+const rotationUnits deg = rotationUnits::deg;
+const rotationUnits degrees = rotationUnits::deg;
+const rotationUnits rev = rotationUnits::rev;
+const rotationUnits turns = rotationUnits::rev;
+
+const velocityUnits rpm = velocityUnits::rpm;
+const velocityUnits dps = velocityUnits::dps;
+
+const voltageUnits volt = voltageUnits::volt;
+const voltageUnits voltage = voltageUnits::volt;
+
+const percentUnits pct = percentUnits::pct;
+const percentUnits percent = percentUnits::pct;
+
+const directionType fwd = directionType::fwd;
+const directionType forward = directionType::fwd;
+const directionType reverse = directionType::rev;
+
+const brakeType coast = brakeType::coast;
+const brakeType brake = brakeType::brake;
+const brakeType hold = brakeType::hold;
+
+const gearSetting ratio36_1 = gearSetting::ratio36_1;
+const gearSetting ratio18_1 = gearSetting::ratio18_1;
+const gearSetting ratio6_1 = gearSetting::ratio6_1;
+
+const turnType left = turnType::left;
+const turnType right = turnType::right;
+
+const axisType xaxis = axisType::xaxis;
+const axisType yaxis = axisType::yaxis;
+const axisType zaxis = axisType::zaxis;
+
+const distanceUnits mm = distanceUnits::mm;
+const distanceUnits inches = distanceUnits::in;
+const distanceUnits cm = distanceUnits::cm;
+
+const int32_t PORT1 = 0;   const int32_t PORT2 = 1;   const int32_t PORT3 = 2;
+const int32_t PORT4 = 3;   const int32_t PORT5 = 4;   const int32_t PORT6 = 5;
+const int32_t PORT7 = 6;   const int32_t PORT8 = 7;   const int32_t PORT9 = 8;
+const int32_t PORT10 = 9;  const int32_t PORT11 = 10; const int32_t PORT12 = 11;
+const int32_t PORT13 = 12; const int32_t PORT14 = 13; const int32_t PORT15 = 14;
+const int32_t PORT16 = 15; const int32_t PORT17 = 16; const int32_t PORT18 = 17;
+const int32_t PORT19 = 18; const int32_t PORT20 = 19; const int32_t PORT21 = 20;
+const int32_t PORT22 = 21;
+
+////////////////////////////// Color //////////////////////////////
+
+class color
+{
+    private:
+        uint32_t rgb;
+        bool transparent;
+
+    public:
+        color() : rgb(0), transparent(false) {}
+        color(int value) : rgb((uint32_t)value & 0xffffff), transparent(false) {}
+        color(int r, int g, int b) : rgb(((r & 0xff) << 16) | ((g & 0xff) << 8) | (b & 0xff)), transparent(false) {}
+        color(const char* hex);
+
+        uint32_t rgbValue() const { return rgb; }
+        bool isTransparent() const { return transparent; }
+
+        bool operator==(const color& other) const { return rgb == other.rgb && transparent == other.transparent; }
+        bool operator!=(const color& other) const { return !(*this == other); }
+
+        static const color black, white, red, green, blue, yellow, orange, purple, cyan, transparent_;
+};
+
+///////////////////////////// Timing /////////////////////////////
+
+void wait(double time, timeUnits units);
+void sleepMs(uint32_t time);
+
+class timer
+{
+    private:
+        uint64_t startUs;
+
+    public:
+        timer();
+
+        double time(timeUnits units = msec) const;
+        double value() const { return time(sec); }
+        void clear();
+        void reset() { clear(); }
+
+        static uint32_t system();
+        static uint64_t systemHighResolution();
+};
+
+//////////////////////////// Threading ////////////////////////////
+
+class thread
+{
+    private:
+        int id;
+
+    public:
+        thread() : id(0) {}
+        thread(void (*callback)(void));
+        thread(int (*callback)(void));
+        thread(void (*callback)(void*), void* arg);
+        thread(int (*callback)(void*), void* arg);
+
+        thread(const thread&) = delete;
+        thread& operator=(const thread&) = delete;
+        thread(thread&& other) : id(other.id) { other.id = 0; }
+        thread& operator=(thread&& other);
+        ~thread() {}
+
+        int get_id() const { return id; }
+        bool joinable() const { return id != 0; }
+        void join();
+        void detach() { id = 0; }
+        void interrupt();
+        void setPriority(int32_t priority);
+
+        static int32_t hardware_concurrency() { return 1; }
+
+        static const int32_t threadPrioritylow = 1;
+        static const int32_t threadPriorityNormal = 7;
+        static const int32_t threadPriorityHigh = 15;
+};
+
+class task
+{
+    private:
+        int id;
+
+    public:
+        task() : id(0) {}
+        task(int (*callback)(void));
+        task(int (*callback)(void), int32_t priority);
+        task(int (*callback)(void*), void* arg);
+        task(int (*callback)(void*), void* arg, int32_t priority);
+
+        void stop();
+        void suspend();
+        void resume();
+        int32_t priority();
+        void setPriority(int32_t priority);
+
+        static void sleep(uint32_t time);
+        static void yield();
+
+        static const int32_t taskPriorityLow = 1;
+        static const int32_t taskPriorityNormal = 7;
+        static const int32_t taskPriorityHigh = 15;
+};
+
+namespace this_thread {
+    void sleep_for(uint32_t time);
+    void yield();
+    int32_t get_id();
+}
+
+/// @brief Cooperative scheduler mutex. Only one task ever runs at a time in the
+/// simulator, so locking just has to wait for the current owner to release it.
+class mutex
+{
+    private:
+        int owner;
+
+    public:
+        mutex() : owner(0) {}
+        void lock();
+        bool try_lock();
+        void unlock();
+};
+
+///////////////////////////// Devices /////////////////////////////
+
+class motor
+{
+    private:
+        int32_t port;
+        bool reversed;
+        gearSetting gears;
+
+    public:
+        motor(int32_t index);
+        motor(int32_t index, bool reverse);
+        motor(int32_t index, gearSetting gears);
+        motor(int32_t index, gearSetting gears, bool reverse);
+
+        int32_t index() const { return port; }
+        bool installed() const { return true; }
+
+        void setReversed(bool value);
+        void setVelocity(double velocity, velocityUnits units);
+        void setVelocity(double velocity, percentUnits units);
+        void setStopping(brakeType mode);
+        void setBrake(brakeType mode) { setStopping(mode); }
+        void setMaxTorque(double value, percentUnits units);
+        void setTimeout(int32_t time, timeUnits units) {}
+
+        void spin(directionType dir);
+        void spin(directionType dir, double velocity, velocityUnits units);
+        void spin(directionType dir, double velocity, percentUnits units);
+        void spin(directionType dir, double voltage, voltageUnits units);
+
+        void stop();
+        void stop(brakeType mode);
+
+        void resetPosition();
+        void resetRotation() { resetPosition(); }
+        void setPosition(double value, rotationUnits units);
+        double position(rotationUnits units);
+        double rotation(rotationUnits units) { return position(units); }
+        double velocity(velocityUnits units);
+        double velocity(percentUnits units);
+        double current(currentUnits units = currentUnits::amp);
+        double voltage(voltageUnits units = voltageUnits::volt);
+        double torque(torqueUnits units = torqueUnits::Nm);
+        double temperature(temperatureUnits units = temperatureUnits::celsius) { return 25; }
+        bool isSpinning();
+        bool isDone() { return true; }
+};
+
+class motor_group
+{
+    private:
+        static const int MAX_MOTORS = 8;
+        motor* motors[MAX_MOTORS];
+        int32_t motorCount;
+
+        void add(motor& m);
+        void addAll() {}
+        template <typename... Args>
+        void addAll(motor& m, Args&... rest) { add(m); addAll(rest...); }
+
+    public:
+        motor_group() : motorCount(0) {}
+        template <typename... Args>
+        motor_group(motor& m1, Args&... rest) : motorCount(0) { addAll(m1, rest...); }
+        motor_group(const motor_group& other);
+        motor_group& operator=(const motor_group& other);
+        ~motor_group();
+
+        int32_t count() const { return motorCount; }
+
+        void setVelocity(double velocity, velocityUnits units);
+        void setVelocity(double velocity, percentUnits units);
+        void setStopping(brakeType mode);
+        void setMaxTorque(double value, percentUnits units);
+        void setTimeout(int32_t time, timeUnits units) {}
+
+        void spin(directionType dir);
+        void spin(directionType dir, double velocity, velocityUnits units);
+        void spin(directionType dir, double velocity, percentUnits units);
+        void spin(directionType dir, double voltage, voltageUnits units);
+
+        void stop();
+        void stop(brakeType mode);
+
+        void resetPosition();
+        void resetRotation() { resetPosition(); }
+        void setPosition(double value, rotationUnits units);
+        double position(rotationUnits units);
+        double velocity(velocityUnits units);
+        double velocity(percentUnits units);
+        double current(currentUnits units = currentUnits::amp);
+        double voltage(voltageUnits units = voltageUnits::volt);
+        bool isSpinning();
+        bool isDone() { return true; }
+};
+
+class rotation
+{
+    private:
+        int32_t port;
+        bool reversed;
+
+    public:
+        rotation(int32_t index, bool reverse = false);
+
+        int32_t index() const { return port; }
+        bool installed() const { return true; }
+
+        void setReversed(bool value) { reversed = value; }
+        void resetPosition();
+        void setPosition(double value, rotationUnits units);
+        double position(rotationUnits units);
+        double angle(rotationUnits units = degrees);
+        double velocity(velocityUnits units);
+        void setDataRate(uint32_t rate) {}
+};
+
+class inertial
+{
+    private:
+        int32_t port;
+
+    public:
+        inertial(int32_t index, turnType dir = right);
+
+        int32_t index() const { return port; }
+        bool installed() const { return true; }
+
+        void calibrate();
+        void startCalibration() { calibrate(); }
+        bool isCalibrating();
+
+        void resetHeading();
+        void resetRotation();
+        void setHeading(double value, rotationUnits units);
+        void setRotation(double value, rotationUnits units);
+
+        double heading(rotationUnits units = degrees);
+        double rotation(rotationUnits units = degrees);
+        double angle(rotationUnits units = degrees) { return heading(units); }
+        double gyroRate(axisType axis, velocityUnits units);
+        double acceleration(axisType axis);
+        void setDataRate(uint32_t rate) {}
+};
+
+/// @brief GPS sensor, reads the simulated robot's true pose in the SIM_START frame with SIM_GPS_NOISE
+class gps
+{
+    private:
+        int32_t port;
+
+    public:
+        gps(int32_t index, double headingOffset = 0, turnType dir = right) : port(index) {}
+
+        int32_t index() const { return port; }
+        bool installed() const { return true; }
+
+        void calibrate() {}
+        bool isCalibrating() { return false; }
+
+        double xPosition(distanceUnits units = distanceUnits::mm);
+        double yPosition(distanceUnits units = distanceUnits::mm);
+        double heading(rotationUnits units = degrees);
+        int32_t quality() { return 100; }
+};
+
+class optical
+{
+    private:
+        int32_t port;
+        ledState light;
+
+    public:
+        optical(int32_t index) : port(index), light(ledState::off) {}
+
+        bool installed() const { return true; }
+        void setLight(ledState state) { light = state; }
+        void setLightPower(double value, percentUnits units) {}
+        void integrationTime(double time) {}
+        vex::color color() { return vex::color(); }
+        double hue() { return 0; }
+        double brightness() { return 0; }
+        bool isNearObject() { return false; }
+};
+
+class vision
+{
+    public:
+        class signature
+        {
+            public:
+                signature() {}
+        };
+        class code
+        {
+            public:
+                code() {}
+        };
+};
+
+class triport
+{
+    public:
+        class port
+        {
+            private:
+                int32_t id;
+
+            public:
+                port(int32_t id = 0) : id(id) {}
+                int32_t index() const { return id; }
+        };
+
+        port A, B, C, D, E, F, G, H;
+
+        triport() : A(0), B(1), C(2), D(3), E(4), F(5), G(6), H(7) {}
+};
+
+class digital_out
+{
+    private:
+        bool state;
+
+    public:
+        digital_out(triport::port& port) : state(false) {}
+
+        void set(bool value) { state = value; }
+        int32_t value() { return state; }
+        digital_out& operator=(bool value) { set(value); return *this; }
+};
+
+class digital_in
+{
+    public:
+        digital_in(triport::port& port) {}
+        int32_t value() { return 0; }
+};
+
+////////////////////////// Brain & Controller //////////////////////////
+
+class brain
+{
+    public:
+        class lcd
+        {
+            public:
+                void clearScreen() {}
+                void clearScreen(const color& c) {}
+                void clearLine() {}
+                void clearLine(int32_t row) {}
+                void newLine() {}
+                void setCursor(int32_t row, int32_t col) {}
+                void setFont(fontType font) {}
+                void setPenColor(const color& c) {}
+                void setPenColor(const char* hex) {}
+                void setPenWidth(uint32_t width) {}
+                void setFillColor(const color& c) {}
+                void setFillColor(const char* hex) {}
+                void drawPixel(int x, int y) {}
+                void drawLine(int x1, int y1, int x2, int y2) {}
+                void drawRectangle(int x, int y, int width, int height) {}
+                void drawRectangle(int x, int y, int width, int height, const color& c) {}
+                void drawCircle(int x, int y, int radius) {}
+                void print(const char* format, ...) {}
+                void print(int value) {}
+                void print(long value) {}
+                void print(double value) {}
+                void printAt(int32_t x, int32_t y, const char* format, ...) {}
+                void render() {}
+
+                bool pressing() { return false; }
+                int32_t xPosition() { return 0; }
+                int32_t yPosition() { return 0; }
+                void pressed(void (*callback)(void)) {}
+                void released(void (*callback)(void)) {}
+        };
+
+        class battery
+        {
+            public:
+                double voltage(voltageUnits units = voltageUnits::volt) { return 12.6; }
+                uint32_t capacity(percentUnits units = percentUnits::pct) { return 100; }
+        };
+
+        lcd Screen;
+        timer Timer;
+        triport ThreeWirePort;
+        battery Battery;
+
+        brain() {}
+};
+
+enum class controllerType { primary, partner };
+
+class controller
+{
+    public:
+        class axis
+        {
+            public:
+                int32_t position(percentUnits units = percent) { return 0; }
+                int32_t value() { return 0; }
+                void changed(void (*callback)(void)) {}
+        };
+
+        class button
+        {
+            public:
+                bool pressing() { return false; }
+                void pressed(void (*callback)(void)) {}
+                void released(void (*callback)(void)) {}
+        };
+
+        class lcd
+        {
+            public:
+                void print(const char* format, ...) {}
+                void print(int value) {}
+                void print(double value) {}
+                void setCursor(int32_t row, int32_t col) {}
+                void clearScreen() {}
+                void clearLine() {}
+                void clearLine(int32_t row) {}
+                void newLine() {}
+        };
+
+        axis Axis1, Axis2, Axis3, Axis4;
+        button ButtonL1, ButtonL2, ButtonR1, ButtonR2;
+        button ButtonUp, ButtonDown, ButtonLeft, ButtonRight;
+        button ButtonX, ButtonB, ButtonY, ButtonA;
+        lcd Screen;
+
+        controller(controllerType type = controllerType::primary) {}
+        void rumble(const char* pattern) {}
+};
+
+/// @brief Field control stand-in. The simulator starts the registered
+/// autonomous callback after the pre-auton window and ends the run when it
+/// returns or the period expires, see sim.h.
+class competition
+{
+    public:
+        competition() {}
+
+        void autonomous(void (*callback)(void));
+        void drivercontrol(void (*callback)(void));
+
+        bool isAutonomous();
+        bool isDriverControl();
+        bool isEnabled();
+        bool isCompetitionSwitch() { return false; }
+        bool isFieldControl() { return true; }
+};
+
+} // namespace vex
@@ -0,0 +1,43 @@
+# Host simulation build
+#
+#   make sim        builds build-sim/<project>-sim for Linux
+#   make run-sim    builds and runs the autonomous routine headless
+#
+# The robot sources are compiled unchanged against the vex:: stand-in in
+# sim/include, which replaces the SDK's v5.h and v5_vcs.h.
+# Runtime options are SIM_* environment variables, see sim/include/sim.h.
+
+SIM_BUILD  = build-sim
+HOST_CXX  ?= g++
+
+SIM_SRC    = $(wildcard sim/src/*.cpp)
+SIM_H      = $(wildcard sim/include/*.h)
+
+# robot-config is linked first so the device globals are constructed before
+# the globals that copy them (the Drive chassis in main.cpp), matching the brain
+SIM_SRC_C  = $(filter src/robot-config.cpp, $(SRC_C)) $(filter-out src/robot-config.cpp, $(SRC_C))
+SIM_OBJ    = $(addprefix $(SIM_BUILD)/, $(addsuffix .o, $(basename $(SIM_SRC_C) $(SIM_SRC))) )
+SIM_INC    = -Isim/include $(addprefix -I, ${INC_F})
+SIM_FLAGS  = -std=gnu++11 -O2 -g -Wall -Werror=return-type -pthread -DVEX_SIM
+
+SIM_EXE    = $(SIM_BUILD)/$(PROJECT)-sim
+
+# compile C++ files for the host
+$(SIM_BUILD)/%.o: %.cpp $(SRC_H) $(SIM_H) $(SRC_A) sim/mksim.mk
+	$(Q)$(MKDIR)
+	$(ECHO) "SIM $<"
+	$(Q)$(HOST_CXX) $(SIM_FLAGS) $(SIM_INC) -c -o $@ $<
+
+$(SIM_EXE): $(SIM_OBJ)
+	$(ECHO) "LINK $@"
+	$(Q)$(HOST_CXX) $(SIM_FLAGS) -o $@ $^
+
+sim: $(SIM_EXE)
+
+run-sim: $(SIM_EXE)
+	$(Q)./$(SIM_EXE)
+
+clean-sim:
+	$(Q)$(RMDIR) $(SIM_BUILD)
+
+.PHONY: sim run-sim clean-sim
@@ -0,0 +1,597 @@
+#include "v5.h"
+#include "v5_vcs.h"
+#include "sim.h"
+
+#include <cmath>
+#include <cstdlib>
+
+using vexsim::MotorState;
+
+extern "C" uint32_t vexSystemTimeGet(void)
+{
+    return (uint32_t)(vexsim::nowUs() / 1000);
+}
+
+extern "C" uint64_t vexSystemHighResTimeGet(void)
+{
+    return vexsim::nowUs();
+}
+
+namespace vex {
+
+////////////////////////////// Color //////////////////////////////
+
+const color color::black(0x000000);
+const color color::white(0xffffff);
+const color color::red(0xff0000);
+const color color::green(0x00ff00);
+const color color::blue(0x0000ff);
+const color color::yellow(0xffff00);
+const color color::orange(0xffa500);
+const color color::purple(0xff00ff);
+const color color::cyan(0x00ffff);
+const color color::transparent_(0x000000);
+
+color::color(const char* hex) : rgb(0), transparent(false)
+{
+    if(hex && *hex == '#')
+        hex++;
+    if(hex)
+        rgb = (uint32_t)std::strtoul(hex, nullptr, 16) & 0xffffff;
+}
+
+///////////////////////////// Timing /////////////////////////////
+
+void wait(double time, timeUnits units)
+{
+    double us = units == timeUnits::sec ? time * 1e6 : time * 1e3;
+    vexsim::sleepUs(us > 0 ? (uint64_t)std::llround(us) : 0);
+}
+
+void sleepMs(uint32_t time)
+{
+    vexsim::sleepUs((uint64_t)time * 1000);
+}
+
+timer::timer() : startUs(vexsim::nowUs()) {}
+
+double timer::time(timeUnits units) const
+{
+    double elapsed = (double)(vexsim::nowUs() - startUs);
+    return units == timeUnits::sec ? elapsed / 1e6 : elapsed / 1e3;
+}
+
+void timer::clear()
+{
+    startUs = vexsim::nowUs();
+}
+
+uint32_t timer::system()
+{
+    return (uint32_t)(vexsim::nowUs() / 1000);
+}
+
+uint64_t timer::systemHighResolution()
+{
+    return vexsim::nowUs();
+}
+
+//////////////////////////// Threading ////////////////////////////
+
+thread::thread(void (*callback)(void)) : id(vexsim::spawn(callback, threadPriorityNormal)) {}
+thread::thread(int (*callback)(void)) : id(vexsim::spawn([callback]{ callback(); }, threadPriorityNormal)) {}
+thread::thread(void (*callback)(void*), void* arg) : id(vexsim::spawn([callback, arg]{ callback(arg); }, threadPriorityNormal)) {}
+thread::thread(int (*callback)(void*), void* arg) : id(vexsim::spawn([callback, arg]{ callback(arg); }, threadPriorityNormal)) {}
+
+thread& thread::operator=(thread&& other)
+{
+    id = other.id;
+    other.id = 0;
+    return *this;
+}
+
+void thread::join()
+{
+    while(id != 0 && !vexsim::isFinished(id))
+        vexsim::sleepUs(1000);
+    id = 0;
+}
+
+void thread::interrupt()
+{
+    if(id != 0)
+        vexsim::interrupt(id);
+}
+
+void thread::setPriority(int32_t priority)
+{
+    if(id != 0)
+        vexsim::setPriority(id, priority);
+}
+
+task::task(int (*callback)(void)) : id(vexsim::spawn([callback]{ callback(); }, taskPriorityNormal)) {}
+task::task(int (*callback)(void), int32_t priority) : id(vexsim::spawn([callback]{ callback(); }, priority)) {}
+task::task(int (*callback)(void*), void* arg) : id(vexsim::spawn([callback, arg]{ callback(arg); }, taskPriorityNormal)) {}
+task::task(int (*callback)(void*), void* arg, int32_t priority) : id(vexsim::spawn([callback, arg]{ callback(arg); }, priority)) {}
+
+void task::stop()
+{
+    if(id != 0)
+        vexsim::interrupt(id);
+    id = 0;
+}
+
+void task::suspend() {}
+void task::resume() {}
+
+int32_t task::priority()
+{
+    return vexsim::getPriority(id);
+}
+
+void task::setPriority(int32_t priority)
+{
+    vexsim::setPriority(id, priority);
+}
+
+void task::sleep(uint32_t time)
+{
+    vexsim::sleepUs((uint64_t)time * 1000);
+}
+
+// Simulated time only moves when a task sleeps, a yield takes this long so a
+// task spinning on the clock gets to its time
+static const uint64_t YIELD_US = 10;
+
+void task::yield()
+{
+    vexsim::sleepUs(YIELD_US);
+}
+
+void this_thread::sleep_for(uint32_t time)
+{
+    vexsim::sleepUs((uint64_t)time * 1000);
+}
+
+void this_thread::yield()
+{
+    vexsim::sleepUs(YIELD_US);
+}
+
+int32_t this_thread::get_id()
+{
+    return vexsim::currentTask();
+}
+
+void mutex::lock()
+{
+    int me = vexsim::currentTask();
+    while(owner != 0 && owner != me)
+        vexsim::sleepUs(0);
+    owner = me;
+}
+
+bool mutex::try_lock()
+{
+    int me = vexsim::currentTask();
+    if(owner != 0 && owner != me)
+        return false;
+    owner = me;
+    return true;
+}
+
+void mutex::unlock()
+{
+    owner = 0;
+}
+
+////////////////////////////// Motors //////////////////////////////
+
+namespace {
+
+double maxRpmFor(gearSetting gears)
+{
+    switch(gears)
+    {
+        case gearSetting::ratio36_1: return 100;
+        case gearSetting::ratio6_1: return 600;
+        case gearSetting::ratio18_1:
+        default: return 200;
+    }
+}
+
+double toRpm(MotorState& m, double velocity, velocityUnits units)
+{
+    switch(units)
+    {
+        case velocityUnits::pct: return velocity / 100.0 * m.maxRpm;
+        case velocityUnits::dps: return velocity / 6.0;
+        case velocityUnits::rpm:
+        default: return velocity;
+    }
+}
+
+double fromRpm(MotorState& m, double rpm, velocityUnits units)
+{
+    switch(units)
+    {
+        case velocityUnits::pct: return rpm / m.maxRpm * 100.0;
+        case velocityUnits::dps: return rpm * 6.0;
+        case velocityUnits::rpm:
+        default: return rpm;
+    }
+}
+
+double fromDegrees(double value, rotationUnits units)
+{
+    switch(units)
+    {
+        case rotationUnits::rev: return value / 360.0;
+        case rotationUnits::raw: return value;
+        case rotationUnits::deg:
+        default: return value;
+    }
+}
+
+double toDegrees(double value, rotationUnits units)
+{
+    return units == rotationUnits::rev ? value * 360.0 : value;
+}
+
+double sign(directionType dir)
+{
+    return dir == directionType::rev ? -1.0 : 1.0;
+}
+
+} // namespace
+
+motor::motor(int32_t index) : port(index), reversed(false), gears(gearSetting::ratio18_1)
+{
+    vexsim::motorState(port).maxRpm = maxRpmFor(gears);
+}
+
+motor::motor(int32_t index, bool reverse) : port(index), reversed(reverse), gears(gearSetting::ratio18_1)
+{
+    vexsim::motorState(port).maxRpm = maxRpmFor(gears);
+}
+
+motor::motor(int32_t index, gearSetting gears) : port(index), reversed(false), gears(gears)
+{
+    vexsim::motorState(port).maxRpm = maxRpmFor(gears);
+}
+
+motor::motor(int32_t index, gearSetting gears, bool reverse) : port(index), reversed(reverse), gears(gears)
+{
+    vexsim::motorState(port).maxRpm = maxRpmFor(gears);
+}
+
+// Drivetrain motors are wired so that "forward" always pushes the robot
+// forward, the reversed flag only exists to make that true on the real robot.
+void motor::setReversed(bool value) { reversed = value; }
+
+void motor::setVelocity(double velocity, velocityUnits units)
+{
+    MotorState& m = vexsim::motorState(port);
+    m.defaultVelocityPct = toRpm(m, velocity, units) / m.maxRpm * 100.0;
+}
+
+void motor::setVelocity(double velocity, percentUnits units)
+{
+    vexsim::motorState(port).defaultVelocityPct = velocity;
+}
+
+void motor::setStopping(brakeType mode)
+{
+    vexsim::motorState(port).brakeMode = (int)mode;
+}
+
+void motor::setMaxTorque(double value, percentUnits units) {}
+
+void motor::spin(directionType dir)
+{
+    MotorState& m = vexsim::motorState(port);
+    spin(dir, m.defaultVelocityPct, velocityUnits::pct);
+}
+
+void motor::spin(directionType dir, double velocity, velocityUnits units)
+{
+    MotorState& m = vexsim::motorState(port);
+    if(m.mode != vexsim::MOTOR_VELOCITY)
+        m.velocityIntegral = 0;
+    m.mode = vexsim::MOTOR_VELOCITY;
+    m.commandRpm = sign(dir) * toRpm(m, velocity, units);
+}
+
+void motor::spin(directionType dir, double velocity, percentUnits units)
+{
+    spin(dir, velocity, velocityUnits::pct);
+}
+
+void motor::spin(directionType dir, double voltage, voltageUnits units)
+{
+    MotorState& m = vexsim::motorState(port);
+    m.mode = vexsim::MOTOR_VOLTAGE;
+    m.commandVolts = sign(dir) * (units == voltageUnits::mV ? voltage / 1000.0 : voltage);
+}
+
+void motor::stop()
+{
+    MotorState& m = vexsim::motorState(port);
+    stop((brakeType)m.brakeMode);
+}
+
+void motor::stop(brakeType mode)
+{
+    MotorState& m = vexsim::motorState(port);
+    m.mode = vexsim::MOTOR_STOPPED;
+    m.brakeMode = (int)mode;
+    m.holdDeg = m.liveShaftDeg;
+}
+
+void motor::resetPosition()
+{
+    MotorState& m = vexsim::motorState(port);
+    m.zeroDeg = m.shaftDeg;
+}
+
+void motor::setPosition(double value, rotationUnits units)
+{
+    MotorState& m = vexsim::motorState(port);
+    m.zeroDeg = m.shaftDeg - toDegrees(value, units);
+}
+
+double motor::position(rotationUnits units)
+{
+    MotorState& m = vexsim::motorState(port);
+    return fromDegrees(m.shaftDeg - m.zeroDeg, units);
+}
+
+double motor::velocity(velocityUnits units)
+{
+    MotorState& m = vexsim::motorState(port);
+    return fromRpm(m, m.rpm, units);
+}
+
+double motor::velocity(percentUnits units)
+{
+    return velocity(velocityUnits::pct);
+}
+
+double motor::current(currentUnits units)
+{
+    return std::fabs(vexsim::motorState(port).amps);
+}
+
+double motor::voltage(voltageUnits units)
+{
+    double volts = vexsim::motorState(port).volts;
+    return units == voltageUnits::mV ? volts * 1000.0 : volts;
+}
+
+double motor::torque(torqueUnits units)
+{
+    MotorState& m = vexsim::motorState(port);
+    double nm = m.amps * 0.35 * 600.0 / m.maxRpm / 2.5;
+    return units == torqueUnits::InLb ? nm * 8.851 : nm;
+}
+
+bool motor::isSpinning()
+{
+    return std::fabs(vexsim::motorState(port).rpm) > 1.0;
+}
+
+/////////////////////////// Motor groups ///////////////////////////
+
+void motor_group::add(motor& m)
+{
+    if(motorCount < MAX_MOTORS)
+        motors[motorCount++] = new motor(m);
+}
+
+motor_group::motor_group(const motor_group& other) : motorCount(0)
+{
+    for(int i = 0; i < other.motorCount; i++)
+        add(*other.motors[i]);
+}
+
+motor_group& motor_group::operator=(const motor_group& other)
+{
+    if(this != &other)
+    {
+        for(int i = 0; i < motorCount; i++)
+            delete motors[i];
+        motorCount = 0;
+        for(int i = 0; i < other.motorCount; i++)
+            add(*other.motors[i]);
+    }
+    return *this;
+}
+
+motor_group::~motor_group()
+{
+    for(int i = 0; i < motorCount; i++)
+        delete motors[i];
+}
+
+void motor_group::setVelocity(double velocity, velocityUnits units) { for(int i = 0; i < motorCount; i++) motors[i]->setVelocity(velocity, units); }
+void motor_group::setVelocity(double velocity, percentUnits units) { for(int i = 0; i < motorCount; i++) motors[i]->setVelocity(velocity, units); }
+void motor_group::setStopping(brakeType mode) { for(int i = 0; i < motorCount; i++) motors[i]->setStopping(mode); }
+void motor_group::setMaxTorque(double value, percentUnits units) { for(int i = 0; i < motorCount; i++) motors[i]->setMaxTorque(value, units); }
+void motor_group::spin(directionType dir) { for(int i = 0; i < motorCount; i++) motors[i]->spin(dir); }
+void motor_group::spin(directionType dir, double velocity, velocityUnits units) { for(int i = 0; i < motorCount; i++) motors[i]->spin(dir, velocity, units); }
+void motor_group::spin(directionType dir, double velocity, percentUnits units) { for(int i = 0; i < motorCount; i++) motors[i]->spin(dir, velocity, units); }
+void motor_group::spin(directionType dir, double voltage, voltageUnits units) { for(int i = 0; i < motorCount; i++) motors[i]->spin(dir, voltage, units); }
+void motor_group::stop() { for(int i = 0; i < motorCount; i++) motors[i]->stop(); }
+void motor_group::stop(brakeType mode) { for(int i = 0; i < motorCount; i++) motors[i]->stop(mode); }
+void motor_group::resetPosition() { for(int i = 0; i < motorCount; i++) motors[i]->resetPosition(); }
+void motor_group::setPosition(double value, rotationUnits units) { for(int i = 0; i < motorCount; i++) motors[i]->setPosition(value, units); }
+
+double motor_group::position(rotationUnits units)
+{
+    return motorCount ? motors[0]->position(units) : 0;
+}
+
+double motor_group::velocity(velocityUnits units)
+{
+    double total = 0;
+    for(int i = 0; i < motorCount; i++)
+        total += motors[i]->velocity(units);
+    return motorCount ? total / motorCount : 0;
+}
+
+double motor_group::velocity(percentUnits units)
+{
+    return velocity(velocityUnits::pct);
+}
+
+double motor_group::current(currentUnits units)
+{
+    double total = 0;
+    for(int i = 0; i < motorCount; i++)
+        total += motors[i]->current(units);
+    return total;
+}
+
+double motor_group::voltage(voltageUnits units)
+{
+    double total = 0;
+    for(int i = 0; i < motorCount; i++)
+        total += motors[i]->voltage(units);
+    return motorCount ? total / motorCount : 0;
+}
+
+bool motor_group::isSpinning()
+{
+    for(int i = 0; i < motorCount; i++)
+        if(motors[i]->isSpinning())
+            return true;
+    return false;
+}
+
+///////////////////////////// Sensors /////////////////////////////
+
+namespace {
+
+double rotationZero[22];
+double inertialHeadingOffset = 0;
+double inertialRotationOffset = 0;
+
+double wrap360(double angle)
+{
+    angle = std::fmod(angle, 360.0);
+    if(angle < 0)
+        angle += 360.0;
+    return angle;
+}
+
+} // namespace
+
+rotation::rotation(int32_t index, bool reverse) : port(index), reversed(reverse) {}
+
+void rotation::resetPosition()
+{
+    rotationZero[port] = vexsim::rotationRawDeg(port);
+}
+
+void rotation::setPosition(double value, rotationUnits units)
+{
+    double raw = vexsim::rotationRawDeg(port);
+    rotationZero[port] = raw - (reversed ? -1 : 1) * toDegrees(value, units);
+}
+
+double rotation::position(rotationUnits units)
+{
+    double deg = vexsim::rotationRawDeg(port) - rotationZero[port];
+    return fromDegrees(reversed ? -deg : deg, units);
+}
+
+double rotation::angle(rotationUnits units)
+{
+    return fromDegrees(wrap360(position(degrees)), units);
+}
+
+double rotation::velocity(velocityUnits units)
+{
+    return 0;
+}
+
+inertial::inertial(int32_t index, turnType dir) : port(index) {}
+
+void inertial::calibrate()
+{
+    vexsim::inertialStartCalibration();
+}
+
+bool inertial::isCalibrating()
+{
+    return vexsim::inertialCalibrating();
+}
+
+void inertial::resetHeading()
+{
+    setHeading(0, degrees);
+}
+
+void inertial::resetRotation()
+{
+    setRotation(0, degrees);
+}
+
+void inertial::setHeading(double value, rotationUnits units)
+{
+    inertialHeadingOffset = toDegrees(value, units) - vexsim::inertialRawDeg();
+}
+
+void inertial::setRotation(double value, rotationUnits units)
+{
+    inertialRotationOffset = toDegrees(value, units) - vexsim::inertialRawDeg();
+}
+
+double inertial::heading(rotationUnits units)
+{
+    return fromDegrees(wrap360(vexsim::inertialRawDeg() + inertialHeadingOffset), units);
+}
+
+double inertial::rotation(rotationUnits units)
+{
+    return fromDegrees(vexsim::inertialRawDeg() + inertialRotationOffset, units);
+}
+
+double inertial::gyroRate(axisType axis, velocityUnits units)
+{
+    if(axis != axisType::zaxis)
+        return 0;
+    double dps = vexsim::inertialRateDps();
+    return units == velocityUnits::rpm ? dps / 6.0 : dps;
+}
+
+static double gpsDistance(double inches, distanceUnits units)
+{
+    if(units == distanceUnits::mm)
+        return inches * 25.4;
+    if(units == distanceUnits::cm)
+        return inches * 2.54;
+    return inches;
+}
+
+double gps::xPosition(distanceUnits units)
+{
+    return gpsDistance(vexsim::gpsPose().x, units);
+}
+
+double gps::yPosition(distanceUnits units)
+{
+    return gpsDistance(vexsim::gpsPose().y, units);
+}
+
+double gps::heading(rotationUnits units)
+{
+    return fromDegrees(wrap360(vexsim::gpsPose().heading), units);
+}
+
+double inertial::acceleration(axisType axis)
+{
+    return axis == axisType::zaxis ? 1.0 : 0.0;
+}
+
+} // namespace vex
@@ -0,0 +1,93 @@
+#include "v5.h"
+#include "v5_vcs.h"
+#include "sim.h"
+
+#include <iomanip>
+#include <iostream>
+
+// Field control for the simulator. Once main() has registered its callbacks,
+// the robot gets a pre-auton window (SIM_PREAUTON_MS, long enough for the
+// inertial calibration) and then the autonomous callback runs as its own task.
+// The run ends when that callback returns or the period (SIM_PERIOD_MS,
+// 60 s skills by default) runs out, and the result is printed.
+
+namespace vex {
+
+namespace {
+
+enum FieldState {DISABLED, AUTONOMOUS, FINISHED};
+
+void (*autonomousCallback)(void) = nullptr;
+void (*driverCallback)(void) = nullptr;
+FieldState fieldState = DISABLED;
+bool fieldStarted = false;
+
+void report(uint64_t startUs, bool timedOut)
+{
+    double elapsed = (vexsim::nowUs() - startUs) / 1e6;
+    vexsim::Pose pose = vexsim::truePose();
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "[sim] autonomous " << (timedOut ? "timed out after " : "finished in ") << elapsed << " s" << std::endl;
+    std::cout << "[sim] true pose: x " << pose.x << " in, y " << pose.y << " in, heading " << pose.heading << " deg" << std::endl;
+    vexsim::reportReplay();
+}
+
+void runField()
+{
+    uint64_t preAutonUs = (uint64_t)(vexsim::envNumber("SIM_PREAUTON_MS", 2500) * 1000);
+    uint64_t periodUs = (uint64_t)(vexsim::envNumber("SIM_PERIOD_MS", 60000) * 1000);
+
+    vexsim::sleepUs(preAutonUs);
+
+    uint64_t startUs = vexsim::nowUs();
+    vexsim::startReplay();
+    fieldState = AUTONOMOUS;
+    int autonTask = vexsim::spawn(autonomousCallback, task::taskPriorityNormal);
+
+    while(!vexsim::isFinished(autonTask) && vexsim::nowUs() - startUs < periodUs)
+        vexsim::sleepUs(1000);
+
+    bool timedOut = !vexsim::isFinished(autonTask);
+    fieldState = FINISHED;
+    report(startUs, timedOut);
+    vexsim::finish(0);
+}
+
+void startField()
+{
+    if(fieldStarted || !autonomousCallback)
+        return;
+    fieldStarted = true;
+    vexsim::spawn(runField, task::taskPriorityHigh);
+}
+
+} // namespace
+
+void competition::autonomous(void (*callback)(void))
+{
+    autonomousCallback = callback;
+    startField();
+}
+
+void competition::drivercontrol(void (*callback)(void))
+{
+    driverCallback = callback;
+}
+
+bool competition::isAutonomous()
+{
+    return fieldState == AUTONOMOUS;
+}
+
+bool competition::isDriverControl()
+{
+    return false;
+}
+
+bool competition::isEnabled()
+{
+    return fieldState == AUTONOMOUS;
+}
+
+} // namespace vex
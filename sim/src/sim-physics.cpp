@@ -0,0 +1,545 @@
+#include "sim.h"
+#include "SensorLog.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace vexsim {
+
+namespace {
+
+const double IN_TO_M = 0.0254;
+const double GRAVITY = 9.81;
+const uint64_t STEP_US = 1000;
+
+/// @brief Physical description of the simulated robot.
+/// Ports are 0-indexed like vex::PORTn, and match robot-config.cpp.
+struct RobotProfile
+{
+    int leftPorts[4];
+    int rightPorts[4];
+    int leftPodPort;             // rotation1
+    int rightPodPort;            // rotation2
+
+    double wheelDiameter;        // drive wheel, inches
+    double wheelRatio;           // motor turns per wheel turn
+    double trackWidth;           // inches between left and right wheel contact
+    double mass;                 // kg
+    double yawInertia;           // kg m^2
+    double traction;             // wheel/tile friction coefficient
+    double rollingResistance;    // N
+    double linearDamping;        // N per m/s
+    double scrubTorque;          // N m opposing point turns
+    double angularDamping;       // N m per rad/s
+
+    double podDiameter;          // tracking wheel, inches
+    double leftPodAngle;         // degrees from robot forward toward robot right
+    double rightPodAngle;
+    double leftPodLever;         // inches of pod travel per radian of clockwise rotation
+    double rightPodLever;
+};
+
+// 8 x 600rpm motors on 2.66" wheels, two 45 degree tracking pods 3.867" from
+// the tracking center. Mass and inertia are estimates of the competition robot.
+RobotProfile robot = {
+    {8, 6, 7, 9},                // LFT PORT9, LFB PORT7, LBB PORT8, LBT PORT10
+    {3, 0, 2, 1},                // RFT PORT4, RFB PORT1, RBB PORT3, RBT PORT2
+    12, 11,                      // rotation1 PORT13, rotation2 PORT12
+    2.66, 1.0, 12.0,
+    6.8, 0.17, 1.1,
+    4.0, 2.0, 1.5, 0.3,
+    2.0, 45.0, -45.0, -3.867, 3.867
+};
+
+/// @brief Electrical model of one V5 smart motor at its output shaft.
+/// Linear DC motor with the 2.5 A firmware current limit: flat stall torque up
+/// to the limit, then falling linearly to the free speed.
+struct Cartridge
+{
+    double freeSpeed;            // rad/s at 12 V
+    double stallTorque;          // N m at the current limit
+};
+
+const double MOTOR_RESISTANCE = 2.0;
+const double MOTOR_CURRENT_LIMIT = 2.5;
+const double MOTOR_MAX_VOLTS = 12.0;
+
+Cartridge cartridgeFor(double maxRpm)
+{
+    Cartridge c;
+    c.freeSpeed = maxRpm * 2.0 * M_PI / 60.0;
+    c.stallTorque = 0.35 * 600.0 / maxRpm;
+    return c;
+}
+
+struct Physics
+{
+    bool initialised;
+    uint64_t timeUs;
+
+    double x, y, heading;        // inches, inches, radians clockwise from +Y
+    double velocity;             // m/s forward
+    double omega;                // rad/s clockwise
+    double leftWheelRad, rightWheelRad;
+
+    double podRawDeg[22];
+    double podLatchedDeg[22];
+    double imuRawDeg, imuLatchedDeg, imuRateDps;
+    Pose gpsLatched;
+    double gpsNoise;
+    uint32_t noiseSeed;
+    uint64_t calibrationEndUs;
+
+    MotorState motors[22];
+    FILE* trace;
+
+    // SIM_REPLAY: the recorded sample in force, and what turns its readings back into raw sensor values
+    SensorLog* replay;
+    bool replaying;
+    uint64_t replayStartUs;
+    uint32_t replayNext;
+    double podOffset[2], leftOffset, rightOffset, imuOffset;
+    uint32_t replayCompared;
+    double replayWorstVolts;
+    int64_t replayFirstUs;
+
+    Physics() : initialised(false) {}
+};
+
+Physics& physics()
+{
+    static Physics instance;
+    return instance;
+}
+
+void initialise(Physics& p)
+{
+    if(p.initialised)
+        return;
+    p.initialised = true;
+    p.timeUs = 0;
+    p.velocity = 0;
+    p.omega = 0;
+    p.leftWheelRad = 0;
+    p.rightWheelRad = 0;
+    p.imuRawDeg = 0;
+    p.imuLatchedDeg = 0;
+    p.imuRateDps = 0;
+    p.calibrationEndUs = 0;
+
+    // SIM_START="x,y,heading" places the robot where the route expects it
+    Pose start = {0, 0, 0};
+    std::string startText = envString("SIM_START", "");
+    if(!startText.empty())
+        std::sscanf(startText.c_str(), "%lf,%lf,%lf", &start.x, &start.y, &start.heading);
+    p.x = start.x;
+    p.y = start.y;
+    p.heading = start.heading * M_PI / 180.0;
+    p.imuRawDeg = start.heading;
+    p.imuLatchedDeg = start.heading;
+
+    // SIM_GPS_NOISE is the standard deviation of the GPS x and y in inches, the seed keeps runs repeatable
+    p.gpsNoise = envNumber("SIM_GPS_NOISE", 0.5);
+    p.noiseSeed = 12345;
+    p.gpsLatched = start;
+
+    // SIM_PODS=vertical swaps the 45 degree pods for two forward facing ones, for TWO_VERTICAL odometry
+    if(envString("SIM_PODS", "") == "vertical")
+    {
+        robot.leftPodAngle = 0;
+        robot.rightPodAngle = 0;
+        robot.leftPodLever = 3.867;
+        robot.rightPodLever = -3.867;
+    }
+
+    for(int i = 0; i < 22; i++)
+    {
+        MotorState& m = p.motors[i];
+        std::memset(&m, 0, sizeof(m));
+        m.mode = MOTOR_STOPPED;
+        m.brakeMode = 0;
+        m.defaultVelocityPct = 50;
+        m.maxRpm = 200;
+        p.podRawDeg[i] = 0;
+        p.podLatchedDeg[i] = 0;
+    }
+    for(int i = 0; i < 4; i++)
+    {
+        p.motors[robot.leftPorts[i]].drive = true;
+        p.motors[robot.rightPorts[i]].drive = true;
+    }
+
+    // SIM_REPLAY=<log> plays a SensorLog back through the pods, inertial and drive encoders from the start of autonomous
+    p.replay = nullptr;
+    p.replaying = false;
+    std::string replayPath = envString("SIM_REPLAY", "");
+    if(!replayPath.empty())
+    {
+        p.replay = new SensorLog(1);
+        if(!p.replay->load(replayPath.c_str()) || p.replay->size() == 0)
+        {
+            std::fprintf(stderr, "[sim] SIM_REPLAY: can't read a sensor log from %s\n", replayPath.c_str());
+            std::exit(1);
+        }
+    }
+
+    std::string tracePath = envString("SIM_TRACE", "");
+    p.trace = tracePath.empty() ? nullptr : std::fopen(tracePath.c_str(), "w");
+    if(p.trace)
+        std::fprintf(p.trace, "time,x,y,heading,leftSpeed,rightSpeed\n");
+}
+
+/// @brief Works out the terminal voltage the motor firmware applies this step
+double appliedVolts(MotorState& m, double shaftRadPerSec, double shaftDeg, const Cartridge& c)
+{
+    double rpm = shaftRadPerSec * 60.0 / (2.0 * M_PI);
+    switch(m.mode)
+    {
+        case MOTOR_VOLTAGE:
+            return m.commandVolts;
+        case MOTOR_VELOCITY:
+        {
+            // Internal velocity loop, feedforward plus PI on rpm
+            double error = m.commandRpm - rpm;
+            m.velocityIntegral += error * (STEP_US / 1e6);
+            if(m.velocityIntegral > 50) m.velocityIntegral = 50;
+            if(m.velocityIntegral < -50) m.velocityIntegral = -50;
+            return m.commandRpm / m.maxRpm * MOTOR_MAX_VOLTS + 0.02 * error + 0.1 * m.velocityIntegral;
+        }
+        case MOTOR_STOPPED:
+        default:
+            if(m.brakeMode == 2)
+                return 0.15 * (m.holdDeg - shaftDeg) - 0.01 * rpm;
+            return 0;
+    }
+}
+
+/// @brief Output shaft torque of one motor this step, also records telemetry
+double motorTorque(MotorState& m, double shaftRadPerSec, double shaftDeg)
+{
+    Cartridge c = cartridgeFor(m.maxRpm);
+    double ke = MOTOR_MAX_VOLTS / c.freeSpeed;
+    double kt = c.stallTorque / MOTOR_CURRENT_LIMIT;
+
+    m.rpm = shaftRadPerSec * 60.0 / (2.0 * M_PI);
+
+    // Coast leaves the windings open, nothing is applied
+    if(m.mode == MOTOR_STOPPED && m.brakeMode == 0)
+    {
+        m.volts = 0;
+        m.amps = 0;
+        return 0;
+    }
+
+    double volts = appliedVolts(m, shaftRadPerSec, shaftDeg, c);
+    if(volts > MOTOR_MAX_VOLTS) volts = MOTOR_MAX_VOLTS;
+    if(volts < -MOTOR_MAX_VOLTS) volts = -MOTOR_MAX_VOLTS;
+
+    double amps = (volts - ke * shaftRadPerSec) / MOTOR_RESISTANCE;
+    if(amps > MOTOR_CURRENT_LIMIT) amps = MOTOR_CURRENT_LIMIT;
+    if(amps < -MOTOR_CURRENT_LIMIT) amps = -MOTOR_CURRENT_LIMIT;
+
+    m.volts = volts;
+    m.amps = amps;
+    return kt * amps;
+}
+
+/// @brief Mechanisms off the drivetrain only need a plausible shaft position
+void stepFreeMotor(MotorState& m, double dt)
+{
+    Cartridge c = cartridgeFor(m.maxRpm);
+    double target = 0;
+    if(m.mode == MOTOR_VOLTAGE)
+        target = m.commandVolts / MOTOR_MAX_VOLTS * c.freeSpeed;
+    else if(m.mode == MOTOR_VELOCITY)
+        target = m.commandRpm * 2.0 * M_PI / 60.0;
+
+    double current = m.rpm * 2.0 * M_PI / 60.0;
+    current += (target - current) * (dt / 0.05);
+    m.rpm = current * 60.0 / (2.0 * M_PI);
+    m.liveShaftDeg += m.rpm * 6.0 * dt;
+    m.volts = target / c.freeSpeed * MOTOR_MAX_VOLTS;
+}
+
+void step(Physics& p, double dt)
+{
+    const double wheelRadius = robot.wheelDiameter * IN_TO_M / 2.0;
+    const double halfTrack = robot.trackWidth * IN_TO_M / 2.0;
+    const double tractionLimit = robot.traction * robot.mass * GRAVITY / 2.0;
+
+    double leftSpeed = p.velocity + p.omega * halfTrack;
+    double rightSpeed = p.velocity - p.omega * halfTrack;
+    double leftShaft = leftSpeed / wheelRadius * robot.wheelRatio;
+    double rightShaft = rightSpeed / wheelRadius * robot.wheelRatio;
+
+    double leftForce = 0, rightForce = 0;
+    for(int i = 0; i < 4; i++)
+    {
+        MotorState& l = p.motors[robot.leftPorts[i]];
+        MotorState& r = p.motors[robot.rightPorts[i]];
+        leftForce += motorTorque(l, leftShaft, l.liveShaftDeg) * robot.wheelRatio / wheelRadius;
+        rightForce += motorTorque(r, rightShaft, r.liveShaftDeg) * robot.wheelRatio / wheelRadius;
+    }
+    if(leftForce > tractionLimit) leftForce = tractionLimit;
+    if(leftForce < -tractionLimit) leftForce = -tractionLimit;
+    if(rightForce > tractionLimit) rightForce = tractionLimit;
+    if(rightForce < -tractionLimit) rightForce = -tractionLimit;
+
+    // Smoothed Coulomb friction so the robot can come to rest without chattering
+    double resist = robot.rollingResistance * std::tanh(p.velocity / 0.02) + robot.linearDamping * p.velocity;
+    double scrub = robot.scrubTorque * std::tanh(p.omega / 0.05) + robot.angularDamping * p.omega;
+
+    double accel = (leftForce + rightForce - resist) / robot.mass;
+    double alpha = ((leftForce - rightForce) * halfTrack - scrub) / robot.yawInertia;
+
+    p.velocity += accel * dt;
+    p.omega += alpha * dt;
+
+    double distance = p.velocity * dt / IN_TO_M;
+    double turned = p.omega * dt;
+    double midHeading = p.heading + turned / 2.0;
+    p.x += distance * std::sin(midHeading);
+    p.y += distance * std::cos(midHeading);
+    p.heading += turned;
+
+    leftSpeed = p.velocity + p.omega * halfTrack;
+    rightSpeed = p.velocity - p.omega * halfTrack;
+    p.leftWheelRad += leftSpeed / wheelRadius * dt;
+    p.rightWheelRad += rightSpeed / wheelRadius * dt;
+
+    for(int i = 0; i < 22; i++)
+    {
+        MotorState& m = p.motors[i];
+        if(!m.drive)
+            stepFreeMotor(m, dt);
+    }
+    for(int i = 0; i < 4; i++)
+    {
+        p.motors[robot.leftPorts[i]].liveShaftDeg = p.leftWheelRad * robot.wheelRatio * 180.0 / M_PI;
+        p.motors[robot.rightPorts[i]].liveShaftDeg = p.rightWheelRad * robot.wheelRatio * 180.0 / M_PI;
+    }
+
+    // Tracking pods only see the component of travel along their wheel
+    const double podCircumference = M_PI * robot.podDiameter;
+    p.podRawDeg[robot.leftPodPort] += (distance * std::cos(robot.leftPodAngle * M_PI / 180.0) + robot.leftPodLever * turned) / podCircumference * 360.0;
+    p.podRawDeg[robot.rightPodPort] += (distance * std::cos(robot.rightPodAngle * M_PI / 180.0) + robot.rightPodLever * turned) / podCircumference * 360.0;
+
+    p.imuRawDeg += turned * 180.0 / M_PI;
+    p.imuRateDps = p.omega * 180.0 / M_PI;
+}
+
+/// @brief Normally distributed noise from a fixed seed
+double gaussian(Physics& p)
+{
+    p.noiseSeed = p.noiseSeed * 1664525u + 1013904223u;
+    double u1 = (p.noiseSeed + 1.0) / 4294967297.0;
+    p.noiseSeed = p.noiseSeed * 1664525u + 1013904223u;
+    double u2 = (p.noiseSeed + 1.0) / 4294967297.0;
+    return std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * M_PI * u2);
+}
+
+/// @brief Holds the replayed sensors at the recorded sample in force, in place of the
+/// physics model's readings, and compares the drive's voltage command with the recorded one
+void replaySensors(Physics& p)
+{
+    const SensorLog& log = *p.replay;
+    int64_t elapsed = p.timeUs - p.replayStartUs;
+    while(p.replayNext < log.size() && (int64_t)(log[p.replayNext].time - log.getStartTime()) <= elapsed)
+    {
+        const SensorSample& sample = log[p.replayNext++];
+        const MotorState& left = p.motors[robot.leftPorts[0]];
+        const MotorState& right = p.motors[robot.rightPorts[0]];
+        double leftVolts = left.mode == MOTOR_VOLTAGE ? left.commandVolts : 0;
+        double rightVolts = right.mode == MOTOR_VOLTAGE ? right.commandVolts : 0;
+        double error = std::fmax(std::fabs(leftVolts - sample.leftVolts), std::fabs(rightVolts - sample.rightVolts));
+        if(error > 0 && p.replayFirstUs < 0)
+            p.replayFirstUs = elapsed;
+        if(error > p.replayWorstVolts)
+            p.replayWorstVolts = error;
+        p.replayCompared++;
+    }
+    if(p.replayNext == 0)
+        return;
+
+    const SensorSample& sample = log[p.replayNext - 1];
+    p.podLatchedDeg[robot.leftPodPort] = sample.pods[0] + p.podOffset[0];
+    p.podLatchedDeg[robot.rightPodPort] = sample.pods[1] + p.podOffset[1];
+    p.imuLatchedDeg = sample.inertialRotation + p.imuOffset;
+    for(int i = 0; i < 4; i++)
+    {
+        p.motors[robot.leftPorts[i]].shaftDeg = sample.leftMotor + p.leftOffset;
+        p.motors[robot.rightPorts[i]].shaftDeg = sample.rightMotor + p.rightOffset;
+    }
+}
+
+/// @brief Sensors only publish new data at their refresh rate
+void latchSensors(Physics& p)
+{
+    if(p.timeUs % 5000 == 0)
+        for(int i = 0; i < 22; i++)
+            p.podLatchedDeg[i] = p.podRawDeg[i];
+
+    if(p.timeUs % 10000 == 0)
+    {
+        p.imuLatchedDeg = p.imuRawDeg;
+        for(int i = 0; i < 22; i++)
+            p.motors[i].shaftDeg = p.motors[i].liveShaftDeg;
+
+        if(p.timeUs % 20000 == 0)
+        {
+            p.gpsLatched.x = p.x + p.gpsNoise * gaussian(p);
+            p.gpsLatched.y = p.y + p.gpsNoise * gaussian(p);
+            p.gpsLatched.heading = p.heading * 180.0 / M_PI;
+        }
+
+        if(p.trace)
+        {
+            double l, r;
+            trueWheelSpeeds(l, r);
+            std::fprintf(p.trace, "%.3f,%.3f,%.3f,%.3f,%.2f,%.2f\n", p.timeUs / 1e6, p.x, p.y, p.heading * 180.0 / M_PI, l, r);
+        }
+    }
+
+    if(p.replaying)
+        replaySensors(p);
+}
+
+} // namespace
+
+void physicsAdvanceTo(uint64_t timeUs)
+{
+    Physics& p = physics();
+    initialise(p);
+    while(p.timeUs + STEP_US <= timeUs)
+    {
+        step(p, STEP_US / 1e6);
+        p.timeUs += STEP_US;
+        latchSensors(p);
+    }
+}
+
+Pose truePose()
+{
+    Physics& p = physics();
+    initialise(p);
+    double heading = std::fmod(p.heading * 180.0 / M_PI, 360.0);
+    if(heading < 0)
+        heading += 360.0;
+    Pose pose = {p.x, p.y, heading};
+    return pose;
+}
+
+void setTruePose(const Pose& pose)
+{
+    Physics& p = physics();
+    initialise(p);
+    p.x = pose.x;
+    p.y = pose.y;
+    p.imuRawDeg += pose.heading - p.heading * 180.0 / M_PI;
+    p.imuLatchedDeg = p.imuRawDeg;
+    p.heading = pose.heading * M_PI / 180.0;
+}
+
+void trueWheelSpeeds(double& left, double& right)
+{
+    Physics& p = physics();
+    initialise(p);
+    double halfTrack = robot.trackWidth * IN_TO_M / 2.0;
+    left = (p.velocity + p.omega * halfTrack) / IN_TO_M;
+    right = (p.velocity - p.omega * halfTrack) / IN_TO_M;
+}
+
+MotorState& motorState(int port)
+{
+    Physics& p = physics();
+    initialise(p);
+    if(port < 0 || port >= 22)
+        port = 21;
+    return p.motors[port];
+}
+
+double rotationRawDeg(int port)
+{
+    Physics& p = physics();
+    initialise(p);
+    if(port < 0 || port >= 22)
+        return 0;
+    return p.podLatchedDeg[port];
+}
+
+double inertialRawDeg()
+{
+    Physics& p = physics();
+    initialise(p);
+    return p.imuLatchedDeg;
+}
+
+double inertialRateDps()
+{
+    Physics& p = physics();
+    initialise(p);
+    return p.imuRateDps;
+}
+
+Pose gpsPose()
+{
+    Physics& p = physics();
+    initialise(p);
+    return p.gpsLatched;
+}
+
+void startReplay()
+{
+    Physics& p = physics();
+    initialise(p);
+    if(!p.replay)
+        return;
+
+    // The first sample's readings land on the sensors as they are now, the
+    // robot is standing still at the start of autonomous
+    const SensorSample& first = (*p.replay)[0];
+    p.podOffset[0] = p.podLatchedDeg[robot.leftPodPort] - first.pods[0];
+    p.podOffset[1] = p.podLatchedDeg[robot.rightPodPort] - first.pods[1];
+    p.imuOffset = p.imuLatchedDeg - first.inertialRotation;
+    p.leftOffset = p.motors[robot.leftPorts[0]].shaftDeg - first.leftMotor;
+    p.rightOffset = p.motors[robot.rightPorts[0]].shaftDeg - first.rightMotor;
+
+    p.replaying = true;
+    p.replayStartUs = p.timeUs;
+    p.replayNext = 0;
+    p.replayCompared = 0;
+    p.replayWorstVolts = 0;
+    p.replayFirstUs = -1;
+}
+
+void reportReplay()
+{
+    Physics& p = physics();
+    initialise(p);
+    if(!p.replaying)
+        return;
+
+    std::printf("[sim] replay: %u of %u samples played", (unsigned)p.replayCompared, (unsigned)p.replay->size());
+    if(p.replayFirstUs < 0)
+        std::printf(", drive voltage matches the recording\n");
+    else
+        std::printf(", drive voltage off by up to %.3f V, first at %.3f s\n", p.replayWorstVolts, p.replayFirstUs / 1e6);
+}
+
+bool inertialCalibrating()
+{
+    Physics& p = physics();
+    initialise(p);
+    return p.timeUs < p.calibrationEndUs;
+}
+
+void inertialStartCalibration()
+{
+    Physics& p = physics();
+    initialise(p);
+    p.calibrationEndUs = p.timeUs + 2000000;
+}
+
+} // namespace vexsim
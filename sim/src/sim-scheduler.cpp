@@ -0,0 +1,232 @@
+#include "sim.h"
+
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace vexsim {
+
+namespace {
+
+struct Fiber
+{
+    int id;
+    int priority;
+    uint64_t wakeUs;
+    uint64_t order;
+    bool finished;
+    bool interrupted;
+    std::condition_variable wakeUp;
+};
+
+struct Scheduler
+{
+    std::mutex lock;
+    std::map<int, Fiber*> fibers;
+    Fiber* current;
+    uint64_t now;
+    uint64_t order;
+    int nextId;
+
+    Scheduler() : current(nullptr), now(0), order(0), nextId(1) {}
+};
+
+Scheduler& scheduler()
+{
+    static Scheduler instance;
+    return instance;
+}
+
+thread_local Fiber* self = nullptr;
+
+Fiber* createFiber(Scheduler& s, int priority)
+{
+    Fiber* fiber = new Fiber();
+    fiber->id = s.nextId++;
+    fiber->priority = priority;
+    fiber->wakeUs = s.now;
+    fiber->order = s.order++;
+    fiber->finished = false;
+    fiber->interrupted = false;
+    s.fibers[fiber->id] = fiber;
+    return fiber;
+}
+
+/// @brief The first thread to touch the scheduler is main(), register it lazily
+Fiber* ensureSelf(Scheduler& s)
+{
+    if(!self)
+    {
+        self = createFiber(s, 7);
+        if(!s.current)
+            s.current = self;
+    }
+    return self;
+}
+
+/// @brief Picks the next task to run, advances time and physics up to its
+/// wake-up, and hands it the processor. Earliest wake-up first, then highest
+/// priority, then first come first served.
+void dispatch(Scheduler& s)
+{
+    Fiber* next = nullptr;
+    for(std::map<int, Fiber*>::iterator it = s.fibers.begin(); it != s.fibers.end(); ++it)
+    {
+        Fiber* f = it->second;
+        if(f->finished)
+            continue;
+        if(!next || f->wakeUs < next->wakeUs ||
+           (f->wakeUs == next->wakeUs && (f->priority > next->priority ||
+           (f->priority == next->priority && f->order < next->order))))
+            next = f;
+    }
+
+    if(!next)
+    {
+        std::cout << "[sim] no tasks left to run" << std::endl;
+        finish(0);
+    }
+
+    if(next->wakeUs > s.now)
+    {
+        physicsAdvanceTo(next->wakeUs);
+        s.now = next->wakeUs;
+    }
+    s.current = next;
+    next->wakeUp.notify_one();
+}
+
+/// @brief Removes the calling task from the run queue for good
+void retire(Scheduler& s, std::unique_lock<std::mutex>& guard, Fiber* me, bool block)
+{
+    me->finished = true;
+    dispatch(s);
+    if(block)
+    {
+        // An interrupted task never runs again, park its OS thread
+        me->wakeUp.wait(guard, []{ return false; });
+    }
+}
+
+} // namespace
+
+uint64_t nowUs()
+{
+    Scheduler& s = scheduler();
+    std::lock_guard<std::mutex> guard(s.lock);
+    return s.now;
+}
+
+void sleepUs(uint64_t us)
+{
+    Scheduler& s = scheduler();
+    std::unique_lock<std::mutex> guard(s.lock);
+    Fiber* me = ensureSelf(s);
+
+    me->wakeUs = s.now + us;
+    me->order = s.order++;
+    dispatch(s);
+    me->wakeUp.wait(guard, [&]{ return s.current == me; });
+
+    if(me->interrupted)
+        retire(s, guard, me, true);
+}
+
+int spawn(std::function<void()> body, int priority)
+{
+    Scheduler& s = scheduler();
+    std::unique_lock<std::mutex> guard(s.lock);
+    ensureSelf(s);
+    Fiber* fiber = createFiber(s, priority);
+
+    std::thread([fiber, body]() {
+        Scheduler& s = scheduler();
+        {
+            std::unique_lock<std::mutex> guard(s.lock);
+            self = fiber;
+            fiber->wakeUp.wait(guard, [&]{ return s.current == fiber; });
+            if(fiber->interrupted)
+            {
+                retire(s, guard, fiber, true);
+                return;
+            }
+        }
+
+        body();
+
+        std::unique_lock<std::mutex> guard(s.lock);
+        retire(s, guard, fiber, false);
+    }).detach();
+
+    return fiber->id;
+}
+
+int currentTask()
+{
+    Scheduler& s = scheduler();
+    std::lock_guard<std::mutex> guard(s.lock);
+    return ensureSelf(s)->id;
+}
+
+bool isFinished(int id)
+{
+    Scheduler& s = scheduler();
+    std::lock_guard<std::mutex> guard(s.lock);
+    std::map<int, Fiber*>::iterator it = s.fibers.find(id);
+    return it == s.fibers.end() || it->second->finished;
+}
+
+void interrupt(int id)
+{
+    Scheduler& s = scheduler();
+    std::lock_guard<std::mutex> guard(s.lock);
+    std::map<int, Fiber*>::iterator it = s.fibers.find(id);
+    if(it != s.fibers.end())
+        it->second->interrupted = true;
+}
+
+void setPriority(int id, int priority)
+{
+    Scheduler& s = scheduler();
+    std::lock_guard<std::mutex> guard(s.lock);
+    std::map<int, Fiber*>::iterator it = s.fibers.find(id);
+    if(it != s.fibers.end())
+        it->second->priority = priority;
+}
+
+int getPriority(int id)
+{
+    Scheduler& s = scheduler();
+    std::lock_guard<std::mutex> guard(s.lock);
+    std::map<int, Fiber*>::iterator it = s.fibers.find(id);
+    return it != s.fibers.end() ? it->second->priority : 0;
+}
+
+void finish(int exitCode)
+{
+    std::cout.flush();
+    std::fflush(nullptr);
+    std::_Exit(exitCode);
+}
+
+double envNumber(const char* name, double fallback)
+{
+    const char* value = std::getenv(name);
+    if(!value || !*value)
+        return fallback;
+    return std::atof(value);
+}
+
+std::string envString(const char* name, const std::string& fallback)
+{
+    const char* value = std::getenv(name);
+    if(!value || !*value)
+        return fallback;
+    return value;
+}
+
+} // namespace vexsim
@@ -0,0 +1,139 @@
+#include "Benchmark.h"
+#include "Drive.h"
+#include "FastMath.h"
+#include "CardLog.h"
+
+// Distance driven out and back for the full motion loop benchmark (in)
+static const float BENCHMARK_DRIVE = 24;
+
+/// @brief Prints the column names for printBenchmark
+void printBenchmarkHeader()
+{
+    printf("%-34s %10s %12s %12s %12s\n", "kernel", "calls", "ns/op", "p99.9 ns", "worst ns");
+}
+
+/// @brief Prints one result to the terminal, the serial console on the brain
+/// @param result The result from runBenchmark
+void printBenchmark(const BenchmarkResult& result)
+{
+    printf("%-34s %10lu %12.1f %12.0f %12.0f\n", result.name, (unsigned long)result.iterations, result.nsPerOp, result.p999Ns, result.worstNs);
+}
+
+/// @brief Prints how much of a loop period a cost uses
+/// @param name What runs in the loop
+/// @param costUs Time per cycle in microseconds
+/// @param periodMs The loop period in milliseconds
+static void printBudget(const char* name, float costUs, float periodMs)
+{
+    printf("%-34s %6.1f us of %.0f ms, %5.2f%% used\n", name, costUs, periodMs, costUs / (periodMs * 10));
+}
+
+/// @brief Times the kernels the motion and odometry loops run every cycle and prints
+/// the results to the terminal. The kernels work on their own copies and leave the
+/// chassis alone, the last step drives out and back BENCHMARK_DRIVE inches with
+/// driveDistanceWithOdom to time whole motion loop iterations, so give the robot room.
+/// Odometry has to be running.
+/// @param chassis The drive to time
+/// @param iterations Calls per kernel
+void runControlBenchmarks(Drive& chassis, uint32_t iterations)
+{
+    printf("control path benchmark, %lu calls per kernel\n", (unsigned long)iterations);
+    printBenchmarkHeader();
+
+    PID pid(0.7, 0.0001, 1.7, 1, 80, 2500);
+    pid.setOutputLimit(12);
+    BenchmarkResult pidResult = runBenchmark("PID::compute", iterations, [&](uint32_t i) {
+        return pid.compute(24 - (i % 2400) * 0.01f);
+    });
+    printBenchmark(pidResult);
+
+    // Pods and heading moving like a 40 in/s arc, the updates see a fresh delta every call
+    Odom angled(1.955, -3.867, 3.867);
+    BenchmarkResult odomResult = runBenchmark("Odom::updatePositionTwoAt45", iterations, [&](uint32_t i) {
+        angled.updatePositionTwoAt45(i * 0.8, i * 0.6, fmod(i * 0.05, 360));
+        return angled.getXPosition();
+    });
+    printBenchmark(odomResult);
+
+    Odom vertical(2.0, 2.0, 0, 3.867, 3.867, 0);
+    vertical.setGyroWeight(0.02);
+    printBenchmark(runBenchmark("Odom::updatePositionTwoVertical", iterations, [&](uint32_t i) {
+        vertical.updatePositionTwoVertical(i * 0.8, i * 0.6, fmod(i * 0.05, 360));
+        return vertical.getXPosition();
+    }));
+
+    printBenchmark(runBenchmark("degTo180", iterations, [](uint32_t i) {
+        return degTo180(fmod(i * 0.37f, 1440) - 720);
+    }));
+    printBenchmark(runBenchmark("inTermsOfNegative180To180", iterations, [](uint32_t i) {
+        return inTermsOfNegative180To180(fmod(i * 0.37f, 1440) - 720);
+    }));
+
+    printBenchmark(runBenchmark("fastSinCos", iterations, [](uint32_t i) {
+        double sine, cosine;
+        fastSinCos(i * 0.001, sine, cosine);
+        return sine + cosine;
+    }));
+    printBenchmark(runBenchmark("sin + cos", iterations, [](uint32_t i) {
+        return sin(i * 0.001) + cos(i * 0.001);
+    }));
+
+    // A drive state record into the card log's ring. Nothing is open to write to, the
+    // ring is emptied in place once half full, under one call in a thousand so the
+    // percentile is the record alone.
+    CardLog cardLog(262144);
+    uint16_t channel = cardLog.addChannel("benchmark", "x,y,heading,pod1,pod2,leftMotor,rightMotor,inertialHeading,inertialRotation,leftVolts,rightVolts");
+    float state[11] = {0};
+    BenchmarkResult logResult = runBenchmark("CardLog::log (11 values)", iterations, [&](uint32_t i) {
+        state[0] = i * 0.01f;
+        cardLog.log(channel, state, 11);
+        if(cardLog.pending() > 131072)
+            cardLog.flush();
+        return state[0];
+    });
+    printBenchmark(logResult);
+
+    PoseEstimator estimator;
+    estimator.setPods(chassis.chassisOdometry.getProfile(), true, true);
+    estimator.setDrive(M_PI * 2.66 / 360, 12);
+    estimator.reset(0, 0, 0, 0);
+    printBenchmark(runBenchmark("PoseEstimator::update", iterations, [&](uint32_t i) {
+        EstimatorReadings readings = {(uint64_t)i * 5000, {i * 0.8f, i * 0.6f}, i * 0.7f, i * 0.7f, i * 0.05f};
+        estimator.update(readings);
+        return estimator.getForwardSpeed();
+    }));
+
+    // A whole odometry task cycle, sensor reads included. The pose it integrates
+    // is put back afterwards, the odometry task is paused while this runs.
+    chassis.stopOdometry();
+    task::sleep(20);
+    Pose before = chassis.chassisOdometry.getPose();
+    BenchmarkResult tickResult = runBenchmark("Drive::updatePosition", iterations, [&](uint32_t) {
+        chassis.updatePosition();
+        return chassis.chassisOdometry.getHeading();
+    });
+    printBenchmark(tickResult);
+    chassis.setPosition(before.x, before.y, before.heading);
+    chassis.startOdometry();
+    task::sleep(20);
+
+    // Whole motion loop iterations, timed by the loop itself
+    chassis.driveDistanceWithOdom(BENCHMARK_DRIVE);
+    ControlLoop& loop = chassis.getMotionLoop();
+    float outBusy = loop.getAverageBusy(), outWorst = loop.getMaxBusy();
+    uint32_t outCycles = loop.getCycles();
+    chassis.driveDistanceWithOdom(-BENCHMARK_DRIVE);
+    uint32_t cycles = outCycles + loop.getCycles();
+    float busy = cycles > 0 ? (outBusy * outCycles + loop.getAverageBusy() * loop.getCycles()) / cycles : 0;
+    float worst = fmax(outWorst, loop.getMaxBusy());
+    printf("%-34s %10lu %12.1f %12s %12.0f\n", "driveDistanceWithOdom iteration", (unsigned long)cycles, busy * 1000, "-", worst * 1000);
+
+    printf("tick budget\n");
+    printBudget("odometry task (mean)", tickResult.nsPerOp / 1000, 5);
+    printBudget("odometry task (p99.9)", tickResult.p999Ns / 1000, 5);
+    printBudget("odometry task (worst)", tickResult.worstNs / 1000, 5);
+    printBudget("motion loop (mean)", busy, loop.getPeriod());
+    printBudget("motion loop (worst)", worst, loop.getPeriod());
+    printBudget("card log at 100 Hz (mean)", logResult.nsPerOp / 1000, 10);
+    printBudget("card log at 100 Hz (p99.9)", logResult.p999Ns / 1000, 10);
+}
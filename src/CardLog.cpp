@@ -0,0 +1,211 @@
+#include "CardLog.h"
+
+/// @brief Allocates the ring buffer, the only allocation the log makes
+/// @param capacity Bytes the buffer holds, rounded up to a power of two. At 100 Hz a
+/// 12 value record is 5.6 KB a second, the default covers several seconds of the card stalling.
+CardLog::CardLog(uint32_t capacity)
+{
+    uint32_t words = 256;
+    while(words * 4 < capacity)
+        words *= 2;
+    ring = new uint32_t[words];
+    memset(ring, 0, words * 4);
+    mask = words - 1;
+    head = 0;
+    tail = 0;
+    dropped = 0;
+    channels = 1;
+    startTime = timer::systemHighResolution();
+    written = 0;
+    file = 0;
+    running = false;
+    flushing = false;
+    blockUsed = 0;
+}
+
+CardLog::~CardLog()
+{
+    stop();
+    delete[] ring;
+}
+
+/// @brief Opens the file and starts the task that writes the log to it
+/// @param filename File on the SD card, replaced if it exists
+/// @return Returns false if the file can't be opened or the log is already running
+bool CardLog::start(const char* filename)
+{
+    if(running)
+        return false;
+    file = fopen(filename, "wb");
+    if(!file)
+        return false;
+    CardLogHeader header = {CARD_LOG_MAGIC, CARD_LOG_VERSION, startTime};
+    fwrite(&header, sizeof(header), 1, file);
+    written = sizeof(header);
+    running = true;
+    flushing = true;
+    task(flushTask, this, task::taskPriorityLow);
+    return true;
+}
+
+/// @brief Writes out everything logged so far and closes the file
+void CardLog::stop()
+{
+    if(!running)
+        return;
+    running = false;
+    while(flushing)
+        wait(5, msec);
+    flush();
+    fclose(file);
+    file = 0;
+}
+
+/// @brief Defines a channel, the record that does so goes through the ring like any other
+/// @param name Channel name, the decoded CSV file is named after it
+/// @param fields Comma separated names of the values the channel's records hold
+/// @return Returns the channel number for log
+uint16_t CardLog::addChannel(const char* name, const char* fields)
+{
+    uint16_t channel = channels++;
+
+    // Both strings with their terminators, cut short to fit one record
+    char text[CARD_LOG_MAX_VALUES * 4];
+    memset(text, 0, sizeof(text));
+    strncpy(text, name, sizeof(text) / 4 - 1);
+    uint32_t used = strlen(text) + 1;
+    strncpy(text + used, fields, sizeof(text) - used - 1);
+    used += strlen(text + used) + 1;
+    uint32_t textWords = (used + 3) / 4;
+
+    uint32_t words = 3 + textWords;
+    uint32_t start;
+    if(!reserve(words, start))
+        return channel;
+    ring[(start + 1) & mask] = (uint32_t)(timer::systemHighResolution() - startTime);
+    ring[(start + 2) & mask] = channel;
+    for(uint32_t i = 0; i < textWords; i++)
+    {
+        uint32_t word;
+        memcpy(&word, text + i * 4, 4);
+        ring[(start + 3 + i) & mask] = word;
+    }
+    commit(start, words, CARD_LOG_DEFINE);
+    return channel;
+}
+
+/// @brief Copies one record into the ring buffer. Safe from any task, never waits.
+/// @param channel A channel from addChannel
+/// @param values The values, CARD_LOG_MAX_VALUES at most
+/// @param count How many values
+/// @return Returns false if the buffer was full and the record dropped
+bool CardLog::log(uint16_t channel, const float* values, uint16_t count)
+{
+    if(count > CARD_LOG_MAX_VALUES)
+        count = CARD_LOG_MAX_VALUES;
+    uint32_t words = 2 + count;
+    uint32_t start;
+    if(!reserve(words, start))
+        return false;
+
+    ring[(start + 1) & mask] = (uint32_t)(timer::systemHighResolution() - startTime);
+    for(uint32_t i = 0; i < count; i++)
+    {
+        uint32_t word;
+        memcpy(&word, &values[i], 4);
+        ring[(start + 2 + i) & mask] = word;
+    }
+    commit(start, words, channel);
+    return true;
+}
+
+/// @brief Claims space for a record. Writers race for the head with compare and swap,
+/// the one that loses retries with the head the winner left.
+/// @param words Record length
+/// @param start Set to the record's first word
+/// @return Returns false, counting a dropped record, if the ring has no room
+bool CardLog::reserve(uint32_t words, uint32_t& start)
+{
+    start = head.load(std::memory_order_relaxed);
+    do
+    {
+        if(start + words - tail.load(std::memory_order_acquire) > mask + 1)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+    while(!head.compare_exchange_weak(start, start + words, std::memory_order_relaxed));
+    return true;
+}
+
+/// @brief Publishes a record by writing its length word last. The flush stops at a
+/// zero length word, so a record still being filled is never written out.
+void CardLog::commit(uint32_t start, uint32_t words, uint16_t channel)
+{
+    __atomic_store_n(&ring[start & mask], words | (uint32_t)channel << 16, __ATOMIC_RELEASE);
+}
+
+/// @brief Moves every finished record from the ring to the file, in blocks. Without an
+/// open file the records are discarded. Called by the flush task, and by stop once the
+/// task has ended, one at a time.
+void CardLog::flush()
+{
+    uint32_t position = tail.load(std::memory_order_relaxed);
+    uint32_t end = head.load(std::memory_order_acquire);
+    while(position != end)
+    {
+        uint32_t first = __atomic_load_n(&ring[position & mask], __ATOMIC_ACQUIRE);
+        if(first == 0)
+            break;
+        uint32_t words = first & 0xffff;
+        for(uint32_t i = 0; i < words; i++)
+        {
+            uint32_t& word = ring[(position + i) & mask];
+            if(blockUsed + 4 > CARD_LOG_BLOCK)
+                writeBlock();
+            memcpy(block + blockUsed, &word, 4);
+            blockUsed += 4;
+            // Cleared for the length word check of whichever record lands here next
+            word = 0;
+        }
+        position += words;
+        // Hands the space back to the writers once it is clear
+        tail.store(position, std::memory_order_release);
+    }
+    writeBlock();
+}
+
+/// @brief Writes the gathered block to the card
+void CardLog::writeBlock()
+{
+    if(blockUsed == 0)
+        return;
+    if(file)
+    {
+        fwrite(block, 1, blockUsed, file);
+        fflush(file);
+        written += blockUsed;
+    }
+    blockUsed = 0;
+}
+
+/// @brief Writes the ring out whenever a block's worth is waiting, or CARD_LOG_FLUSH_MS
+/// has passed, at low priority so it only runs when the control tasks are waiting
+int CardLog::flushTask(void* log)
+{
+    CardLog* cardLog = static_cast<CardLog*>(log);
+    uint64_t lastFlush = timer::systemHighResolution();
+    while(cardLog->running)
+    {
+        uint64_t now = timer::systemHighResolution();
+        if(cardLog->pending() >= CARD_LOG_BLOCK || now - lastFlush >= CARD_LOG_FLUSH_MS * 1000)
+        {
+            cardLog->flush();
+            lastFlush = now;
+        }
+        wait(20, msec);
+    }
+    cardLog->flushing = false;
+    return 0;
+}
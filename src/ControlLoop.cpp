@@ -0,0 +1,115 @@
+#include "ControlLoop.h"
+
+// Longest the loop spins after its sleep to land on the deadline, in microseconds.
+// Past this it wakes early instead, the controllers scale by the measured period
+// and a longer spin takes the time from the lower priority tasks.
+static const uint32_t MAX_SPIN_US = 50;
+
+/// @brief Constructor
+/// @param periodMs Loop period in milliseconds
+ControlLoop::ControlLoop(float periodMs)
+{
+    this->periodUs = periodMs * 1000;
+    this->phaseUs = 0;
+    start();
+}
+
+/// @brief Constructor
+/// @param periodMs Loop period in milliseconds
+/// @param phaseMs Offset of every deadline from the period grid, use it to wake just after a sensor refresh
+ControlLoop::ControlLoop(float periodMs, float phaseMs)
+{
+    this->periodUs = periodMs * 1000;
+    this->phaseUs = phaseMs * 1000;
+    start();
+}
+
+/// @brief Resets the statistics and lines the first deadline up with the period grid
+void ControlLoop::start()
+{
+    uint64_t now = timer::systemHighResolution();
+    deadline = (now / periodUs) * periodUs + phaseUs;
+    while(deadline <= now)
+        deadline += periodUs;
+    lastWake = now;
+
+    cycles = 0;
+    overruns = 0;
+    totalPeriodUs = 0;
+    lastPeriodUs = periodUs;
+    maxPeriodUs = 0;
+
+    totalBusyNs = 0;
+    maxBusyNs = 0;
+    wakeNs = benchmarkClockNs();
+}
+
+/// @brief Sleeps until the next deadline. If the work ran past one or more
+/// deadlines the missed cycles are dropped instead of being made up, so the
+/// loop never runs back to back trying to catch up. The sleep only has whole
+/// milliseconds, so it stops short of the deadline. When the rest is under
+/// MAX_SPIN_US it is spun off on the microsecond clock, yielding to other tasks,
+/// otherwise the loop wakes up to a millisecond early.
+/// @return The time since the previous wake up in milliseconds
+float ControlLoop::waitForNextCycle()
+{
+    uint32_t busy = benchmarkClockNs() - wakeNs;
+    totalBusyNs += busy;
+    if(busy > maxBusyNs)
+        maxBusyNs = busy;
+
+    uint64_t now = timer::systemHighResolution();
+    if(now >= deadline)
+    {
+        overruns++;
+        while(deadline <= now)
+            deadline += periodUs;
+    }
+
+    if(deadline - now >= 1000)
+        task::sleep((deadline - now) / 1000);
+    now = timer::systemHighResolution();
+    if(now < deadline && deadline - now <= MAX_SPIN_US)
+        while(timer::systemHighResolution() < deadline)
+            task::yield();
+    deadline += periodUs;
+
+    now = timer::systemHighResolution();
+    lastPeriodUs = now - lastWake;
+    lastWake = now;
+    wakeNs = benchmarkClockNs();
+
+    cycles++;
+    totalPeriodUs += lastPeriodUs;
+    if(lastPeriodUs > maxPeriodUs)
+        maxPeriodUs = lastPeriodUs;
+
+    return lastPeriodUs / 1000.0;
+}
+
+/// @brief Average period achieved since start()
+/// @return Period in milliseconds
+float ControlLoop::getAveragePeriod()
+{
+    if(cycles == 0)
+        return periodUs / 1000.0;
+    return (totalPeriodUs / (float)cycles) / 1000.0;
+}
+
+/// @brief Average time each cycle spent working before it waited, the rest of the period is spare
+/// @return Time in microseconds
+float ControlLoop::getAverageBusy()
+{
+    if(cycles == 0)
+        return 0;
+    return (totalBusyNs / (float)cycles) / 1000.0;
+}
+
+/// @brief Prints the achieved timing of the last run if it missed any deadlines
+/// @param name Label for the output
+void ControlLoop::printStats(const char* name)
+{
+    if(overruns == 0)
+        return;
+    std::cout << "LOOP OVERRUN " << name << ": " << overruns << "/" << cycles << " cycles, avg " << getAveragePeriod() << " ms, max " << getMaxPeriod() << " ms" << std::endl;
+}
@@ -1,34 +1,110 @@
 #include "Drive.h"
 
+// How close a chained moveToPosition turn gets before it hands over to the drive (degrees)
+static const float CHAIN_TURN_EXIT = 10;
+
+// Pure pursuit: seconds of travel added to the lookahead, and how hard curvature (1/in) cuts the voltage
+static const float LOOKAHEAD_GAIN = 0.2;
+static const float CURVE_SLOWDOWN = 6;
+
+// moveToPose: how far back along the final heading the carrot starts, as a share
+// of the distance left, and how close (in) the robot gets before it aims at the pose itself
+static const float BOOMERANG_LEAD = 0.6;
+static const float BOOMERANG_CLOSE = 6;
+
+// Trajectory tracking (RAMSETE): b in 1/in^2 pulls the robot back onto the line, zeta is the damping.
+// The 2 /m^2 textbook b left 4 in of cross-track error on the sim, this is about 8 /m^2.
+// After the table runs out the robot gets this long (ms) to settle onto the last point.
+static const float RAMSETE_B = 0.005;
+static const float RAMSETE_ZETA = 0.7;
+static const float TRAJECTORY_END_TIME = 500;
+
+// Arc and swing turns: deg/s of turn rate added per degree the robot is behind the profile
+static const float ARC_KP = 5;
+
+// Two vertical pods: share of the gap to the inertial heading closed every odometry update.
+// At 5 ms per update the pod heading follows the inertial sensor with a 250 ms time constant.
+static const float TWO_VERTICAL_GYRO_WEIGHT = 0.02;
+
+// Pose estimator: GPS reads below this quality (0 - 100) are left out
+static const int GPS_MIN_QUALITY = 90;
+
+// Odometry calibration: forward and back straights by the drive encoders (in) and spins each way by the
+// inertial sensor (deg). Open loop, so the runs don't lean on the geometry they measure.
+static const int CALIBRATION_STRAIGHTS = 3;
+static const float CALIBRATION_DISTANCE = 48;
+static const int CALIBRATION_SPINS = 2;
+static const float CALIBRATION_SPIN = 720;
+static const float CALIBRATION_VOLTAGE = 5;
+static const float CALIBRATION_PAUSE = 500;     // ms held and logged at the end of every segment
+static const float CALIBRATION_TIMEOUT = 10000; // ms
+
 /// @brief Constructor
 /// @param leftDrive Left side motors of the drive base
 /// @param rightDrive Right side motors of the drive base
 /// @param inertialPort The Port where the inertial sensor is 
 /// @param wheelDiameter The diameter size of the wheel in inches
-/// @param wheelRatio   
+/// @param wheelRatio Wheel turns per motor turn, 1 for direct drive
 /// @param max_voltage The maximum amount of the voltage used in the drivebase (1 - 12)
 Drive::Drive(motor_group leftDrive, motor_group rightDrive, int inertialPORT, float wheelDiameter, float wheelRatio, float maxVoltage, int odomType, float odomWheelDiameter, float odomPod1Offset, float odomPod2Offset ) : 
 leftDrive(leftDrive), 
 rightDrive(rightDrive),
-inertialSensor(inertial(inertialPORT))
+inertialSensor(inertial(inertialPORT)),
+motionLoop(10),
+odometryRunning(false),
+resetRequested(false),
+chainPending(false)
 {
-    this->wheelDiameter = wheelDiameter;
-    this->wheelRatio = wheelRatio;
-    this->driveMaxVoltage = maxVoltage;
-    this->turnMaxVoltage = maxVoltage;
+    this->kinematics.wheelDiameter = wheelDiameter;
+    this->kinematics.wheelRatio = wheelRatio;
+    this->minLookahead = 8;
+    this->maxLookahead = 18;
+    this->routePlan = 0;
+    this->estimatorEnabled = false;
+    this->gpsSensor = 0;
+    this->gpsDeviation = 0;
+    this->lastGpsX = 0;
+    this->lastGpsY = 0;
+    this->measurementPending = false;
+    this->sensorLog = 0;
+    this->motionLog = 0;
+    this->cardLog = 0;
+    this->cardChannel = 0;
+    this->cardCycle = 0;
+    this->motionStartTime = 0;
+    this->commandedLeft = 0;
+    this->commandedRight = 0;
+    this->driveDefaults.maxVoltage = maxVoltage;
+    this->turnDefaults.maxVoltage = maxVoltage;
+    this->turnDefaults.minVoltage = 2.5;
     this->odomType = odomType;
 
+    this->motionsStarted = 0;
+    this->motionsFinished = 0;
+    this->asyncOwner = -1;
+    this->motionCommand = MOTION_NONE;
+    this->cancelRequested = false;
+    this->motionTraveled = 0;
+    this->motionTotal = 0;
+    this->lastExit = EXITED_NONE;
+
     // this->chassisOdometry = Odom(2, -1.0, -1.0);
 
     switch(odomType){
         case NO_ODOM:
-            this->chassisOdometry = Odom(wheelDiameter, wheelDiameter, 0, odomPod1Offset, odomPod2Offset, 0);
+            // The motor encoders track, the gearing folds into an effective wheel size.
+            // The drive wheels scrub in turns, so the heading comes from the inertial sensor.
+            this->chassisOdometry = Odom(wheelDiameter * wheelRatio, wheelDiameter * wheelRatio, 0, odomPod2Offset, odomPod1Offset, 0);
+            this->chassisOdometry.setGyroWeight(1);
             break;
         case HORIZONTAL_AND_VERTICAL:
             this->chassisOdometry = Odom(odomWheelDiameter, odomWheelDiameter, odomPod1Offset, odomPod2Offset);
             break;
         case TWO_VERTICAL:
-            // Not yet implemented
+            // Pod 1 is the left pod and pod 2 the right, offsets are their distances from the tracking center.
+            // The heading comes from the pods and is eased toward the inertial sensor.
+            this->chassisOdometry = Odom(odomWheelDiameter, odomWheelDiameter, 0, odomPod2Offset, odomPod1Offset, 0);
+            this->chassisOdometry.setGyroWeight(TWO_VERTICAL_GYRO_WEIGHT);
             break;
         case TWO_AT_45:
             this->chassisOdometry = Odom(odomWheelDiameter, odomPod1Offset, odomPod2Offset);
@@ -36,14 +112,18 @@ inertialSensor(inertial(inertialPORT))
     }
 }
 
+/// @brief Sets the max voltage drives use when a move does not set its own
+/// @param maxVoltage The max amount of voltage (1 - 12)
 void Drive::setDriveMaxVoltage(float maxVoltage)
 {
-    driveMaxVoltage = maxVoltage;
+    driveDefaults.maxVoltage = maxVoltage;
 }
 
+/// @brief Sets the max voltage turns use when a move does not set its own
+/// @param maxVoltage The max amount of voltage (1 - 12)
 void Drive::setTurnMaxVoltage(float maxVoltage)
 {
-    turnMaxVoltage = maxVoltage;
+    turnDefaults.maxVoltage = maxVoltage;
 }
 
 /// @brief Sets the PID constants for the Drive distance 
@@ -58,9 +138,9 @@ void Drive::setDriveConstants(float Kp, float Ki, float Kd, float settleError, f
     driveKp = Kp;
     driveKi = Ki;
     driveKd = Kd;
-    driveSettleError = settleError;
-    driveTimeToSettle = timeToSettle;
-    driveEndTime = endTime;
+    driveDefaults.settleError = settleError;
+    driveDefaults.settleTime = timeToSettle;
+    driveDefaults.timeout = endTime;
 }
 
 /// @brief Sets the PID constants for the turn angle
@@ -75,11 +155,108 @@ void Drive::setTurnConstants(float Kp, float Ki, float Kd, float settleError, fl
     turnKp = Kp;
     turnKi = Ki;
     turnKd = Kd;
-    turnSettleError = settleError;
-    turnTimeToSettle = timeToSettle;
-    turnEndTime = endTime;
+    turnDefaults.settleError = settleError;
+    turnDefaults.settleTime = timeToSettle;
+    turnDefaults.timeout = endTime;
+}
+
+/// @brief Sets the extra exit conditions for drives, 0 turns one off
+/// @param settleVelocity Inches per second, the robot also has to be this slow inside the settle window
+/// @param largeError Inches, a wider window that ends the drive once the robot has spent largeErrorTime in it
+/// @param largeErrorTime Milliseconds
+/// @param stallProgress Inches the error has to shrink by every stallTime
+/// @param stallTime Milliseconds without progress before the drive gives up
+void Drive::setDriveExitConditions(float settleVelocity, float largeError, float largeErrorTime, float stallProgress, float stallTime)
+{
+    driveDefaults.settleVelocity = settleVelocity;
+    driveDefaults.largeError = largeError;
+    driveDefaults.largeErrorTime = largeErrorTime;
+    driveDefaults.stallProgress = stallProgress;
+    driveDefaults.stallTime = stallTime;
+}
+
+/// @brief Sets the extra exit conditions for turns, 0 turns one off
+/// @param settleVelocity Degrees per second, the robot also has to be this slow inside the settle window
+/// @param largeError Degrees, a wider window that ends the turn once the robot has spent largeErrorTime in it
+/// @param largeErrorTime Milliseconds
+/// @param stallProgress Degrees the error has to shrink by every stallTime
+/// @param stallTime Milliseconds without progress before the turn gives up
+void Drive::setTurnExitConditions(float settleVelocity, float largeError, float largeErrorTime, float stallProgress, float stallTime)
+{
+    turnDefaults.settleVelocity = settleVelocity;
+    turnDefaults.largeError = largeError;
+    turnDefaults.largeErrorTime = largeErrorTime;
+    turnDefaults.stallProgress = stallProgress;
+    turnDefaults.stallTime = stallTime;
+}
+
+/// @brief Sets the feedforward for profiled drives
+/// @param kS Volts to get the robot moving
+/// @param kV Volts per inch/second
+/// @param kA Volts per inch/second^2
+void Drive::setDriveFeedforward(float kS, float kV, float kA)
+{
+    driveFeedforward = Feedforward(kS, kV, kA);
+    leftVelocity.setFeedforward(driveFeedforward);
+    rightVelocity.setFeedforward(driveFeedforward);
+}
+
+/// @brief Sets the free speed of the drive motor cartridge
+/// @param rpm 100 (red), 200 (green) or 600 (blue)
+void Drive::setCartridge(float rpm)
+{
+    kinematics.cartridgeRPM = rpm;
 }
 
+/// @brief Sets the feedback on each side's speed for driveVelocity, on top of
+/// the drive feedforward
+/// @param kP Volts per in/s of error
+/// @param kI Volts per inch of accumulated error
+/// @param integralLimit Most volts the integral term may add, 0 for no limit
+void Drive::setVelocityConstants(float kP, float kI, float integralLimit)
+{
+    leftVelocity.setGains(kP, kI, integralLimit);
+    rightVelocity.setGains(kP, kI, integralLimit);
+}
+
+/// @brief Sets the feedforward for profiled turns
+/// @param kS Volts to get the robot turning
+/// @param kV Volts per degree/second
+/// @param kA Volts per degree/second^2
+void Drive::setTurnFeedforward(float kS, float kV, float kA)
+{
+    turnFeedforward = Feedforward(kS, kV, kA);
+}
+
+/// @brief Sets the limits of the profile profiled drives follow
+/// @param maxVelocity Inches per second
+/// @param maxAcceleration Inches per second^2
+/// @param maxJerk Inches per second^3, 0 for a trapezoidal profile
+void Drive::setDriveProfile(float maxVelocity, float maxAcceleration, float maxJerk)
+{
+    driveProfile = ProfileLimits(maxVelocity, maxAcceleration, maxJerk);
+}
+
+/// @brief Takes the profile for a move from the route plan, or builds it if the plan has none
+/// @param distance Signed distance in inches or degrees
+/// @param limits The limits the move runs with
+/// @return The profile for the move
+MotionProfile Drive::planProfile(float distance, const ProfileLimits& limits)
+{
+    const MotionProfile* cached = routePlan ? routePlan->findProfile(distance, limits) : 0;
+    if(cached)
+        return *cached;
+    return MotionProfile(distance, limits);
+}
+
+/// @brief Sets the limits of the profile profiled turns follow
+/// @param maxVelocity Degrees per second
+/// @param maxAcceleration Degrees per second^2
+/// @param maxJerk Degrees per second^3, 0 for a trapezoidal profile
+void Drive::setTurnProfile(float maxVelocity, float maxAcceleration, float maxJerk)
+{
+    turnProfile = ProfileLimits(maxVelocity, maxAcceleration, maxJerk);
+}
 
 void Drive::arcade()
 {
@@ -121,8 +298,8 @@ void Drive::tank(){
 /// @return Returns the position in inches
 float Drive::getCurrentMotorPosition()
 {
-    float leftPosition = degToInches(leftDrive.position(degrees), wheelDiameter);
-    float rightPosition = degToInches(rightDrive.position(degrees), wheelDiameter);
+    float leftPosition = kinematics.motorDegreesToInches(leftDrive.position(degrees));
+    float rightPosition = kinematics.motorDegreesToInches(rightDrive.position(degrees));
 
     return (leftPosition + rightPosition) / 2;
 }
@@ -161,6 +338,69 @@ void Drive::driveMotors(float leftUnit, float rightUnit, MotorSpinType spinType)
         leftDrive.spin(forward, leftUnit, rpm);
         rightDrive.spin(forward, rightUnit, rpm);
     }
+    commandedLeft = spinType == VOLTS ? leftUnit : 0;
+    commandedRight = spinType == VOLTS ? rightUnit : 0;
+}
+
+/// @brief Gets the speed of the left side
+/// @return Returns the speed at the wheel in inches per second
+float Drive::getLeftSpeed()
+{
+    return kinematics.motorRPMToSpeed(leftDrive.velocity(rpm));
+}
+
+/// @brief Gets the speed of the right side
+/// @return Returns the speed at the wheel in inches per second
+float Drive::getRightSpeed()
+{
+    return kinematics.motorRPMToSpeed(rightDrive.velocity(rpm));
+}
+
+/// @brief Holds each side at a speed with the drive feedforward and the
+/// velocity feedback. Runs one update, call it once per motion loop cycle.
+/// @param leftSpeed Left side speed in inches per second
+/// @param rightSpeed Right side speed in inches per second
+void Drive::driveVelocity(float leftSpeed, float rightSpeed)
+{
+    driveVelocity(leftSpeed, rightSpeed, driveDefaults.maxVoltage);
+}
+
+/// @brief Holds each side at a speed with the drive feedforward and the
+/// velocity feedback. Runs one update, call it once per motion loop cycle.
+/// @param leftSpeed Left side speed in inches per second
+/// @param rightSpeed Right side speed in inches per second
+/// @param maxVoltage The most either side may get, the ratio between the sides is kept
+void Drive::driveVelocity(float leftSpeed, float rightSpeed, float maxVoltage)
+{
+    float left = leftVelocity.compute(leftSpeed, getLeftSpeed());
+    float right = rightVelocity.compute(rightSpeed, getRightSpeed());
+
+    float largest = fmax(fabs(left), fabs(right));
+    if(largest > maxVoltage)
+    {
+        left *= maxVoltage / largest;
+        right *= maxVoltage / largest;
+    }
+    driveMotors(left, right);
+}
+
+/// @brief Drives the chassis at a forward speed and turn rate, see driveVelocity
+/// @param linear Forward speed in inches per second
+/// @param angular Turn rate in degrees per second, clockwise positive
+void Drive::driveChassisVelocity(float linear, float angular)
+{
+    driveChassisVelocity(linear, angular, driveDefaults.maxVoltage);
+}
+
+/// @brief Drives the chassis at a forward speed and turn rate, see driveVelocity
+/// @param linear Forward speed in inches per second
+/// @param angular Turn rate in degrees per second, clockwise positive
+/// @param maxVoltage The most either side may get
+void Drive::driveChassisVelocity(float linear, float angular, float maxVoltage)
+{
+    float left, right;
+    kinematics.toWheelSpeeds(linear, angular, left, right);
+    driveVelocity(left, right, maxVoltage);
 }
 
 /// @brief Brakes the drivetrain 
@@ -190,17 +430,21 @@ void Drive::brake(bool left, bool right)
 /// @param type The type of brakeType
 void Drive::brake(bool left, bool right, brakeType type)
 {
-    if(left)
+    if(left){
         leftDrive.stop(type);
-    if(right)
+        commandedLeft = 0;
+    }
+    if(right){
         rightDrive.stop(type);
+        commandedRight = 0;
+    }
 }
 
 /// @brief Uses the drivetrain to drive the given distance in inches
 /// @param distance The distance to drive in inches
 void Drive::driveDistance(float distance)
 {
-    driveDistance(distance, driveMaxVoltage);
+    driveDistance(distance, driveDefaults.maxVoltage);
 }
 
 /// @brief Uses the drivetrain to drive the given distance in inches
@@ -210,28 +454,34 @@ void Drive::driveDistance(float distance, float maxVoltage)
 {
     // Creates PID objects for linear and angular output
     //float Kp, float Ki, float Kd, float settleError, float timeToSettle, float endTime
-    PID linearPID(driveKp, driveKi, driveKd, driveSettleError, driveTimeToSettle, driveEndTime);
-    PID angularPID(turnKp, turnKi, turnKd, turnSettleError, turnTimeToSettle, turnEndTime);
-    
-    updatePosition();
+    PID linearPID(driveKp, driveKi, driveKd, driveDefaults.settleError, driveDefaults.settleTime, driveDefaults.timeout);
+    PID angularPID(turnKp, turnKi, turnKd, turnDefaults.settleError, turnDefaults.settleTime, turnDefaults.timeout);
+    applyExits(linearPID, driveDefaults);
+    linearPID.setOutputLimit(maxVoltage);
+    angularPID.setOutputLimit(maxVoltage);
+
     // Sets the starting variables for the Position and Heading
     float startPosition = getCurrentMotorPosition();
-    float startHeading = inertial1.heading();
+    float startHeading = beginMotion().heading;
 
     // Updates the distance to match the current position of the robot
     distance += startPosition;
 
     //  Loops while the linear PID has not yet settled
-    while(!linearPID.isSettled())
-    {
-        updatePosition();
+    motionLoop.run([&]() -> bool {
+        if(linearPID.isSettled()){
+            lastExit = linearPID.getExitReason();
+            return false;
+        }
+
         // Updates the Error for the linear values and the angular values
-        float linearError = distance - getCurrentMotorPosition();
-        float angularError = degTo180(startHeading - inertial1.heading());
+        float position = getCurrentMotorPosition();
+        float drift = degTo180(inertial1.heading() - startHeading);
 
-        // Sets the linear output and angular output to the output of the error passed through the PID compute functions
-        float linearOutput = linearPID.compute(linearError);
-        float angularOutput = angularPID.compute(angularError);
+        // Sets the linear output and angular output to the output of the PID compute functions,
+        // the derivative is on the measurement so only the robot's own motion damps it
+        float linearOutput = linearPID.compute(distance, position);
+        float angularOutput = angularPID.compute(0, drift);
 
         // Clamps the values of the output to fit within the -12 to 12 volt limit of the vex motors
         linearOutput = clamp(linearOutput, -maxVoltage, maxVoltage);
@@ -239,13 +489,13 @@ void Drive::driveDistance(float distance, float maxVoltage)
 
         // Drives motors according to the linear Output and includes the linear Output to keep the robot in a straight path relative to is start heading
         driveMotors(linearOutput + angularOutput, linearOutput - angularOutput);
-        wait(10, msec);
-    }
+        return true;
+    });
+    endMotion(__func__, linearPID);
 
     
     // Stops the motors once PID has settled
     //brake();
-    updatePosition();
 }
 
 /// @brief Turns the robot a set amount of degrees
@@ -265,7 +515,7 @@ void Drive::turn(float turnDegrees, float maxVoltage){
 /// @param angle The angle to turn to in degrees (0 - 360)
 void Drive::turnToAngle(float angle)
 {
-    turnToAngle(angle, turnMaxVoltage);
+    turnToAngle(angle, MotionConstraints());
 }
 
 /// @brief Turns to an absolute specific angle
@@ -273,80 +523,245 @@ void Drive::turnToAngle(float angle)
 /// @param maxVoltage The max amount of voltage used to turn
 void Drive::turnToAngle(float angle, float maxVoltage)
 {
-    updatePosition();
-    angle = inTermsOfNegative180To180(angle);
-    PID turnPID(turnKp, turnKi, turnKd, turnSettleError, turnTimeToSettle, turnEndTime);
-    do
-    {
-        float error = inTermsOfNegative180To180(inertial1.heading()-angle);
-        float output = turnPID.compute(error);
-
-        //Minimum output threshold for turning
-        if(fabs(output) < 2.5)
-            if(output < 0)
-                output = -2.5;
-            else
-                output = 2.5;
-        else
-            output = clamp(output, -maxVoltage, maxVoltage);
+    turnToAngle(angle, MotionConstraints().withMaxVoltage(maxVoltage));
+}
 
-        driveMotors(-output, output);
-        task::sleep(10);
-    }while(!turnPID.isSettled());
-    brake();
-    updatePosition();
+/// @brief Turns to an absolute specific angle
+/// @param angle The angle to turn to in degrees (0 - 360)
+/// @param constraints Limits for this turn, unset fields use the turn defaults
+void Drive::turnToAngle(float angle, const MotionConstraints& constraints)
+{
+    runTurn(angle, turnKd, constraints);
 }
 
 void Drive::turnToAngleD(float angle, float maxVoltage, float turnKdUpdate)
 {
-    updatePosition();
+    runTurn(angle, turnKdUpdate, MotionConstraints().withMaxVoltage(maxVoltage));
+}
+
+void Drive::turnToAngleTime(float angle, float timeLimit, float maxVoltage)
+{
+    turnToAngle(angle, MotionConstraints().withTimeout(timeLimit).withMaxVoltage(maxVoltage));
+}
+
+/// @brief The one turn loop every turn command runs through
+/// @param angle The angle to turn to in degrees (0 - 360)
+/// @param Kd Derivative constant for this turn
+/// @param constraints Limits for this turn, unset fields use the turn defaults
+void Drive::runTurn(float angle, float Kd, const MotionConstraints& constraints)
+{
+    MotionConstraints limits = constraints.resolve(turnDefaults);
+    Pose start = beginMotion();
+
     angle = inTermsOfNegative180To180(angle);
-    PID turnPID(turnKp, turnKi, turnKdUpdate, turnSettleError, turnTimeToSettle, turnEndTime);
-    do
-    {
+    float startHeading = inertial1.heading();
+    float startError = fabs(inTermsOfNegative180To180(startHeading-angle));
+    // Clockwise degrees to turn
+    float goal = inTermsOfNegative180To180(angle-startHeading);
+    PID turnPID(turnKp, turnKi, Kd, limits.settleError, limits.settleTime, limits.timeout);
+    applyExits(turnPID, limits);
+    turnPID.setOutputLimit(limits.maxVoltage);
+
+    // Without setTurnProfile there is nothing to follow, it turns unprofiled
+    if(!turnProfile.isSet())
+        limits.profiled = false;
+    MotionProfile profile;
+    if(limits.profiled)
+        profile = planProfile(goal, turnProfile);
+    uint64_t startTime = timer::systemHighResolution();
+
+    motionLoop.run([&]() -> bool {
         float error = inTermsOfNegative180To180(inertial1.heading()-angle);
-        float output = turnPID.compute(error);
-
-        //Minimum output threshold for turning
-        if(fabs(output) < 2)
-            if(output < 0)
-                output = -2.5;
+        // The turn inside moveToPosition does not count towards its distance
+        if(motionCommand != MOTION_MOVE_TO)
+            reportProgress(startError - fabs(error), startError);
+        if(limits.exitPolicy == EXIT_CHAINED && fabs(error) < limits.exitError){
+            lastExit = EXITED_CHAINED;
+            return false;
+        }
+
+        float elapsed = (timer::systemHighResolution() - startTime) / 1000000.0;
+        bool profileDone = !limits.profiled || elapsed >= profile.getDuration();
+        float output;
+
+        // Clockwise degrees turned, from the wrapped error so it doesn't jump at 180
+        float turned = goal + error;
+        if(limits.profiled){
+            // Feedforward from the profile plus PID on how far behind it the robot is.
+            // Clockwise is positive here, the output below is positive counter-clockwise.
+            ProfilePoint target = profile.sample(elapsed);
+            output = -(turnFeedforward.compute(target.velocity, target.acceleration) + turnPID.compute(target.position, turned));
+            output = clamp(output, -limits.maxVoltage, limits.maxVoltage);
+        }
+        else{
+            output = -turnPID.compute(goal, turned);
+
+            //Minimum output threshold for turning
+            if(fabs(output) < limits.minVoltage)
+                if(output < 0)
+                    output = -limits.minVoltage;
+                else
+                    output = limits.minVoltage;
             else
-                output = 2.5;
-        else
-            output = clamp(output, -maxVoltage, maxVoltage);
+                output = clamp(output, -limits.maxVoltage, limits.maxVoltage);
+        }
 
         driveMotors(-output, output);
-        task::sleep(10);
-    }while(!turnPID.isSettled());
-    brake();
-    updatePosition();
+        return !motionFinished(turnPID, limits, profileDone);
+    });
+    endMotion(__func__, turnPID);
+
+    if(limits.exitPolicy == EXIT_CHAINED && !cancelRequested)
+        chainFrom(start.x, start.y, angle);
+    else
+        brake();
 }
 
-void Drive::turnToAngleTime(float angle, float timeLimit, float maxVoltage)
+/// @brief Turns to an angle by driving one side and locking the other
+/// @param angle The angle to turn to in degrees (0 - 360)
+/// @param side The side that drives
+void Drive::swingToAngle(float angle, SwingSide side){
+    swingToAngle(angle, side, MotionConstraints());
+}
+
+/// @brief Turns to an angle by driving one side and locking the other, the
+/// robot pivots around the locked wheels
+/// @param angle The angle to turn to in degrees (0 - 360)
+/// @param side The side that drives
+/// @param constraints Limits for this turn, unset fields use the turn defaults
+void Drive::swingToAngle(float angle, SwingSide side, const MotionConstraints& constraints){
+    float halfTrack = kinematics.trackWidth / 2;
+    if(side == SWING_LEFT)
+        runArc(angle, halfTrack, false, true, constraints);
+    else
+        runArc(angle, -halfTrack, true, false, constraints);
+}
+
+/// @brief Turns to an angle while driving along a circle
+/// @param angle The angle to turn to in degrees (0 - 360)
+/// @param radius Inches from the center of the robot to the center of the circle, negative drives it backwards
+void Drive::arcToAngle(float angle, float radius){
+    arcToAngle(angle, radius, MotionConstraints());
+}
+
+/// @brief Turns to an angle while driving along a circle, the corner of a
+/// route in one motion instead of a stop, a point turn and another stop
+/// @param angle The angle to turn to in degrees (0 - 360)
+/// @param radius Inches from the center of the robot to the center of the circle, negative drives it backwards
+/// @param constraints Limits for this turn, unset fields use the turn defaults
+void Drive::arcToAngle(float angle, float radius, const MotionConstraints& constraints){
+    if(radius == 0)
+        turnToAngle(angle, constraints);
+    else
+        runArc(angle, radius, false, false, constraints);
+}
+
+/// @brief The loop for swing and arc turns. The heading follows a turn
+/// profile and the velocity control drives the chassis along the arc at the
+/// matching speed, so the robot turns around a point radius inches to its side.
+/// The profile is slowed down so the outside wheels stay inside the drive
+/// limits. A radius of half the track width leaves one side still.
+/// @param angle The angle to turn to in degrees (0 - 360)
+/// @param radius Radius in inches. For arcs positive drives forward and negative backwards,
+/// for swings it is where the pivot is, positive to the right of the robot
+/// @param lockLeft Holds the left side instead of driving it
+/// @param lockRight Holds the right side instead of driving it
+/// @param constraints Limits for this turn, unset fields use the turn defaults. The timeout counts from the end of the profile.
+void Drive::runArc(float angle, float radius, bool lockLeft, bool lockRight, const MotionConstraints& constraints)
 {
-    updatePosition();
-    angle = inTermsOfNegative180To180(angle);
-    PID turnPID(turnKp, turnKi, turnKd, turnSettleError, turnTimeToSettle, timeLimit);
-    do
-    {
-        float error = inTermsOfNegative180To180(inertial1.heading()-angle);
-        float output = turnPID.compute(error);
+    MotionConstraints limits = constraints.resolve(turnDefaults);
+    Pose start = beginMotion();
 
-        //Minimum output threshold for turning
-        if(fabs(output) < 2)
-            if(output < 0)
-                output = -2.5;
-            else
-                output = 2.5;
+    angle = inTermsOfNegative180To180(angle);
+    float startHeading = inertial1.heading();
+    float startError = inTermsOfNegative180To180(angle - startHeading);
+
+    // The center of the arc stays on one side for the whole motion, so going
+    // past the heading backs up along the same arc
+    float centerOffset = radius;
+    if(!lockLeft && !lockRight && startError < 0)
+        centerOffset = -radius;
+
+    // Inches the outside wheels travel per degree of turn
+    float outsideInches = (fabs(centerOffset) + kinematics.trackWidth / 2) * (M_PI / 180);
+    ProfileLimits arcLimits = turnProfile;
+    arcLimits.maxVelocity = fmin(turnProfile.maxVelocity, driveProfile.maxVelocity / outsideInches);
+    arcLimits.maxAcceleration = fmin(turnProfile.maxAcceleration, driveProfile.maxAcceleration / outsideInches);
+    arcLimits.maxJerk = turnProfile.maxJerk > 0 && driveProfile.maxJerk > 0 ? fmin(turnProfile.maxJerk, driveProfile.maxJerk / outsideInches) : 0;
+    // Without setTurnProfile and setDriveProfile the profile is over from the start, the
+    // velocity control then only turns towards the heading and the turn timeout ends it
+    if(!arcLimits.isSet())
+        std::cout << "ARC WITHOUT A PROFILE, set the drive and turn profiles" << std::endl;
+    MotionProfile profile = planProfile(startError, arcLimits);
+    if(constraints.timeout <= 0)
+        limits.timeout = profile.getDuration() * 1000 + turnDefaults.timeout;
+    PID turnPID(turnKp, turnKi, turnKd, limits.settleError, limits.settleTime, limits.timeout);
+    applyExits(turnPID, limits);
+
+    if(lockLeft || lockRight)
+        brake(lockLeft, lockRight, hold);
+    uint64_t startTime = timer::systemHighResolution();
+
+    motionLoop.run([&]() -> bool {
+        // Clockwise positive
+        float error = inTermsOfNegative180To180(angle - inertial1.heading());
+        reportProgress(fabs(startError) - fabs(error), fabs(startError));
+        if(limits.exitPolicy == EXIT_CHAINED && fabs(error) < limits.exitError){
+            lastExit = EXITED_CHAINED;
+            return false;
+        }
+
+        // The PID only keeps the settle and timeout windows here
+        turnPID.compute(startError, startError - error);
+        float elapsed = (timer::systemHighResolution() - startTime) / 1000000.0;
+        if(motionFinished(turnPID, limits, elapsed >= profile.getDuration()))
+            return false;
+
+        ProfilePoint target = profile.sample(elapsed);
+        float turned = inTermsOfNegative180To180(inertial1.heading() - startHeading);
+        // A lagging heading only adds turn, the speed along the arc stays on the
+        // profile so the robot tightens the arc instead of running wide
+        float turnRate = target.velocity + ARC_KP * (target.position - turned);
+        float speed = target.velocity * (M_PI / 180) * centerOffset;
+        float leftSpeed, rightSpeed;
+        kinematics.toWheelSpeeds(speed, turnRate, leftSpeed, rightSpeed);
+
+        float left = leftVelocity.compute(leftSpeed, getLeftSpeed());
+        float right = rightVelocity.compute(rightSpeed, getRightSpeed());
+        float largest = fmax(fabs(left), fabs(right));
+        if(largest > limits.maxVoltage)
+        {
+            left *= limits.maxVoltage / largest;
+            right *= limits.maxVoltage / largest;
+        }
+
+        if(lockLeft){
+            rightDrive.spin(forward, right, volt);
+            commandedRight = right;
+        }
+        else if(lockRight){
+            leftDrive.spin(forward, left, volt);
+            commandedLeft = left;
+        }
         else
-            output = clamp(output, -maxVoltage, maxVoltage);
-
-        driveMotors(-output, output);
-        task::sleep(10);
-    }while(!turnPID.isSettled());
+            driveMotors(left, right);
+        return true;
+    });
+    endMotion(__func__, turnPID);
+
+    if(limits.exitPolicy == EXIT_CHAINED && !cancelRequested){
+        // The target is the start swung around the center of the arc by the turn
+        float startRad = degToRad(start.heading);
+        float centerX = start.x + centerOffset * cos(startRad);
+        float centerY = start.y - centerOffset * sin(startRad);
+        float turned = degToRad(startError);
+        float offsetX = start.x - centerX;
+        float offsetY = start.y - centerY;
+        chainFrom(centerX + offsetX * cos(turned) + offsetY * sin(turned),
+                  centerY - offsetX * sin(turned) + offsetY * cos(turned), angle);
+        return;
+    }
     brake();
-    updatePosition();
 }
 
 /// @brief Turns sharply to a specific location and moves to it
@@ -354,144 +769,260 @@ void Drive::turnToAngleTime(float angle, float timeLimit, float maxVoltage)
 /// @param desY Desired Y position
 
 void Drive::moveToPosition(float desX, float desY){
-    // Calculate the angle to turn to
-    float deltaX = desX - chassisOdometry.getXPosition();
-    float deltaY = desY - chassisOdometry.getYPosition();
+    moveToPosition(desX, desY, MotionConstraints());
+}
 
+/// @brief Turns sharply to a specific location and moves to it. With chained
+/// constraints the turn also exits early and flows into the drive, and the
+/// drive flows into whatever command comes next.
+/// @param desX Desired X position
+/// @param desY Desired Y position
+/// @param constraints Limits for the drive
+void Drive::moveToPosition(float desX, float desY, const MotionConstraints& constraints){
+    // Calculate the angle to turn to
+    Pose pose = getMotionStart();
+    float deltaX = desX - pose.x;
+    float deltaY = desY - pose.y;
 
     // Turn to the target angle
-    turnToPosition(desX, desY);
+    if(constraints.exitPolicy == EXIT_CHAINED)
+        turnToPosition(desX, desY, MotionConstraints().chained(CHAIN_TURN_EXIT));
+    else
+        turnToPosition(desX, desY);
+    if(cancelRequested)
+        return;
 
     // Calculate the distance to the target position
     float distance = sqrt(deltaX * deltaX + deltaY * deltaY);
 
     // Drive the calculated distance
-    driveDistanceWithOdom(distance);
+    driveDistanceWithOdom(distance, constraints);
 }
 
+/// @brief Drives to a position and ends facing a heading
+/// @param desX Desired X position
+/// @param desY Desired Y position
+/// @param desHeading Desired heading at the end in degrees
+void Drive::moveToPose(float desX, float desY, float desHeading){
+    moveToPose(desX, desY, desHeading, MotionConstraints());
+}
 
+/// @brief Drives to a position and ends facing a heading in one motion,
+/// turning and driving at the same time. The robot chases a carrot point set
+/// back from the target along the final heading by a share of the distance
+/// left, so it curves in and arrives already lined up. Close to the target the
+/// carrot is dropped and the heading PID holds the final heading. It only
+/// settles once the heading is inside the turn settle window as well.
+/// @param desX Desired X position
+/// @param desY Desired Y position
+/// @param desHeading Desired heading at the end in degrees
+/// @param constraints Limits for this move, unset fields use the drive defaults
+void Drive::moveToPose(float desX, float desY, float desHeading, const MotionConstraints& constraints){
+    MotionConstraints limits = constraints.resolve(driveDefaults);
+    beginMotion();
+
+    PID linearPID(driveKp, driveKi, driveKd, limits.settleError, limits.settleTime, limits.timeout);
+    applyExits(linearPID, limits);
+    PID angularPID(turnKp, turnKi, turnKd, turnDefaults.settleError, turnDefaults.settleTime, turnDefaults.timeout);
+    linearPID.setOutputLimit(limits.maxVoltage);
+    angularPID.setOutputLimit(limits.maxVoltage);
+
+    float desHeadingRad = degToRad(desHeading);
+    float startDistance = -1;
+    bool close = false;
+
+    motionLoop.run([&]() -> bool {
+        if(motionFinished(linearPID, limits))
+            return false;
+
+        Pose pose = chassisOdometry.getPose();
+        float headingRad = degToRad(pose.heading);
+        float dx = desX - pose.x;
+        float dy = desY - pose.y;
+        float distance = sqrt(dx*dx + dy*dy);
+
+        if(startDistance < 0)
+            startDistance = distance;
+        reportProgress(startDistance - distance, startDistance);
+
+        if(limits.exitPolicy == EXIT_CHAINED && distance < limits.exitError){
+            lastExit = EXITED_CHAINED;
+            return false;
+        }
+
+        // Once close it stays close, so the controller can't flip back and forth
+        if(distance < BOOMERANG_CLOSE)
+            close = true;
+
+        float linearError, angularError;
+        if(close){
+            // Distance to the pose along the current heading, negative once past it
+            double sine, cosine;
+            fastSinCos(headingRad, sine, cosine);
+            linearError = dx * sine + dy * cosine;
+            angularError = degTo180(desHeading - pose.heading);
+        }
+        else{
+            double sine, cosine;
+            fastSinCos(desHeadingRad, sine, cosine);
+            float carrotX = desX - BOOMERANG_LEAD * distance * sine;
+            float carrotY = desY - BOOMERANG_LEAD * distance * cosine;
+            float cx = carrotX - pose.x;
+            float cy = carrotY - pose.y;
+            angularError = degTo180(fastAtan2(cx, cy) * (180.0/M_PI) - pose.heading);
+            // Only the part of the way to the carrot the robot is facing
+            linearError = sqrt(cx*cx + cy*cy) * fastCos(degToRad(angularError));
+        }
 
-void Drive::driveDistanceWithOdom(float distance){
-    // Creates PID objects for linear and angular output
-    PID linearPID(driveKp, driveKi, driveKd, driveSettleError, driveTimeToSettle, driveEndTime);
-    PID angularPID(turnKp, turnKi, turnKd, turnSettleError, turnTimeToSettle, turnEndTime);
-
-    updatePosition();
-
-    // --- Starting pose (field coordinates & heading) ---
-    float startHeadingDeg = inertial1.heading();
-    float startHeadingRad = degToRad(startHeadingDeg);
-
-    // Unit forward direction based on starting heading
-    float dirX = sin(startHeadingRad);
-    float dirY = cos(startHeadingRad);
-
-    // Starting position in field coordinates
-    float startX = chassisOdometry.getXPosition();
-    float startY = chassisOdometry.getYPosition();
-
-    // Target point in field coordinates (distance along starting heading)
-    float targetX = startX + dirX * distance;
-    float targetY = startY + dirY * distance;
-
-    while (!linearPID.isSettled())
-    {
-        updatePosition();
-
-        // Odom-based pose
-        float curX = chassisOdometry.getXPosition();
-        float curY = chassisOdometry.getYPosition();
-
-        float dx = targetX - curX;
-        float dy = targetY - curY;
-
-        // Signed error along the original heading:
-        float linearError  = dx * dirX + dy * dirY;
-        float angularError = degTo180(startHeadingDeg - inertial1.heading());
-
-        float linearOutput  = linearPID.compute(linearError);
+        float linearOutput = linearPID.compute(linearError);
         float angularOutput = angularPID.compute(angularError);
+        // A pose needs the heading too, the distance alone settling is not enough
+        if(!close || fabs(angularError) >= turnDefaults.settleError)
+            linearPID.resetSettleTimer();
 
-        linearOutput  = clamp(linearOutput,  -driveMaxVoltage, driveMaxVoltage);
-        angularOutput = clamp(angularOutput, -driveMaxVoltage, driveMaxVoltage);
+        // Turning has priority, driving gets whatever voltage is left
+        angularOutput = clamp(angularOutput, -limits.maxVoltage, limits.maxVoltage);
+        float linearRoom = limits.maxVoltage - fabs(angularOutput);
+        linearOutput = clamp(linearOutput, -linearRoom, linearRoom);
+        if(fabs(linearOutput) < limits.minVoltage && !close)
+            linearOutput = linearError < 0 ? -limits.minVoltage : limits.minVoltage;
 
         driveMotors(linearOutput + angularOutput, linearOutput - angularOutput);
+        return true;
+    });
+    endMotion(__func__, linearPID);
 
-        updatePosition();
-        wait(10, msec);
+    if(limits.exitPolicy == EXIT_CHAINED && !cancelRequested){
+        chainFrom(desX, desY, desHeading);
+        return;
     }
 
-    // Make absolutely sure we stop
     brake();
-    driveMotors(0, 0);
-    updatePosition();
+    if(!cancelRequested)
+        driveMotors(0, 0);
 }
 
-void Drive::driveDistanceWithOdomSettle(float distance, float settleTime, float settleError){
-    // Creates PID objects for linear and angular output
-    PID linearPID(driveKp, driveKi, driveKd, settleError, settleTime, driveEndTime);
-    PID angularPID(turnKp, turnKi, turnKd, turnSettleError, turnTimeToSettle, turnEndTime);
-
-    updatePosition();
-
-    // --- Starting pose (field coordinates & heading) ---
-    float startHeadingDeg = inertial1.heading();
-    float startHeadingRad = degToRad(startHeadingDeg);
-
-    // Unit forward direction based on starting heading
-    float dirX = sin(startHeadingRad);
-    float dirY = cos(startHeadingRad);
-
-    // Starting position in field coordinates
-    float startX = chassisOdometry.getXPosition();
-    float startY = chassisOdometry.getYPosition();
+/// @brief Where the next motion starts from. After a chained exit this is the
+/// target of the previous motion instead of the current pose, so a chain of
+/// relative moves does not add up the error left over at every early exit.
+/// @return The start position and heading (degrees)
+Pose Drive::getMotionStart(){
+    if(chainPending)
+        return chainTarget;
+    Pose start = chassisOdometry.getPose();
+    start.heading = inertial1.heading();
+    return start;
+}
 
-    // Target point in field coordinates (distance along starting heading)
-    float targetX = startX + dirX * distance;
-    float targetY = startY + dirY * distance;
+/// @brief Common start of every motion loop. Waits out a motion running on
+/// another task, takes over any chain and clears the progress.
+/// @return The start position and heading (degrees)
+Pose Drive::beginMotion(){
+    waitForAsyncMotion();
+    motionStartTime = timer::systemHighResolution();
+    Pose start = getMotionStart();
+    chainPending = false;
+    reportProgress(0, 0);
+    lastExit = EXITED_NONE;
+    leftVelocity.reset();
+    rightVelocity.reset();
+    return start;
+}
 
-    while (!linearPID.isSettled())
-    {
-        updatePosition();
+/// @brief Reports a finished motion loop: overruns to the terminal, and how the motion
+/// went to the motion log if one is recording
+/// @param name The Drive function that ran the loop
+/// @param pid The controller that decided when the motion was done
+void Drive::endMotion(const char* name, PID& pid){
+    motionLoop.printStats(name);
+    if(!motionLog)
+        return;
+
+    uint64_t now = timer::systemHighResolution();
+    MotionRecord record;
+    record.name = name;
+    record.start = (motionStartTime - motionLog->getStartTime()) / 1000.0;
+    record.duration = (now - motionStartTime) / 1000.0;
+    if(pid.getTimeToWindow() >= 0)
+        record.settling = pid.getRunTime() - pid.getTimeToWindow();
+    else
+        record.settling = lastExit == EXITED_CHAINED ? 0 : pid.getTimeStalled();
+    record.error = pid.getError();
+    record.exit = lastExit;
+    Pose pose = chassisOdometry.getPose();
+    record.x = pose.x;
+    record.y = pose.y;
+    record.heading = pose.heading;
+    motionLog->record(record);
+}
 
-        // Odom-based pose
-        float curX = chassisOdometry.getXPosition();
-        float curY = chassisOdometry.getYPosition();
+/// @brief Records every motion that finishes into a log until called with 0, the log's start is now
+/// @param log The log to append to, 0 stops recording
+void Drive::recordMotions(MotionLog* log){
+    if(log)
+        log->setStartTime(timer::systemHighResolution());
+    motionLog = log;
+}
 
-        float dx = targetX - curX;
-        float dy = targetY - curY;
+/// @brief Leaves the motors running and records where the finished motion was
+/// headed, the next motion picks up from there
+void Drive::chainFrom(float x, float y, float heading){
+    chainTarget.x = x;
+    chainTarget.y = y;
+    chainTarget.heading = heading;
+    chainTarget.timestamp = timer::systemHighResolution();
+    chainPending = true;
+}
 
-        // Signed error along the original heading:
-        float linearError  = dx * dirX + dy * dirY;
-        float angularError = degTo180(startHeadingDeg - inertial1.heading());
 
-        float linearOutput  = linearPID.compute(linearError);
-        float angularOutput = angularPID.compute(angularError);
 
-        linearOutput  = clamp(linearOutput,  -driveMaxVoltage, driveMaxVoltage);
-        angularOutput = clamp(angularOutput, -driveMaxVoltage, driveMaxVoltage);
+/// @brief Drives straight along the starting heading using odometry
+/// @param distance The distance to drive in inches
+void Drive::driveDistanceWithOdom(float distance){
+    driveDistanceWithOdom(distance, MotionConstraints());
+}
 
-        driveMotors(linearOutput + angularOutput, linearOutput - angularOutput);
+/// @brief Drives straight using odometry, giving up after the time limit
+/// @param distance The distance to drive in inches
+/// @param timeLimit The maximum run time in milliseconds
+void Drive::driveDistanceWithOdomTime(float distance, float timeLimit){
+    driveDistanceWithOdom(distance, MotionConstraints().withTimeout(timeLimit));
+}
 
-        updatePosition();
-        wait(10, msec);
-    }
+/// @brief Drives straight using odometry, giving up after the time limit
+/// @param distance The distance to drive in inches
+/// @param timeLimit The maximum run time in milliseconds
+/// @param maxVoltage The max amount of voltage used to drive
+void Drive::driveDistanceWithOdomTime(float distance, float timeLimit, float maxVoltage){
+    driveDistanceWithOdom(distance, MotionConstraints().withTimeout(timeLimit).withMaxVoltage(maxVoltage));
+}
 
-    // Make absolutely sure we stop
-    brake();
-    driveMotors(0, 0);
-    updatePosition();
+/// @brief Drives straight using odometry with its own settle window
+/// @param distance The distance to drive in inches
+/// @param settleTime The time in milliseconds the error has to stay inside the window
+/// @param settleError The settle window in inches
+void Drive::driveDistanceWithOdomSettle(float distance, float settleTime, float settleError){
+    driveDistanceWithOdom(distance, MotionConstraints().withSettle(settleError, settleTime));
 }
 
-void Drive::driveDistanceWithOdomTime(float distance, float timeLimit){
-    // Creates PID objects for linear and angular output
-    PID linearPID(driveKp, driveKi, driveKd, driveSettleError, driveTimeToSettle, timeLimit);
-    PID angularPID(turnKp, turnKi, turnKd, turnSettleError, turnTimeToSettle, turnEndTime);
+/// @brief The one straight drive loop every odometry drive command runs through.
+/// The error is measured along the starting heading from the odometry pose and
+/// the inertial holds that heading.
+/// @param distance The distance to drive in inches
+/// @param constraints Limits for this move, unset fields use the drive defaults
+void Drive::driveDistanceWithOdom(float distance, const MotionConstraints& constraints){
+    MotionConstraints limits = constraints.resolve(driveDefaults);
 
-    updatePosition();
+    // Creates PID objects for linear and angular output
+    PID linearPID(driveKp, driveKi, driveKd, limits.settleError, limits.settleTime, limits.timeout);
+    applyExits(linearPID, limits);
+    PID angularPID(turnKp, turnKi, turnKd, turnDefaults.settleError, turnDefaults.settleTime, turnDefaults.timeout);
+    linearPID.setOutputLimit(limits.maxVoltage);
+    angularPID.setOutputLimit(limits.maxVoltage);
 
     // --- Starting pose (field coordinates & heading) ---
-    float startHeadingDeg = inertial1.heading();
+    Pose start = beginMotion();
+    float startHeadingDeg = start.heading;
     float startHeadingRad = degToRad(startHeadingDeg);
 
     // Unit forward direction based on starting heading
@@ -499,101 +1030,135 @@ void Drive::driveDistanceWithOdomTime(float distance, float timeLimit){
     float dirY = cos(startHeadingRad);
 
     // Starting position in field coordinates
-    float startX = chassisOdometry.getXPosition();
-    float startY = chassisOdometry.getYPosition();
+    float startX = start.x;
+    float startY = start.y;
 
     // Target point in field coordinates (distance along starting heading)
     float targetX = startX + dirX * distance;
     float targetY = startY + dirY * distance;
 
-    while (!linearPID.isSettled())
-    {
-        updatePosition();
+    // Without setDriveProfile there is nothing to follow, it drives unprofiled
+    if(!driveProfile.isSet())
+        limits.profiled = false;
+    MotionProfile profile;
+    if(limits.profiled)
+        profile = planProfile(distance, driveProfile);
+    uint64_t startTime = timer::systemHighResolution();
+
+    motionLoop.run([&]() -> bool {
+        float elapsed = (timer::systemHighResolution() - startTime) / 1000000.0;
+        bool profileDone = !limits.profiled || elapsed >= profile.getDuration();
+        if(motionFinished(linearPID, limits, profileDone))
+            return false;
 
         // Odom-based pose
-        float curX = chassisOdometry.getXPosition();
-        float curY = chassisOdometry.getYPosition();
+        Pose pose = chassisOdometry.getPose();
+        float curX = pose.x;
+        float curY = pose.y;
 
         float dx = targetX - curX;
         float dy = targetY - curY;
 
         // Signed error along the original heading:
         float linearError  = dx * dirX + dy * dirY;
-        float angularError = degTo180(startHeadingDeg - inertial1.heading());
-
-        float linearOutput  = linearPID.compute(linearError);
-        float angularOutput = angularPID.compute(angularError);
+        float drift = degTo180(inertial1.heading() - startHeadingDeg);
+
+        float traveled = distance - linearError;
+        reportProgress(distance < 0 ? -traveled : traveled, fabs(distance));
+
+        if(limits.exitPolicy == EXIT_CHAINED && fabs(linearError) < limits.exitError){
+            lastExit = EXITED_CHAINED;
+            return false;
+        }
+
+        float linearOutput;
+        if(limits.profiled){
+            // Feedforward from the profile plus PID on how far behind it the robot is
+            ProfilePoint target = profile.sample(elapsed);
+            linearOutput = driveFeedforward.compute(target.velocity, target.acceleration) + linearPID.compute(target.position, traveled);
+        }
+        else
+            linearOutput = linearPID.compute(distance, traveled);
+        float angularOutput = angularPID.compute(0, drift);
 
-        linearOutput  = clamp(linearOutput,  -driveMaxVoltage, driveMaxVoltage);
-        angularOutput = clamp(angularOutput, -driveMaxVoltage, driveMaxVoltage);
+        linearOutput  = clamp(linearOutput,  -limits.maxVoltage, limits.maxVoltage);
+        angularOutput = clamp(angularOutput, -limits.maxVoltage, limits.maxVoltage);
+        if(fabs(linearOutput) < limits.minVoltage && !limits.profiled)
+            linearOutput = linearError < 0 ? -limits.minVoltage : limits.minVoltage;
 
         driveMotors(linearOutput + angularOutput, linearOutput - angularOutput);
+        return true;
+    });
+    endMotion(__func__, linearPID);
 
-        updatePosition();
-        wait(10, msec);
+    if(limits.exitPolicy == EXIT_CHAINED && !cancelRequested){
+        chainFrom(targetX, targetY, startHeadingDeg);
+        return;
+    }
+
+    // A cancelled move is still at speed, hold instead of letting it coast
+    if(cancelRequested){
+        brake();
+        return;
     }
 
     // Make absolutely sure we stop
     brake();
     driveMotors(0, 0);
-    updatePosition();
 }
 
+/// @brief Checks the exit policy of a running motion
+/// @param pid The controller of the motion
+/// @param limits The resolved constraints of the motion
+/// @return Returns TRUE once the motion should stop
+bool Drive::motionFinished(PID& pid, const MotionConstraints& limits)
+{
+    return motionFinished(pid, limits, true);
+}
 
-void Drive::driveDistanceWithOdomTime(float distance, float timeLimit, float maxVoltage){
-    // Creates PID objects for linear and angular output
-    PID linearPID(driveKp, driveKi, driveKd, driveSettleError, driveTimeToSettle, timeLimit);
-    PID angularPID(turnKp, turnKi, turnKd, turnSettleError, turnTimeToSettle, turnEndTime);
-
-    updatePosition();
-
-    // --- Starting pose (field coordinates & heading) ---
-    float startHeadingDeg = inertial1.heading();
-    float startHeadingRad = degToRad(startHeadingDeg);
-
-    // Unit forward direction based on starting heading
-    float dirX = sin(startHeadingRad);
-    float dirY = cos(startHeadingRad);
-
-    // Starting position in field coordinates
-    float startX = chassisOdometry.getXPosition();
-    float startY = chassisOdometry.getYPosition();
-
-    // Target point in field coordinates (distance along starting heading)
-    float targetX = startX + dirX * distance;
-    float targetY = startY + dirY * distance;
-
-    while (!linearPID.isSettled())
+/// @brief Checks the exit policy of a running motion
+/// @param pid The controller of the motion
+/// @param limits The resolved constraints of the motion
+/// @param canSettle FALSE while a profile is still running, only a timeout or cancel ends the motion then
+/// @return Returns TRUE once the motion should stop
+bool Drive::motionFinished(PID& pid, const MotionConstraints& limits, bool canSettle)
+{
+    // The controller sees tracking error until the profile ends, its exit timers start there
+    if(!canSettle)
+        pid.resetExitTimers();
+
+    ExitReason reason;
+    if(cancelRequested)
+        reason = EXITED_CANCELLED;
+    else if(limits.exitPolicy == EXIT_ON_TIMEOUT)
     {
-        updatePosition();
-
-        // Odom-based pose
-        float curX = chassisOdometry.getXPosition();
-        float curY = chassisOdometry.getYPosition();
-
-        float dx = targetX - curX;
-        float dy = targetY - curY;
-
-        // Signed error along the original heading:
-        float linearError  = dx * dirX + dy * dirY;
-        float angularError = degTo180(startHeadingDeg - inertial1.heading());
-
-        float linearOutput  = linearPID.compute(linearError);
-        float angularOutput = angularPID.compute(angularError);
-
-        linearOutput  = clamp(linearOutput,  -maxVoltage, maxVoltage);
-        angularOutput = clamp(angularOutput, -maxVoltage, maxVoltage);
+        // Pushing into something, a stall is the only early way out
+        if(limits.timeout > 0 && pid.getRunTime() > limits.timeout)
+            reason = EXITED_TIMEOUT;
+        else
+            reason = pid.checkExit() == EXITED_STALLED ? EXITED_STALLED : EXITED_NONE;
+    }
+    else if(!canSettle)
+        reason = limits.timeout > 0 && pid.getRunTime() > limits.timeout ? EXITED_TIMEOUT : EXITED_NONE;
+    else
+        reason = pid.checkExit();
 
-        driveMotors(linearOutput + angularOutput, linearOutput - angularOutput);
+    if(reason == EXITED_NONE)
+        return false;
 
-        updatePosition();
-        wait(10, msec);
-    }
+    lastExit = reason;
+    std::cout << exitReasonName(reason) << "-----------------" << std::endl;
+    return true;
+}
 
-    // Make absolutely sure we stop
-    brake();
-    driveMotors(0, 0);
-    updatePosition();
+/// @brief Passes the exit conditions of a move on to its controller
+/// @param pid The controller that decides when the move is done
+/// @param limits The resolved constraints of the move
+void Drive::applyExits(PID& pid, const MotionConstraints& limits)
+{
+    pid.setSettleVelocity(limits.settleVelocity);
+    pid.setLargeErrorExit(limits.largeError, limits.largeErrorTime);
+    pid.setStallExit(limits.stallProgress, limits.stallTime);
 }
 
 
@@ -601,11 +1166,12 @@ void Drive::driveDistanceWithOdomTime(float distance, float timeLimit, float max
 
 void Drive::moveable(){
     //updates odom and printx x and y position
+    startOdometry();
     while (true) {
         brake(coast);
-        updatePosition();
-        float x = chassisOdometry.getXPosition();
-        float y = chassisOdometry.getYPosition();
+        Pose pose = chassisOdometry.getPose();
+        float x = pose.x;
+        float y = pose.y;
         // float x = rotation1.position(degrees);
         // float y = rotation2.position(degrees);
         // std::cout << "X: " << x << ", Y: " << y << std::endl;
@@ -623,107 +1189,816 @@ void Drive::moveable(){
 
 
 void Drive::turnToPosition(float desX, float desY){
-    updatePosition();
-    float deltaX = desX-chassisOdometry.getXPosition();
-    float deltaY = desY-chassisOdometry.getYPosition();
-    float angle = atan2(deltaX, deltaY) * (180.0/M_PI);
-    turnToAngle(angle);
-    updatePosition();
+    turnToPosition(desX, desY, MotionConstraints());
+}
+
+void Drive::turnToPosition(float desX, float desY, const MotionConstraints& constraints){
+    Pose pose = getMotionStart();
+    float deltaX = desX-pose.x;
+    float deltaY = desY-pose.y;
+    float angle = fastAtan2(deltaX, deltaY) * (180.0/M_PI);
+    turnToAngle(angle, constraints);
 }
 
-/// @brief Turns along a set curve
+/// @brief Drives along a curve without stopping
 /// @param curX The current X position of the robot
 /// @param curY The current Y position of the robot
 /// @param midX The X position of the middle point of the curve
 /// @param midY The Y position of the middle point of the curve
 /// @param desX The desired ending X position
 /// @param desY The desired ending Y position
-/// @param numPts The number of points along the curve to go to
+/// @param numPts The number of points along the curve
 void Drive::bezierTurn(float curX, float curY, float midX, float midY, float desX, float desY, int numPts){
-    float* pts = new float[numPts+1];
-    float nextX, nextY;
-    
-    //Populate the t-values (0-1)
-    pts[numPts] = 1;
-    for(int i=0;i<numPts;i++){
-        pts[i] = (1.0/static_cast<float>(numPts+1)) * i;
+    Path path(curX, curY);
+    path.addQuadratic(midX, midY, desX, desY, numPts+1);
+    followPath(path);
+}
+
+/// @brief Sets the distance between the left and right wheels
+/// @param trackWidth Track width in inches
+void Drive::setTrackWidth(float trackWidth)
+{
+    kinematics.trackWidth = trackWidth;
+}
+
+/// @brief Sets how much the two vertical pod odometry trusts the inertial sensor over the pods for heading
+/// @param weight Share of the gap closed every update, 0 uses the pods alone, 1 the inertial sensor alone
+void Drive::setOdomGyroWeight(float weight)
+{
+    chassisOdometry.setGyroWeight(weight);
+}
+
+/// @brief Uses the geometry measured by tools/odomfit. Call before startOdometry.
+/// The drive wheel size and track width also go to the kinematics when they are set.
+/// @param profile The measured geometry, usually ODOM_CALIBRATION from OdomCalibration.h
+void Drive::setOdomProfile(const OdomProfile& profile)
+{
+    if(profile.driveWheelDiameter > 0)
+        kinematics.wheelDiameter = profile.driveWheelDiameter;
+    if(profile.trackWidth > 0)
+        kinematics.trackWidth = profile.trackWidth;
+
+    switch(odomType){
+        case NO_ODOM:
+        {
+            // The drive encoders are the pods
+            float wheel = kinematics.wheelDiameter * kinematics.wheelRatio;
+            float halfTrack = kinematics.trackWidth / 2;
+            OdomProfile motors = {wheel, wheel, 0, 0, halfTrack, -halfTrack, 0, 0};
+            chassisOdometry.setProfile(motors);
+            break;
+        }
+        case TWO_VERTICAL:
+        case TWO_AT_45:
+            chassisOdometry.setProfile(profile);
+            break;
+        default:
+            break;
     }
+}
 
-    //Calculate X and Y values along the curve based on pts[i] and move to that position
-    for(int i=0;i<numPts+1;i++){
-        nextX = (pow(1-pts[i], 2)*curX) + (2*(1-pts[i])*pts[i]*midX) + (pow(pts[i], 2)*desX);
-        nextY = (pow(1-pts[i], 2)*curY) + (2*(1-pts[i])*pts[i]*midY) + (pow(pts[i], 2)*desY);  
-        moveToPosition(nextX, nextY);
+/// @brief Drives the scripted straights and spins tools/odomfit fits the geometry from, and logs the raw
+/// pod, drive encoder and inertial readings to a CSV file on the SD card. Needs about 5 ft clear in front.
+/// The straights are measured by the drive encoders, tape the real length of each one for the fitter.
+/// @param filename CSV file to write
+void Drive::calibrateOdometry(const char* filename)
+{
+    std::string log = "segment,kind,target,time,rotation1,rotation2,left,right,inertial\n";
+    int segment = 0;
+    for(int i = 0; i < CALIBRATION_STRAIGHTS; i++)
+    {
+        logCalibrationSegment(log, segment++, false, CALIBRATION_DISTANCE);
+        logCalibrationSegment(log, segment++, false, -CALIBRATION_DISTANCE);
     }
+    for(int i = 0; i < CALIBRATION_SPINS; i++)
+    {
+        logCalibrationSegment(log, segment++, true, CALIBRATION_SPIN);
+        logCalibrationSegment(log, segment++, true, -CALIBRATION_SPIN);
+    }
+    brake(coast);
+
+    std::ofstream file(filename);
+    file << log;
+    file.close();
+    std::cout << "odometry calibration: " << segment << " segments written to " << filename << std::endl;
+}
 
-    delete [] pts;
+/// @brief Runs one calibration segment and logs every motion loop cycle, through the hold at the end
+/// @param log CSV text the samples are added to
+/// @param segment Index of the segment
+/// @param spin True spins clockwise by target degrees, false drives target inches
+/// @param target Inches or degrees, negative goes backwards or counterclockwise
+void Drive::logCalibrationSegment(std::string& log, int segment, bool spin, float target)
+{
+    float startLeft = leftDrive.position(degrees);
+    float startRight = rightDrive.position(degrees);
+    float startRotation = inertial1.rotation(degrees);
+    float direction = target > 0 ? 1 : -1;
+    float moving = 0, holding = 0;
+    char line[160];
+
+    motionLoop.start();
+    while(holding < CALIBRATION_PAUSE)
+    {
+        float left = leftDrive.position(degrees);
+        float right = rightDrive.position(degrees);
+        float rotation = inertial1.rotation(degrees);
+        snprintf(line, sizeof(line), "%d,%s,%.1f,%.0f,%.3f,%.3f,%.3f,%.3f,%.3f\n", segment, spin ? "spin" : "straight",
+            target, moving + holding, rotation1.position(degrees), rotation2.position(degrees), left, right, rotation);
+        log += line;
+
+        float progress = spin ? rotation - startRotation
+            : kinematics.motorDegreesToInches((left - startLeft + right - startRight) / 2);
+        if(holding > 0 || progress * direction >= fabs(target) || moving > CALIBRATION_TIMEOUT)
+        {
+            if(holding == 0)
+                brake(hold);
+            holding += motionLoop.getPeriod();
+        }
+        else
+        {
+            float volts = CALIBRATION_VOLTAGE * direction;
+            driveMotors(volts, spin ? -volts : volts);
+            moving += motionLoop.getPeriod();
+        }
+        motionLoop.waitForNextCycle();
+    }
+}
+
+/// @brief Sets the pure pursuit lookahead range. The lookahead grows with
+/// speed from the minimum to the maximum.
+/// @param minLookahead Lookahead when stopped in inches
+/// @param maxLookahead Lookahead at full speed in inches
+void Drive::setLookahead(float minLookahead, float maxLookahead)
+{
+    this->minLookahead = minLookahead;
+    this->maxLookahead = maxLookahead;
+}
+
+/// @brief Follows a path the route's planner built ahead of the match, see usePlan
+/// @param index The path's place in the plan, in the order the planner added them
+/// @return Returns FALSE without moving if the plan doesn't have the path
+bool Drive::followPlannedPath(int index)
+{
+    return followPlannedPath(index, MotionConstraints(), false);
 }
 
+/// @brief Follows a path the route's planner built ahead of the match, see usePlan
+/// @param index The path's place in the plan, in the order the planner added them
+/// @param constraints Limits for this move, unset fields use the drive defaults
+/// @param backwards Drives the path with the back of the robot leading
+/// @return Returns FALSE without moving if the plan doesn't have the path, the
+/// route then builds the path itself and calls followPath
+bool Drive::followPlannedPath(int index, const MotionConstraints& constraints, bool backwards)
+{
+    if(!routePlan || index < 0 || index >= routePlan->pathCount())
+    {
+        std::cout << "NO PLANNED PATH " << index << ", building it on the spot" << std::endl;
+        return false;
+    }
+    followPath(routePlan->path(index), constraints, backwards);
+    return true;
+}
+
+/// @brief Follows a path with pure pursuit
+/// @param path The path to follow, starting near the robot
+void Drive::followPath(const Path& path)
+{
+    followPath(path, MotionConstraints(), false);
+}
+
+/// @brief Follows a path with pure pursuit
+/// @param path The path to follow, starting near the robot
+/// @param constraints Limits for this move, unset fields use the drive defaults
+void Drive::followPath(const Path& path, const MotionConstraints& constraints)
+{
+    followPath(path, constraints, false);
+}
+
+/// @brief Follows a path in one continuous motion with pure pursuit. Every
+/// cycle the robot steers on the arc through a goal point on the path one
+/// lookahead ahead of it, and the lookahead stretches with speed so it cuts
+/// less at low speed and does not weave at high speed. The drive PID on the
+/// distance left along the path brings it to a stop at the end.
+/// @param path The path to follow, starting near the robot
+/// @param constraints Limits for this move, unset fields use the drive defaults
+/// @param backwards Drives the path with the back of the robot leading
+void Drive::followPath(const Path& path, const MotionConstraints& constraints, bool backwards)
+{
+    MotionConstraints limits = constraints.resolve(driveDefaults);
+    Pose start = beginMotion();
+    if(path.size() < 2)
+        return;
+
+    PID linearPID(driveKp, driveKi, driveKd, limits.settleError, limits.settleTime, limits.timeout);
+    applyExits(linearPID, limits);
+    linearPID.setOutputLimit(limits.maxVoltage);
+
+    float closestIndex = 0, goalIndex = 0;
+    float lastX = start.x, lastY = start.y, speed = 0;
+
+    motionLoop.run([&]() -> bool {
+        if(motionFinished(linearPID, limits))
+            return false;
+
+        Pose pose = chassisOdometry.getPose();
+        float headingRad = degToRad(pose.heading + (backwards ? 180 : 0));
+
+        // Measured speed in inches per second for the adaptive lookahead
+        float moved = sqrt((pose.x - lastX)*(pose.x - lastX) + (pose.y - lastY)*(pose.y - lastY));
+        speed += 0.3 * (moved / motionLoop.getDt() - speed);
+        lastX = pose.x;
+        lastY = pose.y;
+        float radius = clamp(minLookahead + LOOKAHEAD_GAIN * speed, minLookahead, maxLookahead);
+
+        closestIndex = path.closest(pose.x, pose.y, closestIndex);
+        if(goalIndex < closestIndex)
+            goalIndex = closestIndex;
+        float goalX, goalY;
+        path.lookahead(pose.x, pose.y, radius, goalIndex, goalX, goalY);
+
+        // Negative once the robot passes the end
+        float travelled = path.distanceAt(closestIndex);
+        float remaining = path.length() - travelled;
+        reportProgress(travelled, path.length());
+
+        if(limits.exitPolicy == EXIT_CHAINED && remaining < limits.exitError){
+            lastExit = EXITED_CHAINED;
+            return false;
+        }
+
+        // Goal point relative to the robot, forward along the heading and to its right
+        float dx = goalX - pose.x;
+        float dy = goalY - pose.y;
+        double sine, cosine;
+        fastSinCos(headingRad, sine, cosine);
+        float lateral = dx * cosine - dy * sine;
+        float distanceSquared = dx*dx + dy*dy;
+        float curvature = 2 * lateral / distanceSquared;
+
+        // Too close to the end for the arc to mean anything, just finish straight
+        if(remaining < minLookahead / 2 || distanceSquared < 1)
+            curvature = 0;
+
+        // Slows down for the end of the path and for tight curves. A chained path runs
+        // through at full voltage, the PID still runs for its timeout and stall exits.
+        float voltage = linearPID.compute(path.length(), travelled);
+        if(limits.exitPolicy == EXIT_CHAINED)
+            voltage = limits.maxVoltage;
+        float curveLimit = limits.maxVoltage / (1 + fabs(curvature) * CURVE_SLOWDOWN);
+        voltage = clamp(voltage, -curveLimit, curveLimit);
+        if(fabs(voltage) < limits.minVoltage)
+            voltage = remaining < 0 ? -limits.minVoltage : limits.minVoltage;
+
+        float left = voltage * (1 + curvature * kinematics.trackWidth / 2);
+        float right = voltage * (1 - curvature * kinematics.trackWidth / 2);
+
+        // Keeps the ratio between the sides when one would pass the limit
+        float largest = fmax(fabs(left), fabs(right));
+        if(largest > limits.maxVoltage)
+        {
+            left *= limits.maxVoltage / largest;
+            right *= limits.maxVoltage / largest;
+        }
+
+        if(backwards)
+            driveMotors(-right, -left);
+        else
+            driveMotors(left, right);
+        return true;
+    });
+    endMotion(__func__, linearPID);
+
+    if(limits.exitPolicy == EXIT_CHAINED && !cancelRequested){
+        const PathPoint& end = path.back();
+        const PathPoint& beforeEnd = path[path.size() - 2];
+        float endHeading = fastAtan2(end.x - beforeEnd.x, end.y - beforeEnd.y) * (180.0/M_PI);
+        chainFrom(end.x, end.y, endHeading + (backwards ? 180 : 0));
+        return;
+    }
+
+    brake();
+    if(!cancelRequested)
+        driveMotors(0, 0);
+}
+
+/// @brief Follows a trajectory baked by tools/trajgen
+/// @param trajectory A table from Trajectories.h
+void Drive::followTrajectory(const Trajectory& trajectory)
+{
+    followTrajectory(trajectory, MotionConstraints());
+}
+
+/// @brief Plays back a trajectory baked by tools/trajgen. Every tick the
+/// velocity control holds the speed and turn rate the table asks for, and a RAMSETE
+/// correction pulls the robot back onto the table's pose when it falls behind
+/// or drifts off the line. Once the table runs out, the drive and turn PIDs
+/// settle it on the last point. The robot should start on the first point.
+/// @param trajectory A table from Trajectories.h
+/// @param constraints Limits for this move, unset fields use the drive defaults. The timeout counts from the end of the table.
+void Drive::followTrajectory(const Trajectory& trajectory, const MotionConstraints& constraints)
+{
+    MotionConstraints limits = constraints.resolve(driveDefaults);
+    beginMotion();
+    if(trajectory.length < 1)
+        return;
+
+    PID linearPID(driveKp, driveKi, driveKd, limits.settleError, limits.settleTime, limits.timeout);
+    applyExits(linearPID, limits);
+    PID angularPID(turnKp, turnKi, turnKd, turnDefaults.settleError, turnDefaults.settleTime, turnDefaults.timeout);
+    linearPID.setOutputLimit(limits.maxVoltage);
+    angularPID.setOutputLimit(limits.maxVoltage);
+
+    // Length of the table, for progress
+    float total = 0;
+    for(int i = 0; i < trajectory.length; i++)
+        total += fabs(trajectory.points[i].velocity) * trajectory.dt;
+
+    const TrajectoryPoint& last = trajectory.points[trajectory.length - 1];
+    float duration = trajectory.duration();
+    int index = 0;
+    float traveled = 0;
+    uint64_t startTime = timer::systemHighResolution();
+
+    motionLoop.run([&]() -> bool {
+        float elapsed = (timer::systemHighResolution() - startTime) / 1000000.0;
+        bool tableDone = elapsed >= duration;
+        if(motionFinished(linearPID, limits, tableDone))
+            return false;
+        if(tableDone && elapsed > duration + TRAJECTORY_END_TIME / 1000.0){
+            lastExit = EXITED_TIMEOUT;
+            return false;
+        }
+
+        while(index < trajectory.length - 1 && (index + 1) * trajectory.dt <= elapsed)
+        {
+            index++;
+            traveled += fabs(trajectory.points[index].velocity) * trajectory.dt;
+        }
+        reportProgress(traveled, total);
+
+        if(limits.exitPolicy == EXIT_CHAINED && tableDone){
+            lastExit = EXITED_CHAINED;
+            return false;
+        }
+
+        const TrajectoryPoint& target = trajectory.points[index];
+        Pose pose = chassisOdometry.getPose();
+
+        // Error in the robot frame, forward along the heading and to its left
+        float headingRad = degToRad(pose.heading);
+        float dx = target.x - pose.x;
+        float dy = target.y - pose.y;
+        double sine, cosine;
+        fastSinCos(headingRad, sine, cosine);
+        float forwardError = dx * sine + dy * cosine;
+        float leftError = -dx * cosine + dy * sine;
+        float headingError = degTo180(target.heading - pose.heading);
+
+        if(!tableDone)
+        {
+            // RAMSETE works counter-clockwise, the headings here are clockwise
+            float angleError = degToRad(-headingError);
+            float velocity = target.velocity;
+            float omega = -target.curvature * velocity;
+            float gain = 2 * RAMSETE_ZETA * sqrt(omega * omega + RAMSETE_B * velocity * velocity);
+            double angleSine, angleCosine;
+            fastSinCos(angleError, angleSine, angleCosine);
+            float sinc = fabs(angleError) < 0.001 ? 1 : angleSine / angleError;
+
+            float v = velocity * angleCosine + gain * forwardError;
+            float w = omega + gain * angleError + RAMSETE_B * velocity * sinc * leftError;
+
+            // Back to the clockwise turn rate driveChassisVelocity takes
+            driveChassisVelocity(v, -w * (180.0/M_PI), limits.maxVoltage);
+            return true;
+        }
+
+        float linearOutput = linearPID.compute(forwardError);
+        float angularOutput = angularPID.compute(headingError);
+        float left = linearOutput + angularOutput;
+        float right = linearOutput - angularOutput;
+
+        // Keeps the ratio between the sides when one would pass the limit
+        float largest = fmax(fabs(left), fabs(right));
+        if(largest > limits.maxVoltage)
+        {
+            left *= limits.maxVoltage / largest;
+            right *= limits.maxVoltage / largest;
+        }
+
+        driveMotors(left, right);
+        return true;
+    });
+    endMotion(__func__, linearPID);
+
+    if(limits.exitPolicy == EXIT_CHAINED && !cancelRequested){
+        chainFrom(last.x, last.y, last.heading);
+        return;
+    }
+
+    brake();
+    if(!cancelRequested)
+        driveMotors(0, 0);
+}
+
+/// @brief Starts tracking the pose on its own high priority task.
+/// The pods refresh every 5 ms, so the task samples at that rate and the pose
+/// stays valid through waits in the autons and during driver control.
+/// Motion code only reads the pose, it never updates it.
+void Drive::startOdometry()
+{
+    if(odometryRunning)
+        return;
+    odometryRunning = true;
+    task(odometryTask, this, task::taskPriorityHigh);
+}
+
+/// @brief Stops the odometry task after its current update
+void Drive::stopOdometry()
+{
+    odometryRunning = false;
+}
+
+int Drive::odometryTask(void* chassis)
+{
+    Drive* drive = static_cast<Drive*>(chassis);
+    ControlLoop odometryLoop(5);
+    while(drive->odometryRunning)
+    {
+        if(drive->resetRequested)
+        {
+            drive->applyPosition(drive->resetX, drive->resetY, drive->resetHeading);
+            drive->resetRequested = false;
+        }
+        else
+            drive->updatePosition();
+        odometryLoop.waitForNextCycle();
+    }
+    return 0;
+}
+
+/// @brief Reads the odometry sensors once and integrates them into the pose
 void Drive::updatePosition(){
+    SensorSample sample = readSensors();
+    integrateSensors(sample);
+    if(sensorLog){
+        Pose pose = chassisOdometry.getPose();
+        logSample(sample, pose.x, pose.y, pose.heading, 0);
+    }
+    if(cardLog && (++cardCycle & 1) == 0)
+        logState(sample);
+}
+
+/// @brief Reads every sensor the odometry and the pose estimator use, once
+/// @return Returns the readings stamped now, with the drive's last voltage command
+SensorSample Drive::readSensors(){
+    SensorSample sample;
+    sample.time = timer::systemHighResolution();
+    sample.pods[0] = rotation1.position(degrees);
+    sample.pods[1] = rotation2.position(degrees);
+    sample.leftMotor = leftDrive.position(degrees);
+    sample.rightMotor = rightDrive.position(degrees);
+    sample.inertialHeading = inertial1.heading();
+    sample.inertialRotation = inertial1.rotation(degrees);
+    sample.leftVolts = commandedLeft;
+    sample.rightVolts = commandedRight;
+    sample.x = 0;
+    sample.y = 0;
+    sample.heading = 0;
+    sample.flags = 0;
+    return sample;
+}
+
+/// @brief Integrates one sensor read into the pose. Everything the update depends
+/// on is in the sample, so a recorded run replays through here bit for bit.
+/// @param sample Readings from readSensors or a SensorLog
+void Drive::integrateSensors(const SensorSample& sample){
+    if(estimatorEnabled){
+        updateEstimator(sample);
+        return;
+    }
     switch(odomType){
-        float left, right, heading;
         case NO_ODOM:
-            left = leftDrive.position(degrees);
-            right = rightDrive.position(degrees);
-            heading = inertial1.heading();
-            chassisOdometry.updatePositionTwoForward(right, left, heading);
+            chassisOdometry.updatePositionTwoVertical(sample.leftMotor, sample.rightMotor, sample.inertialHeading);
             break;
         case HORIZONTAL_AND_VERTICAL:
-            left = rotation1.position(degrees);
-            right = rotation2.position(degrees);
-            heading = inertial1.heading();
-            chassisOdometry.updatePositionOneForward(left, right, heading);
+            chassisOdometry.updatePositionOneForward(sample.pods[0], sample.pods[1], sample.inertialHeading);
             break;
         case TWO_VERTICAL:
-            left = rotation1.position(degrees);
-            right = rotation2.position(degrees);
-            heading = inertial1.heading();
-            chassisOdometry.updatePositionTwoForward(right, left, heading);
+            chassisOdometry.updatePositionTwoVertical(sample.pods[0], sample.pods[1], sample.inertialHeading);
             break;
         case TWO_AT_45:
-            left = rotation1.position(degrees);
-            right = rotation2.position(degrees);
-            heading = inertial1.heading();
-            chassisOdometry.updatePositionTwoAt45(left, right, heading);
+            chassisOdometry.updatePositionTwoAt45(sample.pods[0], sample.pods[1], sample.inertialHeading);
             break;
     }
 }
 
+/// @brief Records every odometry update and pose reset into a log until called with 0.
+/// Only the samples are kept in memory, save the log once the run is over. The log's
+/// start is now, the simulator's SIM_REPLAY lines it up with the start of autonomous.
+/// @param log The log to append to, 0 stops recording
+void Drive::recordSensors(SensorLog* log){
+    if(log)
+        log->setStartTime(timer::systemHighResolution());
+    sensorLog = log;
+}
+
+/// @brief Logs the odometry state to the SD card at 100 Hz, every other odometry cycle, until
+/// called with 0. The log only buffers, start it first so its task writes the records out.
+/// @param log The card log to write to, 0 stops logging
+void Drive::logToCard(CardLog* log){
+    if(log)
+        cardChannel = log->addChannel("drive", "x,y,heading,pod1,pod2,leftMotor,rightMotor,inertialHeading,inertialRotation,leftVolts,rightVolts");
+    cardLog = log;
+}
+
+/// @brief Copies the pose and the sensor reads behind it into the card log
+void Drive::logState(const SensorSample& sample){
+    Pose pose = chassisOdometry.getPose();
+    float state[11] = {pose.x, pose.y, pose.heading, (float)sample.pods[0], (float)sample.pods[1],
+        (float)sample.leftMotor, (float)sample.rightMotor, (float)sample.inertialHeading,
+        (float)sample.inertialRotation, sample.leftVolts, sample.rightVolts};
+    cardLog->log(cardChannel, state, 11);
+}
+
+/// @brief Stamps a sample with the pose it produced and appends it to the sensor log
+void Drive::logSample(SensorSample& sample, float x, float y, float heading, uint32_t flags){
+    sample.x = x;
+    sample.y = y;
+    sample.heading = heading;
+    sample.flags = flags;
+    sensorLog->setSource(odomType, estimatorEnabled);
+    sensorLog->record(sample);
+}
+
 // void Drive::setPosition(float x, float y, float heading){
 //     chassisOdometry.setPosition(x, y, heading);
 // }
 
 
+/// @brief Resets the pose. While the odometry task is running the reset is
+/// handed to it and this waits one odometry cycle for it to take effect.
 void Drive::setPosition(float x, float y, float heading){
+    if(!odometryRunning){
+        applyPosition(x, y, heading);
+        return;
+    }
+    resetX = x;
+    resetY = y;
+    resetHeading = heading;
+    resetRequested = true;
+    while(resetRequested && odometryRunning)
+        wait(1, msec);
+    if(resetRequested){
+        resetRequested = false;
+        applyPosition(x, y, heading);
+    }
+}
+
+void Drive::applyPosition(float x, float y, float heading){
+    inertial1.setHeading(heading, degrees);
+    SensorSample sample = readSensors();
+    resetToSensors(x, y, heading, sample);
+    if(sensorLog)
+        logSample(sample, x, y, heading, SENSOR_SAMPLE_RESET);
+}
+
+/// @brief Resets the pose and takes the sensor baselines from one read
+/// @param x inches
+/// @param y inches
+/// @param heading degrees
+/// @param sample Readings from readSensors or a SensorLog, taken after the inertial was set to heading
+void Drive::resetToSensors(float x, float y, float heading, const SensorSample& sample){
     // Reset odom pose
     chassisOdometry.setPosition(x, y, heading);
-    inertial1.setHeading(heading, degrees);
+    if(estimatorEnabled){
+        configureEstimator();
+        estimator.reset(x, y, heading, sample.inertialRotation);
+    }
 
     // Sync odom encoder baselines with the actual sensors
     switch (odomType) {
         case NO_ODOM:
             // Using drive motors as odom
-            chassisOdometry.setForwardRightDegrees(rightDrive.position(degrees));
-            chassisOdometry.setForwardLeftDegrees(leftDrive.position(degrees));
+            chassisOdometry.setForwardRightDegrees(sample.rightMotor);
+            chassisOdometry.setForwardLeftDegrees(sample.leftMotor);
             chassisOdometry.setLateralDegrees(0);
             break;
 
         case HORIZONTAL_AND_VERTICAL:
-            // Using rotation1 and rotation2
-            chassisOdometry.setForwardLeftDegrees(rotation1.position(degrees));
-            chassisOdometry.setLateralDegrees(rotation2.position(degrees));
-            // If you have a second forward sensor, set it here too
+            // rotation1 is the forward pod and rotation2 the lateral one
+            chassisOdometry.setForwardRightDegrees(sample.pods[0]);
+            chassisOdometry.setLateralDegrees(sample.pods[1]);
             break;
 
+        case TWO_VERTICAL:
         case TWO_AT_45:
-            // Whatever sensors you're using in this mode
-            // Example (if both are vertical tracking wheels):
-            chassisOdometry.setForwardRightDegrees(rotation1.position(degrees));
-            chassisOdometry.setForwardLeftDegrees(rotation2.position(degrees));
+            // rotation1 is the left pod and rotation2 the right one
+            chassisOdometry.setForwardLeftDegrees(sample.pods[0]);
+            chassisOdometry.setForwardRightDegrees(sample.pods[1]);
             chassisOdometry.setLateralDegrees(0);
             break;
 
         default:
             break;
     }
-}
\ No newline at end of file
+}
+
+/// @brief Switches between the pose estimator and the single-source odometry.
+/// Call before startOdometry, the estimator starts from the current pose.
+/// @param enabled True fuses every sensor, false goes back to the odometry for the odom type
+void Drive::usePoseEstimator(bool enabled)
+{
+    if(enabled && !estimatorEnabled){
+        Pose pose = chassisOdometry.getPose();
+        configureEstimator();
+        estimator.reset(pose.x, pose.y, pose.heading, inertial1.rotation(degrees));
+    }
+    estimatorEnabled = enabled;
+}
+
+/// @brief Fuses a GPS sensor into the pose estimator. Its readings have to be in the
+/// same frame as setPosition, so the autons need to set their start in field coordinates.
+/// @param sensor The GPS, 0 stops using it
+/// @param standardDeviation Noise of its x and y in inches
+void Drive::useGPS(gps* sensor, float standardDeviation)
+{
+    gpsSensor = sensor;
+    gpsDeviation = standardDeviation;
+}
+
+/// @brief Hands an absolute position to the pose estimator, from any task. It is fused on the
+/// next odometry update, or thrown out if it is more than 3 sigma from the estimate.
+/// @param x inches
+/// @param y inches
+/// @param standardDeviation inches
+void Drive::addPositionMeasurement(float x, float y, float standardDeviation)
+{
+    measuredX = x;
+    measuredY = y;
+    measuredDeviation = standardDeviation;
+    measurementPending = true;
+}
+
+/// @brief Gives the estimator the current sensor geometry
+void Drive::configureEstimator()
+{
+    estimator.setDrive(kinematics.motorDegreesToInches(1), kinematics.trackWidth);
+    switch(odomType){
+        case TWO_VERTICAL:
+        case TWO_AT_45:
+            estimator.setPods(chassisOdometry.getProfile(), true, true);
+            break;
+        case HORIZONTAL_AND_VERTICAL:
+        {
+            // rotation1 faces forward and rotation2 sideways, levers as updatePositionOneForward takes them
+            OdomProfile pods = {chassisOdometry.forwardRightWheelDiameter, chassisOdometry.lateralWheelDiameter, 0, 90,
+                -chassisOdometry.forwardRightRotationDistance, -chassisOdometry.lateralRotationDistance, 0, 0};
+            estimator.setPods(pods, true, true);
+            break;
+        }
+        default:
+            estimator.setPods(chassisOdometry.getProfile(), false, false);
+            break;
+    }
+}
+
+/// @brief Runs one pose estimator step and publishes the result
+/// @param sample Readings from readSensors or a SensorLog
+void Drive::updateEstimator(const SensorSample& sample)
+{
+    EstimatorReadings readings;
+    readings.time = sample.time;
+    readings.pods[0] = sample.pods[0];
+    readings.pods[1] = sample.pods[1];
+    readings.leftMotor = sample.leftMotor;
+    readings.rightMotor = sample.rightMotor;
+    readings.inertialRotation = sample.inertialRotation;
+    estimator.update(readings);
+
+    // Only new GPS reads, the same one fused twice would count double
+    if(gpsSensor && gpsSensor->quality() >= GPS_MIN_QUALITY){
+        float x = gpsSensor->xPosition(inches);
+        float y = gpsSensor->yPosition(inches);
+        if(x != lastGpsX || y != lastGpsY)
+            estimator.correctPosition(x, y, gpsDeviation);
+        lastGpsX = x;
+        lastGpsY = y;
+    }
+    if(measurementPending){
+        estimator.correctPosition(measuredX, measuredY, measuredDeviation);
+        measurementPending = false;
+    }
+
+    chassisOdometry.setEstimate(estimator.getPose());
+}
+
+/// @brief Drives straight on the motion task and returns straight away
+/// @param distance The distance to drive in inches
+MotionHandle Drive::driveDistanceWithOdomAsync(float distance){
+    return startAsync(MOTION_DRIVE, distance, 0, 0, MotionConstraints());
+}
+
+MotionHandle Drive::driveDistanceWithOdomAsync(float distance, const MotionConstraints& constraints){
+    return startAsync(MOTION_DRIVE, distance, 0, 0, constraints);
+}
+
+/// @brief Turns on the motion task and returns straight away
+/// @param angle The angle to turn to in degrees (0 - 360)
+MotionHandle Drive::turnToAngleAsync(float angle){
+    return startAsync(MOTION_TURN, angle, 0, 0, MotionConstraints());
+}
+
+MotionHandle Drive::turnToAngleAsync(float angle, const MotionConstraints& constraints){
+    return startAsync(MOTION_TURN, angle, 0, 0, constraints);
+}
+
+/// @brief Turns and drives to a position on the motion task and returns straight away
+/// @param desX Desired X position
+/// @param desY Desired Y position
+MotionHandle Drive::moveToPositionAsync(float desX, float desY){
+    return startAsync(MOTION_MOVE_TO, desX, desY, 0, MotionConstraints());
+}
+
+MotionHandle Drive::moveToPositionAsync(float desX, float desY, const MotionConstraints& constraints){
+    return startAsync(MOTION_MOVE_TO, desX, desY, 0, constraints);
+}
+
+/// @brief Drives to a pose on the motion task and returns straight away
+/// @param desX Desired X position
+/// @param desY Desired Y position
+/// @param desHeading Desired heading at the end in degrees
+MotionHandle Drive::moveToPoseAsync(float desX, float desY, float desHeading){
+    return startAsync(MOTION_MOVE_TO_POSE, desX, desY, desHeading, MotionConstraints());
+}
+
+MotionHandle Drive::moveToPoseAsync(float desX, float desY, float desHeading, const MotionConstraints& constraints){
+    return startAsync(MOTION_MOVE_TO_POSE, desX, desY, desHeading, constraints);
+}
+
+/// @brief Hands a motion to a new task. The chassis runs one motion at a time,
+/// so this first waits for the previous async motion to end.
+MotionHandle Drive::startAsync(MotionCommand command, float a, float b, float c, const MotionConstraints& constraints){
+    waitForAsyncMotion();
+
+    asyncMotion.command = command;
+    asyncMotion.a = a;
+    asyncMotion.b = b;
+    asyncMotion.c = c;
+    asyncMotion.constraints = constraints;
+    cancelRequested = false;
+    reportProgress(0, 0);
+
+    motionsStarted = motionsStarted + 1;
+    MotionHandle handle(this, motionsStarted);
+    task(asyncMotionTask, this);
+    return handle;
+}
+
+int Drive::asyncMotionTask(void* chassis){
+    Drive* drive = static_cast<Drive*>(chassis);
+    AsyncMotion motion = drive->asyncMotion;
+    drive->asyncOwner = this_thread::get_id();
+    drive->motionCommand = motion.command;
+
+    switch(motion.command){
+        case MOTION_DRIVE:
+            drive->driveDistanceWithOdom(motion.a, motion.constraints);
+            break;
+        case MOTION_TURN:
+            drive->turnToAngle(motion.a, motion.constraints);
+            break;
+        case MOTION_MOVE_TO:
+            drive->moveToPosition(motion.a, motion.b, motion.constraints);
+            break;
+        case MOTION_MOVE_TO_POSE:
+            drive->moveToPose(motion.a, motion.b, motion.c, motion.constraints);
+            break;
+        default:
+            break;
+    }
+
+    drive->motionCommand = MOTION_NONE;
+    drive->asyncOwner = -1;
+    drive->cancelRequested = false;
+    drive->motionsFinished = drive->motionsStarted;
+    return 0;
+}
+
+/// @brief Cancels the running async motion, it brakes and its handle reports CANCELLED.
+/// Does nothing when no async motion is running, a stray cancel would otherwise end the
+/// next blocking motion on its first check.
+void Drive::cancelMotion(){
+    if(motionsFinished != motionsStarted)
+        cancelRequested = true;
+}
+
+/// @brief Blocks any task other than the motion task until the running async
+/// motion has ended, so a blocking call never fights it for the motors
+void Drive::waitForAsyncMotion(){
+    if(motionsFinished == motionsStarted || this_thread::get_id() == asyncOwner)
+        return;
+    while(motionsFinished != motionsStarted)
+        wait(10, msec);
+}
@@ -0,0 +1,130 @@
+#include "FastMath.h"
+#include <math.h>
+
+// Points around the circle in the sine table, a power of two so the index wraps with a mask
+static const int SINE_POINTS = 256;
+static const int QUARTER = SINE_POINTS / 4;
+
+// 2 pi / SINE_POINTS split in two (Cody-Waite). The first part has 26 bits so
+// k * STEP_HIGH is exact for any k the reduction sees, the second is the rest of
+// the step worked out to 60 digits
+static const double STEP_HIGH = 0.024543692357838153839111328125;
+static const double STEP_LOW = 2.4833210583637807e-10;
+static const double STEPS_PER_RADIAN = SINE_POINTS / (2.0 * M_PI);
+
+// Past this many steps the reduction loses precision and libm takes over
+static const double REDUCTION_LIMIT = 4e7;
+
+// Points on [0, 1] in the arctangent table, 0 and 1 included
+static const int ATAN_POINTS = 64;
+
+static double sineTable[SINE_POINTS + QUARTER];
+static double atanTable[ATAN_POINTS + 1];
+static volatile bool tablesFilled = false;
+
+/// @brief Fills the tables on the first call rather than in a static constructor,
+/// which another file's static constructor could run before. Two tasks filling
+/// them at once write the same values, so no lock is needed.
+static void fillTables()
+{
+    for(int i = 0; i < SINE_POINTS + QUARTER; i++)
+        sineTable[i] = sin(2.0 * M_PI * i / SINE_POINTS);
+    for(int i = 0; i <= ATAN_POINTS; i++)
+        atanTable[i] = atan((double)i / ATAN_POINTS);
+    tablesFilled = true;
+}
+
+/// @brief Splits an angle into a table index and the remainder from that point
+/// @return Returns false when the angle is too large (or not a number) to reduce
+static bool reduce(double radians, int& index, double& remainder)
+{
+    double steps = radians * STEPS_PER_RADIAN;
+    if(!(fabs(steps) < REDUCTION_LIMIT))
+        return false;
+    if(!tablesFilled)
+        fillTables();
+    int k = (int)(steps + (steps < 0 ? -0.5 : 0.5));
+    remainder = (radians - k * STEP_HIGH) - k * STEP_LOW;
+    index = k & (SINE_POINTS - 1);
+    return true;
+}
+
+/// @brief sin and cos of an angle under half a table step, first dropped terms r^9/9! and r^8/8!
+static void remainderSinCos(double r, double& sine, double& cosine)
+{
+    double r2 = r * r;
+    sine = r * (1.0 - r2 * (1.0 / 6.0) * (1.0 - r2 * (1.0 / 20.0) * (1.0 - r2 * (1.0 / 42.0))));
+    cosine = 1.0 - r2 * 0.5 * (1.0 - r2 * (1.0 / 12.0) * (1.0 - r2 * (1.0 / 30.0)));
+}
+
+/// @brief sin and cos of the same angle, cheaper than both on their own
+/// @param radians Angle in radians
+/// @param sine Set to sin(radians)
+/// @param cosine Set to cos(radians)
+void fastSinCos(double radians, double& sine, double& cosine)
+{
+    int index;
+    double r;
+    if(!reduce(radians, index, r))
+    {
+        sine = sin(radians);
+        cosine = cos(radians);
+        return;
+    }
+    double sr, cr;
+    remainderSinCos(r, sr, cr);
+    double st = sineTable[index], ct = sineTable[index + QUARTER];
+    // Angle sum, the table point plus the remainder
+    sine = st * cr + ct * sr;
+    cosine = ct * cr - st * sr;
+}
+
+double fastSin(double radians)
+{
+    int index;
+    double r;
+    if(!reduce(radians, index, r))
+        return sin(radians);
+    double sr, cr;
+    remainderSinCos(r, sr, cr);
+    return sineTable[index] * cr + sineTable[index + QUARTER] * sr;
+}
+
+double fastCos(double radians)
+{
+    int index;
+    double r;
+    if(!reduce(radians, index, r))
+        return cos(radians);
+    double sr, cr;
+    remainderSinCos(r, sr, cr);
+    return sineTable[index + QUARTER] * cr - sineTable[index] * sr;
+}
+
+/// @brief The ratio of the smaller side to the larger is looked up to the
+/// nearest table point c, then atan(z) = atan(c) + atan((z - c) / (1 + z c))
+/// with the second angle under 1/128 rad, first dropped term t^9/9
+double fastAtan2(double y, double x)
+{
+    double ax = fabs(x), ay = fabs(y);
+    bool steep = ay > ax;
+    double small = steep ? ax : ay;
+    double large = steep ? ay : ax;
+    if(!(large > 0) || isinf(large))
+        return atan2(y, x);
+    if(!tablesFilled)
+        fillTables();
+
+    double z = small / large;
+    int index = (int)(z * ATAN_POINTS + 0.5);
+    double c = index * (1.0 / ATAN_POINTS);
+    double t = (small - c * large) / (large + c * small);
+    double t2 = t * t;
+    double angle = atanTable[index] + t * (1.0 - t2 * (1.0 / 3.0 - t2 * (1.0 / 5.0 - t2 * (1.0 / 7.0))));
+
+    if(steep)
+        angle = M_PI / 2 - angle;
+    if(x < 0)
+        angle = M_PI - angle;
+    return signbit(y) ? -angle : angle;
+}
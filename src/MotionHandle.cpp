@@ -0,0 +1,52 @@
+#include "MotionHandle.h"
+#include "Drive.h"
+
+// How often the waits check on the motion task, matches the motion loop period
+static const int POLL_MS = 10;
+
+/// @brief Checks if the motion has ended, by finishing or by being cancelled
+/// @return Returns TRUE once the motion task is done with it
+bool MotionHandle::isDone()
+{
+    if(drive == 0)
+        return true;
+    return drive->getMotionsFinished() >= id;
+}
+
+/// @brief Checks if this is the motion the chassis is running right now
+/// @return Returns TRUE while the motion is running
+bool MotionHandle::isRunning()
+{
+    return !isDone() && drive->getMotionsStarted() == id;
+}
+
+/// @brief Blocks until the motion has ended
+void MotionHandle::waitUntilDone()
+{
+    while(!isDone())
+        wait(POLL_MS, msec);
+}
+
+/// @brief Blocks until the chassis has covered the distance or the motion has ended
+/// @param distance Inches along a drive, or degrees through a turn
+void MotionHandle::waitUntilDistance(float distance)
+{
+    while(!isDone() && !(isRunning() && drive->getMotionTraveled() >= distance))
+        wait(POLL_MS, msec);
+}
+
+/// @brief Blocks until the given share of the motion is done or the motion has ended
+/// @param progress Fraction of the motion (0 - 1)
+void MotionHandle::waitUntilProgress(float progress)
+{
+    while(!isDone() && !(isRunning() && drive->getMotionProgress() >= progress))
+        wait(POLL_MS, msec);
+}
+
+/// @brief Stops the motion at its next cycle and brakes the chassis.
+/// Does nothing if the motion already ended.
+void MotionHandle::cancel()
+{
+    if(isRunning())
+        drive->cancelMotion();
+}
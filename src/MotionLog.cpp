@@ -0,0 +1,29 @@
+#include "MotionLog.h"
+
+/// @brief Appends a finished motion, dropped once the log is full
+/// @param record How the motion went
+void MotionLog::record(const MotionRecord& record)
+{
+    if(count >= MOTION_LOG_SIZE)
+    {
+        dropped++;
+        return;
+    }
+    records[count] = record;
+    count = count + 1;
+}
+
+/// @brief Prints one line per motion to the terminal, the serial console on the brain
+void MotionLog::print() const
+{
+    printf("%3s %-26s %9s %9s %9s %9s  %-12s\n", "#", "motion", "start s", "time ms", "settle ms", "error", "exit");
+    float total = 0, settling = 0;
+    for(uint32_t i = 0; i < count; i++)
+    {
+        const MotionRecord& r = records[i];
+        printf("%3lu %-26s %9.3f %9.0f %9.0f %9.3f  %-12s\n", (unsigned long)i + 1, r.name, r.start / 1000, r.duration, r.settling, r.error, exitReasonName(r.exit));
+        total += r.duration;
+        settling += r.settling;
+    }
+    printf("%lu motions, %.0f ms moving, %.0f ms of it settling\n", (unsigned long)count, total, settling);
+}
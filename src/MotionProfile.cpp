@@ -0,0 +1,157 @@
+#include "MotionProfile.h"
+#include <math.h>
+
+/// @brief Constructor for an empty profile that is already finished
+MotionProfile::MotionProfile()
+{
+    distance = 0;
+    direction = 1;
+    jerk = 0;
+    peakVelocity = 0;
+    peakAcceleration = 0;
+    jerkTime = holdTime = accelTime = accelDistance = cruiseTime = totalTime = 0;
+}
+
+/// @brief Constructor
+/// @param distance Signed distance to cover in inches or degrees
+/// @param limits Velocity, acceleration and jerk limits in the same unit
+MotionProfile::MotionProfile(float distance, const ProfileLimits& limits)
+{
+    this->direction = distance < 0 ? -1 : 1;
+    this->distance = fabs(distance);
+    this->jerk = limits.maxJerk;
+
+    // No limits to plan with, 0 / 0 would make every time NaN
+    if(!limits.isSet())
+    {
+        peakVelocity = 0;
+        peakAcceleration = 0;
+        jerkTime = holdTime = accelTime = accelDistance = cruiseTime = totalTime = 0;
+        return;
+    }
+
+    shape(limits.maxVelocity, limits);
+
+    // Too short to reach the velocity limit, find the peak velocity whose speed
+    // up and slow down exactly fill the distance
+    if(2 * accelDistance > this->distance)
+    {
+        float low = 0, high = limits.maxVelocity;
+        for(int i = 0; i < 30; i++)
+        {
+            float middle = (low + high) / 2;
+            shape(middle, limits);
+            if(2 * accelDistance > this->distance)
+                high = middle;
+            else
+                low = middle;
+        }
+        shape(low, limits);
+    }
+
+    cruiseTime = peakVelocity > 0 ? (this->distance - 2 * accelDistance) / peakVelocity : 0;
+    totalTime = 2 * accelTime + cruiseTime;
+}
+
+/// @brief Works out the speed up from rest to a peak velocity
+void MotionProfile::shape(float velocity, const ProfileLimits& limits)
+{
+    peakVelocity = velocity;
+    if(jerk <= 0)
+    {
+        // Trapezoid, the acceleration steps straight to its limit
+        peakAcceleration = limits.maxAcceleration;
+        jerkTime = 0;
+        holdTime = velocity / peakAcceleration;
+    }
+    else if(velocity * jerk >= limits.maxAcceleration * limits.maxAcceleration)
+    {
+        peakAcceleration = limits.maxAcceleration;
+        jerkTime = peakAcceleration / jerk;
+        holdTime = velocity / peakAcceleration - jerkTime;
+    }
+    else
+    {
+        // The acceleration never reaches its limit before it has to ramp down again
+        jerkTime = sqrt(velocity / jerk);
+        peakAcceleration = jerk * jerkTime;
+        holdTime = 0;
+    }
+    accelTime = 2 * jerkTime + holdTime;
+    accelDistance = velocity * accelTime / 2;
+}
+
+/// @brief Samples the speed up from rest
+/// @param t Seconds since the start, 0 to accelTime
+ProfilePoint MotionProfile::speedUp(float t) const
+{
+    ProfilePoint point;
+    float j = jerkTime > 0 ? jerk : 0;
+
+    // End of the jerk ramp
+    float v1 = j * jerkTime * jerkTime / 2;
+    float p1 = j * jerkTime * jerkTime * jerkTime / 6;
+
+    if(t < jerkTime)
+    {
+        point.acceleration = j * t;
+        point.velocity = j * t * t / 2;
+        point.position = j * t * t * t / 6;
+    }
+    else if(t < jerkTime + holdTime)
+    {
+        float tau = t - jerkTime;
+        point.acceleration = peakAcceleration;
+        point.velocity = v1 + peakAcceleration * tau;
+        point.position = p1 + v1 * tau + peakAcceleration * tau * tau / 2;
+    }
+    else
+    {
+        float tau = t - jerkTime - holdTime;
+        float v2 = v1 + peakAcceleration * holdTime;
+        float p2 = p1 + v1 * holdTime + peakAcceleration * holdTime * holdTime / 2;
+        point.acceleration = peakAcceleration - j * tau;
+        point.velocity = v2 + peakAcceleration * tau - j * tau * tau / 2;
+        point.position = p2 + v2 * tau + peakAcceleration * tau * tau / 2 - j * tau * tau * tau / 6;
+    }
+    return point;
+}
+
+/// @brief Samples the profile
+/// @param t Seconds since the start of the motion
+/// @return The position, velocity and acceleration to be at, signed like the distance
+ProfilePoint MotionProfile::sample(float t) const
+{
+    ProfilePoint point;
+    if(t <= 0)
+    {
+        point.position = point.velocity = point.acceleration = 0;
+        return point;
+    }
+    else if(t >= totalTime)
+    {
+        point.position = distance;
+        point.velocity = point.acceleration = 0;
+    }
+    else if(t < accelTime)
+        point = speedUp(t);
+    else if(t < accelTime + cruiseTime)
+    {
+        point.position = accelDistance + peakVelocity * (t - accelTime);
+        point.velocity = peakVelocity;
+        point.acceleration = 0;
+    }
+    else
+    {
+        // The slow down is the speed up played backwards from the end
+        ProfilePoint mirror = speedUp(totalTime - t);
+        point.position = distance - mirror.position;
+        point.velocity = mirror.velocity;
+        point.acceleration = -mirror.acceleration;
+    }
+
+    point.position *= direction;
+    point.velocity *= direction;
+    point.acceleration *= direction;
+    return point;
+}
@@ -1,5 +1,32 @@
 #include "PID.h"
 
+// Gains were tuned with a 10 ms loop, so the integral and derivative terms are
+// kept in "per 10 ms" units and rescaled by the measured period. The same
+// constants then behave the same at any loop rate.
+static const float NOMINAL_DT = 10;
+
+// Low-pass time constant on the error rate used by the settle velocity, in
+// milliseconds. Longer than the derivative filter, the odometry error steps
+// with every pod update and only the trend matters here.
+static const float RATE_FILTER = 50;
+
+/// @brief Name of an exit reason for the terminal
+/// @param reason What ended the motion
+/// @return Returns the name
+const char* exitReasonName(ExitReason reason)
+{
+    switch(reason)
+    {
+        case EXITED_SETTLED:     return "SETTLED";
+        case EXITED_LARGE_ERROR: return "LARGE ERROR";
+        case EXITED_STALLED:     return "STALLED";
+        case EXITED_TIMEOUT:     return "TIMEOUT";
+        case EXITED_CANCELLED:   return "CANCELLED";
+        case EXITED_CHAINED:     return "CHAINED";
+        default:                 return "RUNNING";
+    }
+}
+
 /// @brief Constructor
 /// @param Kp Proportional
 /// @param Ki Integral
@@ -42,81 +69,183 @@ PID::PID(float Kp, float Ki, float Kd, float settleError, float timeToSettle, fl
     this->endTime = endTime;
 }
 
-/// @brief Uses the given error a puts it through a PID formula the output is the result
+/// @brief Uses the given error a puts it through a PID formula the output is the result.
+/// For errors worked out from geometry with no setpoint of their own, such as the
+/// distance to a moving carrot point. Where there is a setpoint and a measurement use
+/// compute(setpoint, measurement), the derivative here follows the error and kicks when
+/// the setpoint moves.
 /// @param error The desired position minus the current position
 /// @return the output of the PID formula
 float PID::compute(float error)
 {
-    // float time = deltaTime;
-    static int i = 0;
-    float time = 10;
-    integral += error;
+    // A fixed setpoint of zero with the error as the negative measurement
+    return compute(0, -error);
+}
 
-    derivative = error - prevError;
+/// @brief Runs one PID update using the time since the last call.
+/// The derivative is taken on the measurement, not the error, so moving the
+/// setpoint does not kick the output, and is low-pass filtered.
+/// @param setpoint The desired position
+/// @param measurement The current position
+/// @return the output of the PID formula
+float PID::compute(float setpoint, float measurement)
+{
+    float error = setpoint - measurement;
+
+    float time = deltaTime.updateTime();
+    if(firstSample || time <= 0)
+        time = NOMINAL_DT;
+    float ticks = time / NOMINAL_DT;
 
     // Checks if the error has crossed 0, and if it has, it eliminates the integral term.
-    if ((error > 0 && prevError < 0) || (error < 0 && prevError > 0)){ 
-        integral = 0; 
+    if ((error > 0 && prevError < 0) || (error < 0 && prevError > 0)){
+        integral = 0;
+    }
+
+    float lastIntegral = integral;
+    integral += error * ticks;
+    if(integralLimit > 0)
+        integral = clamp(integral, -integralLimit, integralLimit);
+    else if(outputLimit > 0 && Ki != 0)
+        integral = clamp(integral, -outputLimit / fabs(Ki), outputLimit / fabs(Ki));
+
+    float rawDerivative = firstSample ? 0 : -(measurement - prevMeasurement) / ticks;
+    if(derivativeFilter > 0 && !firstSample)
+        derivative += (time / (derivativeFilter + time)) * (rawDerivative - derivative);
+    else
+        derivative = rawDerivative;
+
+    float unlimited = Kp*error + Ki*integral + Kd*derivative;
+    float limited = unlimited;
+    if(outputLimit > 0)
+        limited = clamp(limited, -outputLimit, outputLimit);
+
+    // Anti-windup, stop integrating while the output is saturated in the direction of the error
+    if(limited != unlimited && ((error > 0) == (unlimited > 0)))
+        integral = lastIntegral;
+
+    if(slewRate > 0 && !firstSample)
+    {
+        float maxStep = slewRate * time / 1000.0;
+        limited = clamp(limited, output - maxStep, output + maxStep);
+    }
+
+    output = limited;
+
+    // How fast the error is changing, for the settle velocity
+    if(firstSample)
+        errorRate = 0;
+    else
+        errorRate += (time / (RATE_FILTER + time)) * ((error - prevError) * 1000.0 / time - errorRate);
+
+    // The stall timer restarts every time the error beats its best by the progress step.
+    // Inside the settle window, or closer to the target than a progress step, the robot
+    // has arrived rather than stalled, so the settle timer decides and the stall timer waits.
+    if(firstSample || fabs(error) < bestError - stallProgress)
+    {
+        bestError = fabs(error);
+        timeStalled = 0;
     }
+    else if(fabs(error) >= settleError && fabs(error) >= stallProgress)
+        timeStalled += time;
 
-    output = Kp*error + Ki*integral + Kd*derivative;
     prevError = error;
+    prevMeasurement = measurement;
+    firstSample = false;
 
-    if(fabs(error) < settleError)
+    if(fabs(error) < settleError && (settleVelocity <= 0 || fabs(errorRate) < settleVelocity))
         timeSpentSettled += time;
     else
         timeSpentSettled = 0;
 
+    if(fabs(error) < largeError)
+        timeInLargeError += time;
+    else
+        timeInLargeError = 0;
+
     runTime += time;
-        
+    if(fabs(error) < settleError && timeToWindow < 0)
+        timeToWindow = runTime;
+
     return output;
 }
 
 float PID::computeDebug(float error)
 {
-    // float time = deltaTime;
     static int i = 0;
-    float time = 10;
-    integral += error;
+    float result = compute(error);
+
+    if(fabs(error) < settleError)
+        std::cout << error << std::endl;
+    if(i++ % 10 == 0)
+        std::cout << error << std::endl;
 
-    derivative = error - prevError;
+    return result;
+}
 
-    // Checks if the error has crossed 0, and if it has, it eliminates the integral term.
-    if ((error > 0 && prevError < 0) || (error < 0 && prevError > 0)){ 
-        integral = 0; 
-    }
+/// @brief Clears the controller state so the object can be reused for a new motion
+void PID::reset()
+{
+    prevError = 0;
+    prevMeasurement = 0;
+    integral = 0;
+    derivative = 0;
+    output = 0;
+    timeSpentSettled = 0;
+    runTime = 0;
+    timeToWindow = -1;
+    errorRate = 0;
+    timeInLargeError = 0;
+    timeStalled = 0;
+    bestError = 0;
+    exitReason = EXITED_NONE;
+    firstSample = true;
+    deltaTime.reset();
+}
 
-    output = Kp*error + Ki*integral + Kd*derivative;
-    prevError = error;
+/// @brief Restarts the settle, large error and stall timers from the latest sample, leaving
+/// the control terms alone. For loops that feed the controller tracking error while a
+/// profile runs, so time spent following the profile doesn't count toward an exit.
+void PID::resetExitTimers()
+{
+    timeSpentSettled = 0;
+    timeInLargeError = 0;
+    timeStalled = 0;
+    bestError = fabs(prevError);
+}
 
-    if(fabs(error) < settleError){
-        std::cout << error << std::endl;
-        timeSpentSettled += time;
-    }else
-        timeSpentSettled = 0;
+/// @brief Restarts only the settle timer, for a motion that also needs something the
+/// controller doesn't see, like the heading of a pose, before it counts as settled
+void PID::resetSettleTimer()
+{
+    timeSpentSettled = 0;
+}
 
-    runTime += time;
-    if(i++ % 10 == 0)
-        std::cout << error << std::endl;
-        
-    return output;
+/// @brief Checks every exit condition that is set
+/// @return Returns what ended the motion, EXITED_NONE while it should keep running
+ExitReason PID::checkExit()
+{
+    if(runTime > endTime && endTime != 0)
+        exitReason = EXITED_TIMEOUT;
+    else if(timeSpentSettled > timeToSettle)
+        exitReason = EXITED_SETTLED;
+    else if(largeError > 0 && timeInLargeError > largeErrorTime)
+        exitReason = EXITED_LARGE_ERROR;
+    else if(stallTime > 0 && timeStalled > stallTime)
+        exitReason = EXITED_STALLED;
+    else
+        exitReason = EXITED_NONE;
+    return exitReason;
 }
 
 /// @brief Determines if the current PID state is completely settled
 /// @return Returns TRUE if settled, Returns FALSE if not settled
 bool PID::isSettled()
 {
-    if(runTime > endTime && endTime != 0){
-        std::cout << "TIMEOUT------------------" << std::endl;
-        return true;
-    }
-        
-    if(timeSpentSettled > timeToSettle){
-        std::cout << "SETTLED-----------------" << std::endl;
-        return true;
-    }
-        
-    else
+    if(checkExit() == EXITED_NONE)
         return false;
+
+    std::cout << exitReasonName(exitReason) << "-----------------" << std::endl;
+    return true;
 }
 
@@ -0,0 +1,205 @@
+#include "Path.h"
+#include <math.h>
+#include <iostream>
+
+/// @brief Constructor for an empty path
+Path::Path()
+{
+}
+
+/// @brief Constructor
+/// @param startX X position the path starts from
+/// @param startY Y position the path starts from
+Path::Path(float startX, float startY)
+{
+    addPoint(startX, startY);
+}
+
+/// @brief Adds a straight piece from the last point
+/// @param x X position of the new point
+/// @param y Y position of the new point
+void Path::addPoint(float x, float y)
+{
+    PathPoint point;
+    point.x = x;
+    point.y = y;
+    point.distance = 0;
+    if(!points.empty())
+    {
+        const PathPoint& last = points.back();
+        point.distance = last.distance + sqrt((x - last.x)*(x - last.x) + (y - last.y)*(y - last.y));
+    }
+    points.push_back(point);
+}
+
+/// @brief Adds a quadratic Bezier curve starting at the last point. A path without
+/// a point to start from is left as it is.
+/// @param midX The X position of the control point
+/// @param midY The Y position of the control point
+/// @param endX The X position the curve ends at
+/// @param endY The Y position the curve ends at
+/// @param samples The number of straight pieces the curve is split into
+void Path::addQuadratic(float midX, float midY, float endX, float endY, int samples)
+{
+    if(points.empty())
+    {
+        std::cout << "CURVE WITHOUT A START, add a point before the curve" << std::endl;
+        return;
+    }
+    float startX = points.back().x;
+    float startY = points.back().y;
+    for(int i = 1; i <= samples; i++)
+    {
+        float t = i / (float)samples;
+        float a = (1-t)*(1-t), b = 2*(1-t)*t, c = t*t;
+        addPoint(a*startX + b*midX + c*endX, a*startY + b*midY + c*endY);
+    }
+}
+
+/// @brief Adds a cubic Bezier curve starting at the last point. A path without
+/// a point to start from is left as it is.
+/// @param control1X The X position of the first control point
+/// @param control1Y The Y position of the first control point
+/// @param control2X The X position of the second control point
+/// @param control2Y The Y position of the second control point
+/// @param endX The X position the curve ends at
+/// @param endY The Y position the curve ends at
+/// @param samples The number of straight pieces the curve is split into
+void Path::addCubic(float control1X, float control1Y, float control2X, float control2Y, float endX, float endY, int samples)
+{
+    if(points.empty())
+    {
+        std::cout << "CURVE WITHOUT A START, add a point before the curve" << std::endl;
+        return;
+    }
+    float startX = points.back().x;
+    float startY = points.back().y;
+    for(int i = 1; i <= samples; i++)
+    {
+        float t = i / (float)samples;
+        float a = (1-t)*(1-t)*(1-t), b = 3*(1-t)*(1-t)*t, c = 3*(1-t)*t*t, d = t*t*t;
+        addPoint(a*startX + b*control1X + c*control2X + d*endX, a*startY + b*control1Y + c*control2Y + d*endY);
+    }
+}
+
+/// @brief Finds the point on the path closest to a position, only looking
+/// forward from a previous result so the robot can't jump back along a path
+/// that crosses itself. Past the end of the last piece the index keeps growing.
+/// @param x X position
+/// @param y Y position
+/// @param from Index to start searching from (piece + fraction)
+/// @return The index of the closest point (piece + fraction)
+float Path::closest(float x, float y, float from) const
+{
+    float best = from;
+    float bestDistance = -1;
+    int last = size() - 1;
+    for(int i = (int)from; i < last; i++)
+    {
+        const PathPoint& a = points[i];
+        const PathPoint& b = points[i+1];
+        float dx = b.x - a.x, dy = b.y - a.y;
+        float lengthSquared = dx*dx + dy*dy;
+        if(lengthSquared <= 0)
+            continue;
+
+        float t = ((x - a.x)*dx + (y - a.y)*dy) / lengthSquared;
+        if(t < 0) t = 0;
+        if(t > 1 && i < last - 1) t = 1;
+        if(i + t < from) t = from - i;
+
+        float px = a.x + dx*t - x, py = a.y + dy*t - y;
+        float distance = px*px + py*py;
+        if(bestDistance < 0 || distance < bestDistance)
+        {
+            bestDistance = distance;
+            best = i + t;
+        }
+    }
+    return best;
+}
+
+/// @brief Converts an index into the distance along the path
+/// @param index Piece + fraction, may run past the end
+/// @return Distance from the first point in inches
+float Path::distanceAt(float index) const
+{
+    int last = size() - 1;
+    if(last < 1)
+        return 0;
+    int i = (int)index;
+    if(i > last - 1) i = last - 1;
+    if(i < 0) i = 0;
+    const PathPoint& a = points[i];
+    const PathPoint& b = points[i+1];
+    return a.distance + (b.distance - a.distance) * (index - i);
+}
+
+/// @brief Finds the pure pursuit goal: the furthest point along the path
+/// where it crosses a circle around the robot
+/// @param x X position of the robot
+/// @param y Y position of the robot
+/// @param radius The lookahead distance in inches
+/// @param index The last goal index, moved forward when a new goal is found
+/// @param outX The X position of the goal
+/// @param outY The Y position of the goal
+/// @return Returns FALSE if the circle does not reach the path, the goal is then left where it was
+bool Path::lookahead(float x, float y, float radius, float& index, float& outX, float& outY) const
+{
+    int last = size() - 1;
+    const PathPoint& end = points[last];
+    if((end.x - x)*(end.x - x) + (end.y - y)*(end.y - y) <= radius*radius)
+    {
+        index = last;
+        outX = end.x;
+        outY = end.y;
+        return true;
+    }
+
+    bool found = false;
+    for(int i = (int)index; i < last; i++)
+    {
+        const PathPoint& a = points[i];
+        const PathPoint& b = points[i+1];
+        float dx = b.x - a.x, dy = b.y - a.y;
+        float fx = a.x - x, fy = a.y - y;
+
+        // Solve |a + t*(b - a) - robot| = radius for t
+        float qa = dx*dx + dy*dy;
+        float qb = 2*(fx*dx + fy*dy);
+        float qc = fx*fx + fy*fy - radius*radius;
+
+        // Stop at the first piece that starts outside the circle once a goal
+        // is found, so a path that loops back never pulls the goal across
+        if(found && qc > 0)
+            break;
+
+        float discriminant = qb*qb - 4*qa*qc;
+        if(qa <= 0 || discriminant < 0)
+            continue;
+
+        discriminant = sqrt(discriminant);
+        float t = (-qb + discriminant) / (2*qa);
+        if(t < 0 || t > 1)
+            t = (-qb - discriminant) / (2*qa);
+        if(t < 0 || t > 1 || i + t < index)
+            continue;
+
+        index = i + t;
+        found = true;
+    }
+
+    int i = (int)index;
+    if(i >= last)
+    {
+        outX = end.x;
+        outY = end.y;
+    }
+    else
+    {
+        float t = index - i;
+        outX = points[i].x + (points[i+1].x - points[i].x)*t;
+        outY = points[i].y + (points[i+1].y - points[i].y)*t;
+    }
+    return found;
+}
@@ -0,0 +1,317 @@
+#include "PoseEstimator.h"
+#include "util.h"
+#include "FastMath.h"
+
+// Reads arrive every 5 ms, an unchanged sensor counts as stopped after 3 of its refreshes
+static const float POD_STALE = 15000;      // us, rotation sensors refresh every 5 ms
+static const float MOTOR_STALE = 30000;    // us, motor encoders every 10 ms
+static const float INERTIAL_STALE = 30000; // us, inertial every 10 ms
+
+// Lateral speed dies out on its own, a tank drive only slides sideways when pushed
+static const float LATERAL_DECAY = 0.1;    // s
+
+// Measurements further than this many sigma from the filter are outliers
+static const float GATE = 3;
+
+// After this many absolute positions in a row are thrown out the estimate is the one that's
+// off, a bump or a bad start, so the next one is taken without the gate
+static const int POSITION_REJECT_LIMIT = 10;
+
+enum {X, Y, HEADING, FORWARD, LATERAL, TURN};
+
+/// @brief Constructor, noise values are for the V5 sensors on a 12 in drive
+PoseEstimator::PoseEstimator()
+{
+    for(int i = 0; i < 2; i++)
+    {
+        podsUsed[i] = false;
+        podDiameter[i] = 2;
+        podAngle[i] = 0;
+        podLever[i] = 0;
+    }
+    motorInches = 0;
+    halfTrack = 6;
+    setProcessNoise(300, 50, 40);
+    setSensorNoise(0.5, 1.5, 0.15, 0.02, 0.5);
+    reset(0, 0, 0, 0);
+}
+
+/// @brief Sets where the tracking pods sit, rotation1 is the left pod
+/// @param geometry Diameters, angles and levers of the pods
+/// @param leftUsed Whether rotation1 is fitted
+/// @param rightUsed Whether rotation2 is fitted
+void PoseEstimator::setPods(const OdomProfile& geometry, bool leftUsed, bool rightUsed)
+{
+    podsUsed[0] = leftUsed;
+    podsUsed[1] = rightUsed;
+    podDiameter[0] = geometry.leftDiameter;
+    podDiameter[1] = geometry.rightDiameter;
+    podAngle[0] = degToRad(geometry.leftAngle);
+    podAngle[1] = degToRad(geometry.rightAngle);
+    podLever[0] = geometry.leftLever;
+    podLever[1] = geometry.rightLever;
+}
+
+/// @brief Sets the drive encoder scale
+/// @param motorInchesPerDegree Wheel travel per motor degree
+/// @param trackWidth Inches between the left and right wheels
+void PoseEstimator::setDrive(float motorInchesPerDegree, float trackWidth)
+{
+    motorInches = motorInchesPerDegree;
+    halfTrack = trackWidth / 2;
+}
+
+/// @brief Sets how fast the robot can change speed, the filter trusts its own prediction less the higher these are
+/// @param forwardAcceleration in/s^2
+/// @param lateralAcceleration in/s^2, sideways pushes and slides
+/// @param turnAcceleration rad/s^2
+void PoseEstimator::setProcessNoise(float forwardAcceleration, float lateralAcceleration, float turnAcceleration)
+{
+    this->forwardAcceleration = forwardAcceleration;
+    this->lateralAcceleration = lateralAcceleration;
+    this->turnAcceleration = turnAcceleration;
+}
+
+/// @brief Sets the standard deviation of every sensor
+/// @param pod Tracking pod speed in in/s, grows by 2% of the speed
+/// @param motor Drive encoder speed in in/s, grows by 5% of the speed
+/// @param scrub Share of the turning speed at the wheels lost to scrub
+/// @param rate Inertial turn rate in rad/s
+/// @param heading Inertial heading in degrees
+void PoseEstimator::setSensorNoise(float pod, float motor, float scrub, float rate, float heading)
+{
+    podNoise = pod;
+    motorNoise = motor;
+    scrubNoise = scrub;
+    rateNoise = rate;
+    headingNoise = degToRad(heading);
+}
+
+/// @brief Starts the estimate over at a known pose
+/// @param x inches
+/// @param y inches
+/// @param heading degrees
+/// @param inertialRotation The inertial rotation read at this pose
+void PoseEstimator::reset(float x, float y, float heading, float inertialRotation)
+{
+    for(int i = 0; i < STATES; i++)
+    {
+        state[i] = 0;
+        for(int j = 0; j < STATES; j++)
+            covariance[i][j] = 0;
+    }
+    state[X] = x;
+    state[Y] = y;
+    state[HEADING] = degToRad(heading);
+    inertialOffset = heading - inertialRotation;
+
+    covariance[X][X] = 0.25 * 0.25;
+    covariance[Y][Y] = 0.25 * 0.25;
+    covariance[HEADING][HEADING] = headingNoise * headingNoise;
+    covariance[FORWARD][FORWARD] = 1;
+    covariance[LATERAL][LATERAL] = 1;
+    covariance[TURN][TURN] = 0.01;
+
+    podRates[0] = SensorRate();
+    podRates[1] = SensorRate();
+    leftRate = SensorRate();
+    rightRate = SensorRate();
+    inertialRateSample = SensorRate();
+    rejectedPositions = 0;
+    primed = false;
+}
+
+/// @brief Carries the state forward at constant speed
+/// @param dt seconds
+void PoseEstimator::predict(float dt)
+{
+    double sine, cosine;
+    fastSinCos(state[HEADING], sine, cosine);
+    float s = sine, c = cosine;
+    float forward = state[FORWARD], lateral = state[LATERAL];
+    float decay = 1 - dt / LATERAL_DECAY;
+    if(decay < 0)
+        decay = 0;
+
+    // Jacobian of the motion, identity except for these
+    float F[STATES][STATES] = {{0}};
+    for(int i = 0; i < STATES; i++)
+        F[i][i] = 1;
+    F[X][HEADING] = (forward * c - lateral * s) * dt;
+    F[X][FORWARD] = s * dt;
+    F[X][LATERAL] = c * dt;
+    F[Y][HEADING] = (-forward * s - lateral * c) * dt;
+    F[Y][FORWARD] = c * dt;
+    F[Y][LATERAL] = -s * dt;
+    F[HEADING][TURN] = dt;
+    F[LATERAL][LATERAL] = decay;
+
+    state[X] += (forward * s + lateral * c) * dt;
+    state[Y] += (forward * c - lateral * s) * dt;
+    state[HEADING] += state[TURN] * dt;
+    state[LATERAL] *= decay;
+
+    // P = F P F' + Q
+    float FP[STATES][STATES];
+    for(int i = 0; i < STATES; i++)
+        for(int j = 0; j < STATES; j++)
+        {
+            float sum = 0;
+            for(int k = 0; k < STATES; k++)
+                sum += F[i][k] * covariance[k][j];
+            FP[i][j] = sum;
+        }
+    for(int i = 0; i < STATES; i++)
+        for(int j = 0; j < STATES; j++)
+        {
+            float sum = 0;
+            for(int k = 0; k < STATES; k++)
+                sum += FP[i][k] * F[j][k];
+            covariance[i][j] = sum;
+        }
+    covariance[FORWARD][FORWARD] += forwardAcceleration * forwardAcceleration * dt * dt;
+    covariance[LATERAL][LATERAL] += lateralAcceleration * lateralAcceleration * dt * dt;
+    covariance[TURN][TURN] += turnAcceleration * turnAcceleration * dt * dt;
+}
+
+/// @brief One scalar Kalman update
+/// @param row How the measurement depends on the state
+/// @param innovation Measurement minus what the state predicts
+/// @param variance Noise of the measurement
+/// @param gate What a measurement outside the gate does: gets thrown out, has its noise inflated to fit, or goes in anyway
+/// @return Returns false when the measurement was thrown out
+bool PoseEstimator::correct(const float row[STATES], float innovation, float variance, GateMode gate)
+{
+    float PH[STATES];
+    float predicted = 0;
+    for(int i = 0; i < STATES; i++)
+    {
+        float sum = 0;
+        for(int j = 0; j < STATES; j++)
+            sum += covariance[i][j] * row[j];
+        PH[i] = sum;
+        predicted += row[i] * sum;
+    }
+
+    float S = predicted + variance;
+    float distance = innovation * innovation / S;
+    if(distance > GATE * GATE && gate != GATE_NONE)
+    {
+        if(gate == GATE_REJECT)
+            return false;
+        // A slipping wheel, trust it as much as its error says
+        S = predicted + variance * distance / (GATE * GATE);
+    }
+
+    for(int i = 0; i < STATES; i++)
+        state[i] += PH[i] / S * innovation;
+    for(int i = 0; i < STATES; i++)
+        for(int j = 0; j < STATES; j++)
+            covariance[i][j] -= PH[i] * PH[j] / S;
+    return true;
+}
+
+/// @brief Runs one filter step with the latest sensor reads
+/// @param readings Every sensor read at the same time
+void PoseEstimator::update(const EstimatorReadings& readings)
+{
+    if(!primed)
+    {
+        primed = true;
+        lastTime = readings.time;
+    }
+    float dt = (readings.time - lastTime) / 1e6f;
+    lastTime = readings.time;
+    if(dt > 0)
+        predict(dt);
+
+    float rate;
+    for(int i = 0; i < 2; i++)
+    {
+        if(!podsUsed[i] || !podRates[i].sample(readings.pods[i], readings.time, POD_STALE, rate))
+            continue;
+        float speed = rate / 360 * M_PI * podDiameter[i];
+        float row[STATES] = {0, 0, 0, cos(podAngle[i]), sin(podAngle[i]), podLever[i]};
+        float expected = row[FORWARD] * state[FORWARD] + row[LATERAL] * state[LATERAL] + row[TURN] * state[TURN];
+        float noise = podNoise + 0.02 * fabs(speed);
+        correct(row, speed - expected, noise * noise, GATE_REJECT);
+    }
+
+    float turnSpeed = fabs(state[TURN]) * halfTrack;
+    if(motorInches > 0 && leftRate.sample(readings.leftMotor, readings.time, MOTOR_STALE, rate))
+    {
+        float speed = rate * motorInches;
+        float row[STATES] = {0, 0, 0, 1, 0, halfTrack};
+        float noise = motorNoise + 0.05 * fabs(speed) + scrubNoise * turnSpeed;
+        correct(row, speed - state[FORWARD] - halfTrack * state[TURN], noise * noise, GATE_INFLATE);
+    }
+    if(motorInches > 0 && rightRate.sample(readings.rightMotor, readings.time, MOTOR_STALE, rate))
+    {
+        float speed = rate * motorInches;
+        float row[STATES] = {0, 0, 0, 1, 0, -halfTrack};
+        float noise = motorNoise + 0.05 * fabs(speed) + scrubNoise * turnSpeed;
+        correct(row, speed - state[FORWARD] + halfTrack * state[TURN], noise * noise, GATE_INFLATE);
+    }
+
+    // Rate and heading from the same rotation read, in the same clockwise convention
+    if(inertialRateSample.sample(readings.inertialRotation, readings.time, INERTIAL_STALE, rate))
+    {
+        float rateRow[STATES] = {0, 0, 0, 0, 0, 1};
+        correct(rateRow, degToRad(rate) - state[TURN], rateNoise * rateNoise, GATE_REJECT);
+
+        float headingRow[STATES] = {0, 0, 1, 0, 0, 0};
+        float heading = degToRad(readings.inertialRotation + inertialOffset);
+        correct(headingRow, heading - state[HEADING], headingNoise * headingNoise, GATE_REJECT);
+    }
+}
+
+/// @brief Fuses an absolute position, such as a GPS read. Reads further than 3 sigma off are thrown out,
+/// unless the last 10 were too.
+/// @param x inches
+/// @param y inches
+/// @param standardDeviation inches
+/// @return Returns true when the read was used
+bool PoseEstimator::correctPosition(float x, float y, float standardDeviation)
+{
+    float variance = standardDeviation * standardDeviation;
+    float xRow[STATES] = {1, 0, 0, 0, 0, 0};
+    float yRow[STATES] = {0, 1, 0, 0, 0, 0};
+    GateMode gate = rejectedPositions < POSITION_REJECT_LIMIT ? GATE_REJECT : GATE_NONE;
+    bool used = correct(xRow, x - state[X], variance, gate);
+    used = correct(yRow, y - state[Y], variance, gate) && used;
+    rejectedPositions = used ? 0 : rejectedPositions + 1;
+    return used;
+}
+
+/// @brief Fuses an absolute heading. Reads further than 3 sigma off are thrown out.
+/// @param heading degrees
+/// @param standardDeviation degrees
+/// @return Returns true when the read was used
+bool PoseEstimator::correctHeading(float heading, float standardDeviation)
+{
+    float row[STATES] = {0, 0, 1, 0, 0, 0};
+    float deviation = degToRad(standardDeviation);
+    return correct(row, degToRad(degTo180(heading - state[HEADING] * 180 / M_PI)), deviation * deviation, GATE_REJECT);
+}
+
+/// @brief The estimate with its covariance
+/// @return Returns the pose, heading in degrees (0 - 360)
+Pose PoseEstimator::getPose() const
+{
+    Pose pose;
+    float heading = fmod(state[HEADING] * 180 / M_PI, 360);
+    if(heading < 0)
+        heading += 360;
+    float toDegrees = 180 / M_PI;
+    pose.x = state[X];
+    pose.y = state[Y];
+    pose.heading = heading;
+    pose.timestamp = lastTime;
+    pose.covXX = covariance[X][X];
+    pose.covXY = covariance[X][Y];
+    pose.covYY = covariance[Y][Y];
+    pose.covXHeading = covariance[X][HEADING] * toDegrees;
+    pose.covYHeading = covariance[Y][HEADING] * toDegrees;
+    pose.covHeading = covariance[HEADING][HEADING] * toDegrees * toDegrees;
+    return pose;
+}
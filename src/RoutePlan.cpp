@@ -0,0 +1,136 @@
+#include "RoutePlan.h"
+#include <math.h>
+
+// Profiles are looked up by distance, a cached one has to match this closely (inches or degrees)
+static const float PROFILE_MATCH = 0.001;
+
+// How often acquire checks on a plan still being built
+static const int POLL_MS = 5;
+
+/// @brief Lets the screen and sensors run between items while building in the background
+void RoutePlan::pause()
+{
+    if(background)
+        wait(1, msec);
+}
+
+/// @brief Adds an empty path for the planner to fill in
+/// @param startX The X position the path starts at
+/// @param startY The Y position the path starts at
+/// @return The new path, stays valid until the next addPath
+Path& RoutePlan::addPath(float startX, float startY)
+{
+    pause();
+    paths.push_back(Path(startX, startY));
+    return paths.back();
+}
+
+/// @brief Builds the profile a profiled move over the distance will use
+/// @param distance Signed distance in inches or degrees
+/// @param limits The limits the move will run with
+void RoutePlan::addProfile(float distance, const ProfileLimits& limits)
+{
+    pause();
+    CachedProfile cached;
+    cached.distance = distance;
+    cached.limits = limits;
+    cached.profile = MotionProfile(distance, limits);
+    profiles.push_back(cached);
+}
+
+/// @brief Finds a profile built ahead of time
+/// @param distance Signed distance in inches or degrees
+/// @param limits The limits the move runs with
+/// @return The cached profile, or 0 if the plan has none for the move
+const MotionProfile* RoutePlan::findProfile(float distance, const ProfileLimits& limits) const
+{
+    for(size_t i = 0; i < profiles.size(); i++)
+    {
+        const CachedProfile& cached = profiles[i];
+        if(fabs(cached.distance - distance) < PROFILE_MATCH
+            && cached.limits.maxVelocity == limits.maxVelocity
+            && cached.limits.maxAcceleration == limits.maxAcceleration
+            && cached.limits.maxJerk == limits.maxJerk)
+            return &cached.profile;
+    }
+    return 0;
+}
+
+/// @brief Empties the plan
+void RoutePlan::clear()
+{
+    paths.clear();
+    profiles.clear();
+}
+
+/// @brief Constructor
+/// @param planners One planner per route, 0 for routes with nothing to plan
+/// @param routeCount The number of routes
+PlanCache::PlanCache(const RoutePlanner* planners, int routeCount)
+{
+    this->planners = planners;
+    this->routeCount = routeCount;
+    requested = -1;
+    built = -1;
+    building = false;
+}
+
+/// @brief Starts building the plan for a newly picked route in the background
+/// @param route Index of the route (0 - routeCount-1)
+void PlanCache::select(int route)
+{
+    if(route < 0 || route >= routeCount || route == requested)
+        return;
+
+    requested = route;
+    built = -1;
+    if(!building)
+    {
+        building = true;
+        task(buildTask, this, task::taskPriorityLow);
+    }
+}
+
+/// @brief Builds the requested plan, and again if the route changed meanwhile
+int PlanCache::buildTask(void* cache)
+{
+    PlanCache* plans = (PlanCache*)cache;
+    int route;
+    do
+    {
+        route = plans->requested;
+        plans->plan.setBackground(true);
+        plans->build(route);
+        plans->plan.setBackground(false);
+    } while(route != plans->requested);
+
+    plans->built = route;
+    plans->building = false;
+    return 0;
+}
+
+/// @brief Replaces the plan with the one for the route
+void PlanCache::build(int route)
+{
+    plan.clear();
+    if(planners[route])
+        planners[route](plan);
+}
+
+/// @brief Returns the plan for the route, waiting for the background build to
+/// finish or building it now if a different route was picked
+/// @param route Index of the route (0 - routeCount-1)
+/// @return The finished plan
+const RoutePlan& PlanCache::acquire(int route)
+{
+    while(building)
+        wait(POLL_MS, msec);
+
+    if(built != route && route >= 0 && route < routeCount)
+    {
+        requested = route;
+        build(route);
+        built = route;
+    }
+    return plan;
+}
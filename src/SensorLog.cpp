@@ -0,0 +1,91 @@
+#include "SensorLog.h"
+
+/// @brief Allocates room for a whole recording up front
+/// @param capacity Samples kept, anything recorded after that is dropped
+SensorLog::SensorLog(uint32_t capacity) : samples(new SensorSample[capacity]), capacity(capacity), count(0), dropped(0), odomType(0), estimator(false), startTime(0)
+{
+}
+
+SensorLog::~SensorLog()
+{
+    delete[] samples;
+}
+
+/// @brief Appends a sample, only the odometry task may call this
+/// @param sample The sensor read and its result
+void SensorLog::record(const SensorSample& sample)
+{
+    if(count >= capacity)
+    {
+        dropped++;
+        return;
+    }
+    samples[count] = sample;
+    count = count + 1;
+}
+
+/// @brief Throws away every sample, for the next recording
+void SensorLog::clear()
+{
+    count = 0;
+    dropped = 0;
+}
+
+/// @brief Notes how the poses in the samples were made, saved in the file header
+/// @param odomType The Drive's odom type
+/// @param estimator True when the pose estimator was running
+void SensorLog::setSource(int32_t odomType, bool estimator)
+{
+    this->odomType = odomType;
+    this->estimator = estimator;
+}
+
+/// @brief Writes the samples to a file, the SD card on the brain. Takes a while for
+/// a long recording, call it after the run or once recording has stopped.
+/// @param filename Binary file to write
+/// @return Returns false if the file could not be written
+bool SensorLog::save(const char* filename) const
+{
+    std::ofstream file(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+    if(!file.is_open())
+        return false;
+
+    SensorLogHeader header = {SENSOR_LOG_MAGIC, SENSOR_LOG_VERSION, sizeof(SensorSample), count, odomType, estimator ? 1u : 0u, startTime};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(samples), (std::streamsize)count * sizeof(SensorSample));
+    file.close();
+    std::cout << "sensor log: " << count << " samples written to " << filename;
+    if(dropped > 0)
+        std::cout << ", " << dropped << " dropped when the log filled";
+    std::cout << std::endl;
+    return true;
+}
+
+/// @brief Reads a file written by save, replacing the samples held now
+/// @param filename Binary file to read
+/// @return Returns false if the file is missing or from another version
+bool SensorLog::load(const char* filename)
+{
+    std::ifstream file(filename, std::ios::in | std::ios::binary);
+    SensorLogHeader header;
+    if(!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        return false;
+    if(header.magic != SENSOR_LOG_MAGIC || header.version != SENSOR_LOG_VERSION || header.sampleSize != sizeof(SensorSample))
+        return false;
+    if(header.count > capacity)
+    {
+        delete[] samples;
+        samples = new SensorSample[header.count];
+        capacity = header.count;
+    }
+    count = 0;
+    if(!file.read(reinterpret_cast<char*>(samples), (std::streamsize)header.count * sizeof(SensorSample)))
+        return false;
+
+    count = header.count;
+    dropped = 0;
+    odomType = header.odomType;
+    estimator = header.estimator != 0;
+    startTime = header.startTime;
+    return true;
+}
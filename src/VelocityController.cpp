@@ -0,0 +1,69 @@
+#include "VelocityController.h"
+#include "util.h"
+
+// Low-pass time constant on the measured speed in milliseconds, the motor
+// velocity reading steps with the 10 ms motor refresh
+static const float SPEED_FILTER = 20;
+
+/// @brief Constructor, the gains start at 0 so only the feedforward runs
+VelocityController::VelocityController()
+{
+    kP = 0;
+    kI = 0;
+    integralLimit = 0;
+    reset();
+}
+
+/// @brief Sets the feedback gains
+/// @param kP Volts per in/s of error
+/// @param kI Volts per inch of accumulated error
+/// @param integralLimit Most volts the integral term may add, 0 for no limit
+void VelocityController::setGains(float kP, float kI, float integralLimit)
+{
+    this->kP = kP;
+    this->kI = kI;
+    this->integralLimit = integralLimit;
+}
+
+/// @brief Clears the controller state for a new motion
+void VelocityController::reset()
+{
+    integral = 0;
+    measured = 0;
+    lastTarget = 0;
+    firstSample = true;
+    deltaTime.reset();
+}
+
+/// @brief Runs one update
+/// @param target Speed the side should run at in in/s
+/// @param speed Speed the side is running at in in/s
+/// @return Voltage for the side
+float VelocityController::compute(float target, float speed)
+{
+    float time = deltaTime.updateTime();
+    if(firstSample || time <= 0)
+        time = 10;
+    float seconds = time / 1000.0;
+
+    if(firstSample)
+        measured = speed;
+    else
+        measured += (time / (SPEED_FILTER + time)) * (speed - measured);
+
+    // The change in target is the acceleration the feedforward plans for
+    float acceleration = firstSample ? 0 : (target - lastTarget) / seconds;
+    lastTarget = target;
+    firstSample = false;
+
+    float error = target - measured;
+    integral += error * seconds;
+    if(integralLimit > 0 && kI != 0)
+        integral = clamp(integral, -integralLimit / fabs(kI), integralLimit / fabs(kI));
+
+    // Nothing to hold at a standstill, don't let the integral push against the brakes
+    if(target == 0)
+        integral = 0;
+
+    return feedforward.compute(target, acceleration) + kP * error + kI * integral;
+}
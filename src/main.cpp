@@ -11,6 +11,9 @@
 #include "screen.h"
 #include "util.h"
 #include "Drive.h"
+#include "OdomCalibration.h"
+#include "Benchmark.h"
+#include "AutonRoute.h"
 #include "images.h"
 
 
@@ -61,6 +64,8 @@ void Auton_5();
 void Auton_6();
 void Auton_7();
 void Auton_8();
+void addAuton4ToLongGoal(Path& path);
+void planAuton_4(RoutePlan& plan);
 
 void toggleLift();
 void toggleIntakeFlap();
@@ -71,9 +76,32 @@ void toggleDropDown();
 void startMacro();
 void cancelMacroHandler();
 void stopAllIntakeMotors();
+void printPose(const char* label);
 
 //////////////////////////////////////////////////////////////////////
 
+// Planners that build each route's paths and profiles while preAuton waits,
+// 0 for a route with nothing to plan. Slot order matches the selection buttons.
+const RoutePlanner routePlanners[8] = {0, 0, 0, planAuton_4, 0, 0, 0, 0};
+PlanCache routePlans(routePlanners, 8);
+
+// Route the selection screen starts on, Auton 2. autonomous() runs whichever route is
+// picked there, the same one preAuton has been planning.
+const int AUTON_ROUTE = 1;
+
+// Every route on the selection screen, slot order matches the buttons. The start is
+// the pose the route's setPosition gives, tools/autonbench starts the simulated robot there.
+const AutonRoute autonRoutes[AUTON_ROUTE_COUNT] = {
+  {"Auton 1", Auton_1, -46, 15, 0, 60000},        // skills
+  {"Auton 2", Auton_2, 0, 0, 90, 60000},          // skills
+  {"Auton 3", Auton_3, -46, 10.5, 180, 15000},
+  {"Auton 4", Auton_4, -55.5, -17, 180, 15000},
+  {"Auton 5", Auton_5, 0, 0, 0, 15000},
+  {"Auton 6", Auton_6, 0, 0, 90, 15000},
+  {"Auton 7", Auton_7, 0, 0, 0, 15000},
+  {"Auton 8", Auton_8, 0, 0, 0, 60000}
+};
+
 
 /// @brief Runs before the competition starts
 void preAuton() 
@@ -85,7 +113,7 @@ void preAuton()
 
   enum preAutonStates{START_SCREEN = 0, SELECTION_SCREEN = 1};
   int currentScreen = START_SCREEN;
-  int lastPressed = 0;
+  lastPressed = AUTON_ROUTE;
 
   // Calibrates/Resets the Brains sensors before the competition
   inertial1.calibrate();
@@ -94,11 +122,12 @@ void preAuton()
 
   vex::color colors[8] = {vex::color::red, vex::color::red, vex::color::red, vex::color::red, 
                           vex::color::blue, vex::color::blue, vex::color::blue, vex::color::blue};
-  std::string names[8] = {"Auton 1", "Auton 2", "Auton 3", "Auton 4", 
-                          "Auton 5", "Auton 6", "Auton 7", "Auton 8"};
+  std::string names[8];
+  for(int i = 0; i < AUTON_ROUTE_COUNT; i++)
+    names[i] = autonRoutes[i].name;
   Button buttons[9];
   createAutonButtons(colors, names, buttons);
-  buttons[0].setChosen(true);
+  buttons[lastPressed].setChosen(true);
 
   Text selectionLabel;
   Text configLabel;
@@ -108,6 +137,7 @@ void preAuton()
   int temp;
 
   Controller1.Screen.print(buttons[lastPressed].getName().c_str());
+  routePlans.select(lastPressed);
 
   while(!isInAuton){
     showPreAutonScreen(startScreenButtons, selectionLabel, configLabel, buttons[lastPressed].getName(), teamColor, driver);
@@ -132,6 +162,7 @@ void preAuton()
         temp = checkButtonsPress(buttons);
         if(temp >= 0 && temp < 8){
           lastPressed = temp;
+          routePlans.select(lastPressed);
           Controller1.Screen.clearLine();
           Controller1.Screen.setCursor(1, 1);
           std::string colorString = teamColor ? "Blue" : "Red";
@@ -149,10 +180,11 @@ void preAuton()
   Brain.Screen.clearScreen();
 }
 
-/// @brief Runs during the Autonomous Section of the Competition
-void autonomous() 
-{  
-  //drawSponsors();
+/// @brief Ends the selection screen, zeroes the sensors, loads the drive constants and the
+/// route's plan, and starts odometry
+/// @param route Index into autonRoutes
+void prepareRoute(int route)
+{
   isInAuton = true;
   rotation1.resetPosition();
   rotation2.resetPosition();
@@ -160,12 +192,29 @@ void autonomous()
   wait(100, msec);
 
   setDriveTrainConstants();
+  chassis.usePlan(&routePlans.acquire(route));
+  //chassis.usePoseEstimator(true);   // fuse the pods, drive encoders and inertial with the EKF in PoseEstimator
+  chassis.startOdometry();
+}
 
+/// @brief Runs during the Autonomous Section of the Competition
+void autonomous() 
+{  
+  //SensorLog sensorLog(12000);           // a minute of odometry sensor reads for tools/replay and SIM_REPLAY
+  //chassis.recordSensors(&sensorLog);    // first thing, SIM_REPLAY lines the log up with the start of autonomous
+  //CardLog cardLog;                      // the drive state at 100 Hz, written to the card as the run goes
+  //cardLog.start("state.clog");
+  //chassis.logToCard(&cardLog);
+  //drawSponsors();
+  prepareRoute(lastPressed);
 
-  //Auton_1();
-  Auton_2();
-  //Auton_3();
-  //Auton_4();
+  autonRoutes[lastPressed].run();
+  //chassis.calibrateOdometry("odomcal.csv");   // then make odomprofile CAL=odomcal.csv
+  //runControlBenchmarks(chassis, 1000000);      // times the control path to the serial console, drives 24 in out and back
+  //chassis.recordSensors(0);
+  //sensorLog.save("sensors.slog");               // then make replay LOG=sensors.slog
+  //chassis.logToCard(0);
+  //cardLog.stop();                               // then make cardlog LOG=state.clog
 
   // while(1){
   //   chassis.setPosition(0,0,0);
@@ -214,6 +263,7 @@ void usercontrol()
   int lastSeen = teamColor;
 
   chassis.brake(coast);
+  chassis.startOdometry();
   mainIntake.setStopping(coast);
 
   mainIntake.setVelocity(85, percent);
@@ -368,6 +418,13 @@ void stopAllIntakeMotors() {
   bottomStage.stop();
 }
 
+/// @brief Prints one consistent odometry sample
+/// @param label Printed before the coordinates
+void printPose(const char* label) {
+  Pose pose = chassis.chassisOdometry.getPose();
+  std::cout << label << ": " << pose.x << ", " << pose.y << std::endl;
+}
+
 
 int main() 
 {
@@ -399,6 +456,52 @@ void setDriveTrainConstants()
         2500 // End Time 5000
     );  
 
+    // Extra ways a drive can end, see MotionConstraints
+    chassis.setDriveExitConditions(
+        8,      // Settle Velocity - in/s, slower than this inside the settle error to count as settled
+        2,      // Large Error - in
+        500,    // Large Error Time - ms inside the large error before giving up on the settle window
+        0.25,   // Stall Progress - in the error has to shrink by
+        200     // Stall Time - ms without that progress, ends pushes into walls early
+    );
+
+    // Distance between the left and right wheels in inches
+    chassis.setTrackWidth(12);
+
+    // Pod and drive geometry measured with chassis.calibrateOdometry and tools/odomfit
+    chassis.setOdomProfile(ODOM_CALIBRATION);
+
+    // Drive motor cartridge free speed and the feedback on each side's speed for velocity control
+    chassis.setCartridge(600);
+    chassis.setVelocityConstants(
+        0.1,    // kP - Volts per in/s of error
+        2,      // kI - Volts per inch of accumulated error
+        3       // Most volts the integral adds
+    );
+
+    // Feedforward and profile limits for profiled moves, MotionConstraints().withProfile().
+    // Measured on the host sim with fixed voltage runs, re-measure on the robot.
+    chassis.setDriveFeedforward(
+        0.24,   // kS - Volts to start moving
+        0.147,  // kV - Volts per in/s
+        0.009   // kA - Volts per in/s^2
+    );
+    chassis.setDriveProfile(
+        70,     // Max Velocity in/s
+        250,    // Max Acceleration in/s^2
+        3000    // Max Jerk in/s^3
+    );
+    chassis.setTurnFeedforward(
+        0.6,    // kS - Volts to start turning
+        0.0171, // kV - Volts per deg/s
+        0.0012  // kA - Volts per deg/s^2
+    );
+    chassis.setTurnProfile(
+        400,    // Max Velocity deg/s
+        2000,   // Max Acceleration deg/s^2
+        20000   // Max Jerk deg/s^3
+    );
+
     // Set the Turn PID values for the DriveTrain
     chassis.setTurnConstants(
         .25,    // Kp - Proportion Constant
@@ -408,6 +511,15 @@ void setDriveTrainConstants()
         200,    // Time to Settle
         1000    // End Time
     );
+
+    // Extra ways a turn can end, see MotionConstraints
+    chassis.setTurnExitConditions(
+        30,     // Settle Velocity - deg/s
+        3,      // Large Error - deg
+        500,    // Large Error Time - ms
+        0.5,    // Stall Progress - deg
+        200     // Stall Time - ms
+    );
     
 }
 
@@ -605,12 +717,12 @@ void Auton_2()
     chassis.driveDistanceWithOdom(5);
     matchLoad.set(true);
 
-    std::cout << "POINT 1: " << chassis.chassisOdometry.getXPosition() << ", " << chassis.chassisOdometry.getYPosition() << std::endl;
+    printPose("POINT 1");
     
     //GRAB 2 BLUE WALL BALLS
     chassis.turnToAngle(15);
     chassis.driveDistanceWithOdom(46);
-    std::cout << "POINT 2: " << chassis.chassisOdometry.getXPosition() << ", " << chassis.chassisOdometry.getYPosition() << std::endl;
+    printPose("POINT 2");
     matchLoad.set(false);
     mainIntake.stop();
     colorSort.stop();
@@ -985,6 +1097,21 @@ void Auton_3()
 
 
 
+}
+
+/// @brief Auton 4's opening leg, out of the park zone and along the wall to the pair under the long goal
+/// @param path A path starting at (-55.5, -19), where the route leaves the park zone
+void addAuton4ToLongGoal(Path& path)
+{
+    path.addCubic(-55.5, -45, -45, -60, -29.5, -60, 20);
+    path.addPoint(-7.5, -60);
+}
+
+/// @brief Builds Auton 4's paths while preAuton waits
+void planAuton_4(RoutePlan& plan)
+{
+    // 0: addAuton4ToLongGoal
+    addAuton4ToLongGoal(plan.addPath(-55.5, -19));
 }
 
 /// @brief Auton Slot 4 - Write code for route within this function.
@@ -996,10 +1123,14 @@ void Auton_4()
     ///////// SETTING UP FOR UNDER LONG GOAL PART /////////
     chassis.setPosition(-55.5, -17, 180); // starting position
     chassis.driveDistanceWithOdom(2); // to get away from park zone
-    chassis.moveToPosition(-29.5, -60);
 
     ///////// GETTING 2 RED UNDER LONG GOAL /////////
-    chassis.moveToPosition(-7.5, -60);
+    // curves along the wall to under the long goal, planned ahead unless preAuton had another route selected
+    if(!chassis.followPlannedPath(0)){
+        Path toLongGoal(-55.5, -19);
+        addAuton4ToLongGoal(toLongGoal);
+        chassis.followPath(toLongGoal);
+    }
     chassis.moveToPosition(-7.5, -56);
     wait(1, sec); // grabs 2 red  
 
@@ -1116,12 +1247,12 @@ void Auton_6()
       return;
     }
 
-    std::cout << "POINT 1: " << chassis.chassisOdometry.getXPosition() << ", " << chassis.chassisOdometry.getYPosition() << std::endl;
+    printPose("POINT 1");
     
     //GRAB 2 BLUE WALL BALLS
     chassis.turnToAngle(15);
     chassis.driveDistanceWithOdom(46);
-    std::cout << "POINT 2: " << chassis.chassisOdometry.getXPosition() << ", " << chassis.chassisOdometry.getYPosition() << std::endl;
+    printPose("POINT 2");
     matchLoad.set(false);
     mainIntake.stop();
     colorSort.stop();
@@ -1,6 +1,22 @@
 #include "odom.h"
+#include "FastMath.h"
 #include <iostream>
 
+//Double versions of the util helpers, the float ones would round the heading.
+//Constant factors are multiplied in, a divide costs several multiplies.
+static const double RADIANS_PER_DEGREE = M_PI / 180.0;
+static const double DEGREES_PER_RADIAN = 180.0 / M_PI;
+static double radians(double degrees){ return degrees * RADIANS_PER_DEGREE; }
+static double wrap180(double angle){ return angle - 360.0 * floor((angle + 180.0) * (1.0 / 360.0)); }
+
+/// @brief sin(x)/x, by its series over the small angles a 5 ms update turns through
+static double sinc(double x){
+    if(fabs(x) > 0.05)
+        return fastSin(x) / x;
+    double x2 = x * x;
+    return 1.0 - x2 * (1.0 / 6.0) * (1.0 - x2 * (1.0 / 20.0));
+}
+
 /// @brief Constructor for odometry with two forward rotation sensors
 /// @param forwardRightWheelDiameter Right side forward rotation wheel diameter
 /// @param forwardLeftWheelDiameter Left side forward rotation wheel diameter
@@ -15,7 +31,7 @@ Odom::Odom(float forwardRightWheelDiameter, float forwardLeftWheelDiameter, floa
     this->forwardRightRotationDistance = forwardRightRotationDistance;
     this->forwardLeftRotationDistance = forwardLeftRotationDistance;
     this->lateralRotationDistance = lateralRotationDistance;     
-
+    precompute();
 }
 
 /// @brief Constructor for odometry with one forward rotation sensor
@@ -28,12 +44,22 @@ Odom::Odom(float forwardWheelDiameter, float lateralWheelDiameter, float forward
     this->lateralWheelDiameter = lateralWheelDiameter;
     this->forwardRightRotationDistance = forwardRotationDistance;
     this->lateralRotationDistance = lateralRotationDistance;
+    precompute();
 }
 
+/// @brief Constructor for odometry with two rotation sensors at 45 degrees
+/// The pods were measured at 48 degrees, the old 1.3382612 and 1.4862896 divisors are 2cos and 2sin of it.
+/// @param wheelDiameter45 Diameter of both rotation wheels
+/// @param leftRotationDistance Left pod travel per radian of clockwise turn (in)
+/// @param rightRotationDistance Right pod travel per radian of counterclockwise turn (in)
 Odom::Odom(float wheelDiameter45, float leftRotationDistance, float rightRotationDistance){
-    this->wheelDiameter45 = wheelDiameter45;
-    this->leftRotationDistance = leftRotationDistance;
-    this->rightRotationDistance = rightRotationDistance;
+    this->forwardLeftWheelDiameter = wheelDiameter45;
+    this->forwardRightWheelDiameter = wheelDiameter45;
+    this->forwardLeftRotationDistance = leftRotationDistance;
+    this->forwardRightRotationDistance = rightRotationDistance;
+    this->leftPodAngle = 48;
+    this->rightPodAngle = -48;
+    precompute();
 }
 
 Odom::Odom(){
@@ -41,9 +67,29 @@ Odom::Odom(){
     this->forwardRightRotationDistance = 0.0;
     this->lateralWheelDiameter = 2.0;
     this->lateralRotationDistance = 0.0;
+    this->forwardLeftWheelDiameter = 2.0;
+    this->forwardLeftRotationDistance = 0.0;
+    precompute();
 }
 
-
+/// @brief Works out the inches per degree of every pod and the trig of the pod angles,
+/// so an update is only multiplies on the raw degree deltas
+void Odom::precompute(){
+    forwardRightScale = M_PI * forwardRightWheelDiameter / 360.0;
+    forwardLeftScale = M_PI * forwardLeftWheelDiameter / 360.0;
+    lateralScale = M_PI * lateralWheelDiameter / 360.0;
+
+    double leftAngle = radians(leftPodAngle);
+    double rightAngle = radians(rightPodAngle);
+    leftPodSin = sin(leftAngle);
+    leftPodCos = cos(leftAngle);
+    rightPodSin = sin(rightAngle);
+    rightPodCos = cos(rightAngle);
+    podDeterminantInverse = 1.0 / sin(rightAngle - leftAngle);
+
+    double podSpacing = forwardLeftRotationDistance + forwardRightRotationDistance;
+    podSpacingInverse = fabs(podSpacing) > 0.01 ? 1.0 / podSpacing : 0;
+}
 
 /// @brief Sets all rotation degrees to 0.0
 void Odom::resetRotation(){
@@ -53,12 +99,16 @@ void Odom::resetRotation(){
 }
 
 //Accessors
-float Odom::getXPosition(){ return xPosition; }
-float Odom::getYPosition(){ return yPosition; }
-float Odom::getHeading(){ return heading;}
-float Odom::getForwardRightDegrees(){ return forwardDegreesR; }
-float Odom::getForwardLeftDegrees(){ return forwardDegreesL; }
-float Odom::getLateralDegrees(){ return lateralDegrees; }
+//The pose is read through the snapshot so a reader on another task never sees
+//x, y and heading from different updates. Use getPose() when more than one is needed.
+float Odom::getXPosition(){ return snapshot.read().x; }
+float Odom::getYPosition(){ return snapshot.read().y; }
+float Odom::getHeading(){ return snapshot.read().heading;}
+Pose Odom::getPose(){ return snapshot.read(); }
+uint32_t Odom::getUpdateCount(){ return snapshot.getSequence() / 2; }
+double Odom::getForwardRightDegrees(){ return forwardDegreesR; }
+double Odom::getForwardLeftDegrees(){ return forwardDegreesL; }
+double Odom::getLateralDegrees(){ return lateralDegrees; }
 
 //Mutators
 void Odom::setPosition(float xPosition, float yPosition, float heading){
@@ -67,155 +117,216 @@ void Odom::setPosition(float xPosition, float yPosition, float heading){
     this->heading = heading;
     if (!heading)
         this->heading = 0;
+    snapshot.write(this->xPosition, this->yPosition, this->heading);
 }
 void Odom::setHeading(float heading){
     this->heading = heading;
+    snapshot.write(xPosition, yPosition, this->heading);
 }
-void Odom::setForwardRightDegrees(float forwardDegreesR){
+void Odom::setForwardRightDegrees(double forwardDegreesR){
     this->forwardDegreesR = forwardDegreesR;
 }
-void Odom::setForwardLeftDegrees(float forwardDegreesL){
+void Odom::setForwardLeftDegrees(double forwardDegreesL){
     this->forwardDegreesL = forwardDegreesL;
 }
-void Odom::setLateralDegrees(float lateralDegrees){
+void Odom::setLateralDegrees(double lateralDegrees){
     this->lateralDegrees = lateralDegrees;
 }
+void Odom::setGyroWeight(float gyroWeight){
+    this->gyroWeight = clamp(gyroWeight, 0, 1);
+}
+
+/// @brief Takes the pod geometry from a calibration profile, rotation1 is the left pod
+/// @param profile The measured geometry
+void Odom::setProfile(const OdomProfile& profile){
+    forwardLeftWheelDiameter = profile.leftDiameter;
+    forwardRightWheelDiameter = profile.rightDiameter;
+    forwardLeftRotationDistance = profile.leftLever;
+    forwardRightRotationDistance = -profile.rightLever;
+    leftPodAngle = profile.leftAngle;
+    rightPodAngle = profile.rightAngle;
+    precompute();
+}
+
+/// @brief The pod geometry in use, in the form setProfile takes
+/// @return Returns the profile, without the drive values
+OdomProfile Odom::getProfile(){
+    OdomProfile profile = {forwardLeftWheelDiameter, forwardRightWheelDiameter, leftPodAngle, rightPodAngle,
+        forwardLeftRotationDistance, -forwardRightRotationDistance, 0, 0};
+    return profile;
+}
+
+/// @brief Publishes a pose worked out somewhere else, the pose estimator, with its covariance
+/// @param pose The pose to publish
+void Odom::setEstimate(const Pose& pose){
+    xPosition = pose.x;
+    yPosition = pose.y;
+    heading = pose.heading;
+    snapshot.write(pose);
+}
 
 
+/// @brief Moves the pose by a step in the field frame and publishes it
+/// @param globalDeltaX Inches along x
+/// @param globalDeltaY Inches along y
+/// @param newHeading Heading in degrees
+void Odom::advance(double globalDeltaX, double globalDeltaY, double newHeading){
+    xPosition += globalDeltaX;
+    yPosition += globalDeltaY;
+    heading = newHeading;
+    snapshot.write(xPosition, yPosition, heading);
+}
+
 /// @brief Updates the coordinate position of the robot with two forward rotation sensors and one lateral
-/// @param currentForwardRightPosition Forward right rotation degrees
-/// @param currentForwardLeftPosition Forward left rotation degrees
-/// @param currentLateralPosition Lateral rotation degrees
-void Odom::updatePositionTwoForward(float currentForwardRightDegrees, float currentForwardLeftDegrees, float currentLateralDegrees){
-    //Get current positions based on rotation sensors
-    float currentForwardRightPosition = currentForwardRightDegrees/360.0*(M_PI*forwardRightWheelDiameter);
-    float currentForwardLeftPosition = currentForwardLeftDegrees/360.0*(M_PI*forwardLeftWheelDiameter);
-    float currentLateralPosition = currentLateralDegrees/360.0*(M_PI*lateralWheelDiameter);
-
-    //Get positions since last update
-    float oldForwardRightPosition = getForwardRightDegrees()/360.0*(M_PI*forwardRightWheelDiameter);
-    float oldForwardLeftPosition = getForwardLeftDegrees()/360.0*(M_PI*forwardLeftWheelDiameter);
-    float oldLateralPosition = getLateralDegrees()/360.0*(M_PI*lateralWheelDiameter);
-
-    //Get the change based on rotations
-    float deltaForwardRight = currentForwardRightPosition - oldForwardRightPosition;
-    float deltaForwardLeft = currentForwardLeftPosition - oldForwardLeftPosition;
-    float deltaLateral = currentLateralPosition-oldLateralPosition;
+/// @param currentForwardRightDegrees Forward right rotation degrees
+/// @param currentForwardLeftDegrees Forward left rotation degrees
+/// @param currentLateralDegrees Lateral rotation degrees
+void Odom::updatePositionTwoForward(double currentForwardRightDegrees, double currentForwardLeftDegrees, double currentLateralDegrees){
+    //Get the change since the last update
+    double deltaForwardRight = (currentForwardRightDegrees - forwardDegreesR) * forwardRightScale;
+    double deltaForwardLeft = (currentForwardLeftDegrees - forwardDegreesL) * forwardLeftScale;
+    double deltaLateral = (currentLateralDegrees - lateralDegrees) * lateralScale;
 
     //Gives answer in radians
-    float deltaY;
-    float deltaX;
-    float deltaHeading = (deltaForwardLeft-deltaForwardRight)/(forwardLeftRotationDistance+forwardRightRotationDistance);
+    double deltaY;
+    double deltaX;
+    double deltaHeading = (deltaForwardLeft-deltaForwardRight)/(forwardLeftRotationDistance+forwardRightRotationDistance);
     
     if(deltaHeading < 0.01){
         deltaX=deltaLateral;
         deltaY=deltaForwardRight;
     }else{
-        deltaY = 2.0*((deltaForwardRight/deltaHeading)+forwardRightRotationDistance)*sin(deltaHeading/2.0);
-        deltaX = 2.0*((deltaLateral/deltaHeading)+lateralRotationDistance)*sin(deltaHeading/2.0);
+        double halfSine = fastSin(deltaHeading/2.0);
+        deltaY = 2.0*((deltaForwardRight/deltaHeading)+forwardRightRotationDistance)*halfSine;
+        deltaX = 2.0*((deltaLateral/deltaHeading)+lateralRotationDistance)*halfSine;
     }
 
     //Update x and y positions and heading
-    float avgHeading = degToRad(getHeading()+deltaHeading/2.0);
-    float globalDeltaX = deltaX * cos(avgHeading) - deltaY * sin(avgHeading);
-    float globalDeltaY = deltaX * sin(avgHeading) + deltaY * cos(avgHeading);
-    setPosition((globalDeltaX+getXPosition()), (globalDeltaY+getYPosition()), (heading+deltaHeading));
+    double avgHeading = radians(heading+deltaHeading/2.0);
+    double sine, cosine;
+    fastSinCos(avgHeading, sine, cosine);
+    advance(deltaX * cosine - deltaY * sine, deltaX * sine + deltaY * cosine, heading+deltaHeading);
     
     //Update variables to store new location information
     forwardDegreesR = currentForwardRightDegrees;
     forwardDegreesL = currentForwardLeftDegrees;
     lateralDegrees = currentLateralDegrees;
-    heading += deltaHeading;
 }
 
 /// @brief Updates the coordinate position of the robot with one forward and one lateral rotation sensor
-/// @param currentForwardPosition Forward rotation degrees
-/// @param currentLateralPosition Lateral rotation degrees
+/// @param currentForwardDegrees Forward rotation degrees
+/// @param currentLateralDegrees Lateral rotation degrees
 /// @param headingGyro Heading in degrees
-void Odom::updatePositionOneForward(float currentForwardDegrees, float currentLateralDegrees, float headingGyro){
-    //Get current positions based on rotation sensors
-    float currentForwardPosition = degToInches(currentForwardDegrees, forwardRightWheelDiameter);
-    float currentLateralPosition = degToInches(currentLateralDegrees, lateralWheelDiameter);
-
-    //Get positions since last update
-    float oldForwardPosition = degToInches(forwardDegreesR, forwardRightWheelDiameter);
-    float oldLateralPosition = degToInches(lateralDegrees, lateralWheelDiameter);
-
-    //Get the change based on rotations
-    float deltaForward = currentForwardPosition - oldForwardPosition;
-    float deltaLateral = currentLateralPosition - oldLateralPosition;
+void Odom::updatePositionOneForward(double currentForwardDegrees, double currentLateralDegrees, double headingGyro){
+    //Get the change since the last update
+    double deltaForward = (currentForwardDegrees - forwardDegreesR) * forwardRightScale;
+    double deltaLateral = (currentLateralDegrees - lateralDegrees) * lateralScale;
 
     //Gives answer in radians
-    float deltaY = 0;
-    float deltaX = 0;
+    double deltaY = 0;
+    double deltaX = 0;
 
-    float deltaHeading = headingGyro - heading;
+    double deltaHeading = headingGyro - heading;
 
     if(fabs(deltaHeading) < 0.01){
         deltaY=deltaForward;
         deltaX=deltaLateral;
     }else{
-        deltaY = 2.0*((deltaForward/degToRad(deltaHeading))+forwardRightRotationDistance)*sin(degToRad(deltaHeading)/2.0);
-        deltaX = 2.0*((deltaLateral/degToRad(deltaHeading))+lateralRotationDistance)*sin(degToRad(deltaHeading)/2.0);
+        double turn = radians(deltaHeading);
+        double halfSine = fastSin(turn/2.0);
+        deltaY = 2.0*((deltaForward/turn)+forwardRightRotationDistance)*halfSine;
+        deltaX = 2.0*((deltaLateral/turn)+lateralRotationDistance)*halfSine;
     }
 
     //Update x and y positions and heading
-    float avgHeading = degToRad(getHeading()+deltaHeading/2.0);
-    float globalDeltaX = deltaX * cos(avgHeading) - deltaY * sin(avgHeading);
-    float globalDeltaY = deltaX * sin(avgHeading) + deltaY * cos(avgHeading);
-    setPosition((globalDeltaX+getXPosition()), (globalDeltaY+getYPosition()), headingGyro);
+    double avgHeading = radians(heading+deltaHeading/2.0);
+    double sine, cosine;
+    fastSinCos(avgHeading, sine, cosine);
+    advance(deltaX * cosine - deltaY * sine, deltaX * sine + deltaY * cosine, headingGyro);
     
     //Update variables to store new location information
     forwardDegreesR = currentForwardDegrees;
     lateralDegrees = currentLateralDegrees;
-    heading = headingGyro;
 }
 
-void Odom::updatePositionTwoAt45(float currentLeftDegrees, float currentRightDegrees, float headingGyro){
-    //Get current positions based on rotation sensors
-    float currentRightPosition = degToInches(currentRightDegrees, wheelDiameter45);
-    float currentLeftPosition = degToInches(currentLeftDegrees, wheelDiameter45);
+/// @brief Updates the coordinate position of the robot with two rotation sensors at an angle.
+/// Each pod reads forward * cos(angle) + lateral * sin(angle) once the turn is taken out,
+/// so the pair is solved for the forward and lateral travel.
+/// @param currentLeftDegrees Left pod rotation degrees
+/// @param currentRightDegrees Right pod rotation degrees
+/// @param headingGyro Heading in degrees
+void Odom::updatePositionTwoAt45(double currentLeftDegrees, double currentRightDegrees, double headingGyro){
+    //Get the change since the last update
+    double deltaLeft = (currentLeftDegrees - forwardDegreesL) * forwardLeftScale;
+    double deltaRight = (currentRightDegrees - forwardDegreesR) * forwardRightScale;
 
-    //Get positions since last update
-    float oldRightPosition = degToInches(forwardDegreesR, wheelDiameter45);
-    float oldLeftPosition = degToInches(forwardDegreesL, wheelDiameter45);
+    double deltaHeading = wrap180(headingGyro - heading);
+    double turn = radians(deltaHeading);
 
-    //Get the change based on rotations
-    float deltaRight = currentRightPosition - oldRightPosition;
-    float deltaLeft = currentLeftPosition - oldLeftPosition;
+    //Take out the travel from turning about the tracking center
+    deltaLeft -= forwardLeftRotationDistance*turn;
+    deltaRight += forwardRightRotationDistance*turn;
 
-    float deltaHeading = degTo180(headingGyro - heading);
+    //Forward and lateral (toward the right) travel
+    double deltaForward = (deltaLeft * rightPodSin - deltaRight * leftPodSin) * podDeterminantInverse;
+    double deltaLateral = (deltaRight * leftPodCos - deltaLeft * rightPodCos) * podDeterminantInverse;
 
+    //Update x and y positions and heading
+    double avgHeading = radians(heading) + turn/2.0;
+    double sine, cosine;
+    fastSinCos(avgHeading, sine, cosine);
+    advance(deltaForward * sine + deltaLateral * cosine, deltaForward * cosine - deltaLateral * sine, headingGyro);
+    
+    //Update variables to store new location information
+    forwardDegreesR = currentRightDegrees;
+    forwardDegreesL = currentLeftDegrees;
+}
 
-    //taking this out make turning x accurate
-    if(fabs(deltaHeading) > 0.01){
-        //THIS MAY NEED TO BE += INSTEAD
-        deltaLeft -= leftRotationDistance*degToRad(deltaHeading);
-        deltaRight += rightRotationDistance*degToRad(deltaHeading);
+/// @brief Updates the coordinate position of the robot with two parallel forward rotation sensors.
+/// The heading change comes from the difference between the pods, so the pose can update faster than
+/// the inertial sensor refreshes. The gyro weight then pulls that heading toward the inertial heading.
+/// The robot is taken to have moved along a circular arc over the update, the center of the
+/// tracking wheels covers the arc length and the pose moves along its chord.
+/// Uses the forward left and right wheel diameters and rotation distances, the distances are how far
+/// each pod sits from the tracking center toward its own side (in).
+/// @param currentLeftDegrees Left pod rotation degrees
+/// @param currentRightDegrees Right pod rotation degrees
+/// @param headingGyro Inertial heading in degrees, only used when the gyro weight is above 0
+void Odom::updatePositionTwoVertical(double currentLeftDegrees, double currentRightDegrees, double headingGyro){
+    //Get the change since the last update
+    double deltaLeft = (currentLeftDegrees - forwardDegreesL) * forwardLeftScale;
+    double deltaRight = (currentRightDegrees - forwardDegreesR) * forwardRightScale;
+
+    //Heading change from the pods in radians, clockwise positive
+    double deltaHeading = 0;
+    double deltaForward = (deltaLeft + deltaRight) * 0.5;
+    if(podSpacingInverse != 0){
+        deltaHeading = (deltaLeft - deltaRight) * podSpacingInverse;
+        //The tracking center sits between the pods in proportion to their distances
+        deltaForward = (deltaLeft * forwardRightRotationDistance + deltaRight * forwardLeftRotationDistance) * podSpacingInverse;
     }
 
-    // //Gives answer in radians
-    // float deltaY = (deltaLeft + deltaRight) / sqrt(2.0);
-    // float deltaX = (deltaLeft - deltaRight) / sqrt(2.0);
-
-
-    float deltaX = (deltaLeft + deltaRight) / 1.3382612;
-    float deltaY = (deltaLeft - deltaRight) / 1.4862896;
-
-    // std::cout << "DeltaX: " << deltaX << ", DeltaY: " << deltaY << std::endl;
+    //Fuse with the inertial sensor
+    if(gyroWeight > 0){
+        double podHeading = heading + deltaHeading * DEGREES_PER_RADIAN;
+        deltaHeading += radians(gyroWeight * wrap180(headingGyro - podHeading));
+    }
 
-    //Update x and y positions and heading
-    float avgHeading = degToRad(getHeading()+deltaHeading/2.0);
-    float globalDeltaX = deltaY * cos(avgHeading) + deltaX * sin(avgHeading);
-    float globalDeltaY = deltaY * sin(avgHeading) + deltaX * cos(avgHeading);
+    //Chord of the arc, sin(x)/x goes to 1 as the arc straightens out
+    double chord = deltaForward * sinc(deltaHeading / 2.0);
 
-    // std::cout << "globalDeltaX: " << globalDeltaX << ", globalDeltaY: " << globalDeltaY << std::endl;
-    // std::cout << "X: " << getXPosition() << ", Y: " << getYPosition() << ", Heading: " << headingGyro << std::endl;
+    //The chord points along the average heading
+    double avgHeading = radians(heading) + deltaHeading / 2.0;
+    double newHeading = heading + deltaHeading * DEGREES_PER_RADIAN;
+    if(newHeading >= 360)
+        newHeading -= 360;
+    else if(newHeading < 0)
+        newHeading += 360;
+    double sine, cosine;
+    fastSinCos(avgHeading, sine, cosine);
+    advance(chord * sine, chord * cosine, newHeading);
 
-    setPosition((globalDeltaX+getXPosition()), (globalDeltaY+getYPosition()), headingGyro);
-    
     //Update variables to store new location information
-    forwardDegreesR = currentRightDegrees;
     forwardDegreesL = currentLeftDegrees;
-    heading = headingGyro;
-}
\ No newline at end of file
+    forwardDegreesR = currentRightDegrees;
+}
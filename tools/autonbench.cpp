@@ -0,0 +1,338 @@
+// Simulated autonomous benchmark
+//
+//   autonbench [--route n] [--baseline file] [--save file] [--tolerance ms]
+//
+// Runs every route in the registry in src/main.cpp (autonRoutes) headless in the
+// simulator, from the start pose the registry gives, the way autonomous() runs it:
+// prepareRoute, then the route, cut off at its time limit. For each route it prints
+// the total time, every motion's time, the time lost settling (after the error first
+// came inside the settle window, or stalled short of it), how each motion ended and
+// the error it left, and where the robot finished next to where the odometry thought
+// it was.
+//
+// --baseline compares against results saved earlier with --save, route by route
+// and motion by motion, and exits with 1 when a route got slower by more than the
+// tolerance (100 ms by default), no longer finishes in time or gets fewer motions done
+// before its limit. --route n runs only
+// slot n (1 - 8).
+//
+// Each route runs in its own process (autonbench --run n) since the simulator runs
+// one autonomous per process. Results pass between them as the same lines the
+// baseline file holds:
+//   route <slot> <total ms> <timed out> <x> <y> <heading> <odom x> <odom y> <odom heading>
+//   motion <slot> <name> <start ms> <time ms> <settle ms> <error> <exit reason>
+#include "vex.h"
+#include "Drive.h"
+#include "AutonRoute.h"
+#include "sim.h"
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+using namespace vex;
+
+extern Drive chassis;
+void preAuton();
+
+static const float DEFAULT_TOLERANCE = 100;
+
+/////////////////////////////// Running a route ///////////////////////////////
+
+static int routeIndex = 0;
+static volatile bool routeDone = false;
+static MotionLog motions;
+
+static int runRoute()
+{
+    prepareRoute(routeIndex);
+    autonRoutes[routeIndex].run();
+    routeDone = true;
+    return 0;
+}
+
+/// @brief The autonomous callback of a --run process. Runs the route on its own task so
+/// the time limit can cut it off, then prints the result lines.
+static void benchmarkRoute()
+{
+    const AutonRoute& route = autonRoutes[routeIndex];
+    chassis.recordMotions(&motions);
+    uint64_t start = timer::systemHighResolution();
+    task routeTask(runRoute);
+    while(!routeDone && timer::systemHighResolution() - start < route.timeLimit * 1000)
+        wait(5, msec);
+    double total = (timer::systemHighResolution() - start) / 1000.0;
+    chassis.recordMotions(0);
+
+    for(uint32_t i = 0; i < motions.size(); i++)
+    {
+        const MotionRecord& r = motions[i];
+        printf("[bench] motion %d %s %.3f %.3f %.3f %.6f %d\n", routeIndex + 1, r.name, r.start, r.duration, r.settling, r.error, (int)r.exit);
+    }
+    vexsim::Pose truth = vexsim::truePose();
+    Pose odom = chassis.chassisOdometry.getPose();
+    printf("[bench] route %d %.3f %d %.4f %.4f %.4f %.4f %.4f %.4f\n", routeIndex + 1, total, routeDone ? 0 : 1,
+        truth.x, truth.y, truth.heading, odom.x, odom.y, odom.heading);
+    fflush(stdout);
+}
+
+static int runInSimulator(int slot)
+{
+    routeIndex = slot - 1;
+    const AutonRoute& route = autonRoutes[routeIndex];
+    vexsim::Pose start = {route.startX, route.startY, route.startHeading};
+    vexsim::setTruePose(start);
+
+    // The route's own limit ends it, the field's period only has to be longer
+    char period[32];
+    snprintf(period, sizeof(period), "%.0f", route.timeLimit + 1000);
+    setenv("SIM_PERIOD_MS", period, 1);
+
+    // As main() in src/main.cpp, preAuton holds the selection screen until prepareRoute
+    competition field;
+    field.autonomous(benchmarkRoute);
+    preAuton();
+    while(true)
+        wait(100, msec);
+}
+
+/////////////////////////////// Results ///////////////////////////////
+
+struct MotionResult
+{
+    std::string name;
+    double start, duration, settling, error;
+    int exit;
+};
+
+struct RouteResult
+{
+    bool ran;
+    double total;
+    bool timedOut;
+    double x, y, heading;
+    double odomX, odomY, odomHeading;
+    std::vector<MotionResult> motions;
+    RouteResult() : ran(false), total(0), timedOut(false), x(0), y(0), heading(0), odomX(0), odomY(0), odomHeading(0) {}
+
+    double settling() const
+    {
+        double sum = 0;
+        for(size_t i = 0; i < motions.size(); i++)
+            sum += motions[i].settling;
+        return sum;
+    }
+
+    int count(ExitReason reason) const
+    {
+        int n = 0;
+        for(size_t i = 0; i < motions.size(); i++)
+            n += motions[i].exit == reason;
+        return n;
+    }
+};
+
+/// @brief Reads one result line into the results, anything else is ignored
+static void parseLine(const char* line, RouteResult* results)
+{
+    int slot, timedOut, exit;
+    char name[64];
+    MotionResult motion;
+    RouteResult route;
+    if(sscanf(line, "motion %d %63s %lf %lf %lf %lf %d", &slot, name, &motion.start, &motion.duration,
+        &motion.settling, &motion.error, &exit) == 7 && slot >= 1 && slot <= AUTON_ROUTE_COUNT)
+    {
+        motion.name = name;
+        motion.exit = exit;
+        results[slot - 1].motions.push_back(motion);
+    }
+    else if(sscanf(line, "route %d %lf %d %lf %lf %lf %lf %lf %lf", &slot, &route.total, &timedOut, &route.x, &route.y,
+        &route.heading, &route.odomX, &route.odomY, &route.odomHeading) == 9 && slot >= 1 && slot <= AUTON_ROUTE_COUNT)
+    {
+        RouteResult& result = results[slot - 1];
+        result.ran = true;
+        result.total = route.total;
+        result.timedOut = timedOut != 0;
+        result.x = route.x;
+        result.y = route.y;
+        result.heading = route.heading;
+        result.odomX = route.odomX;
+        result.odomY = route.odomY;
+        result.odomHeading = route.odomHeading;
+    }
+}
+
+/// @brief Runs one route in a child process and collects its result lines
+static bool benchmark(const char* self, int slot, RouteResult& result)
+{
+    std::string command = std::string("'") + self + "' --run " + std::to_string(slot) + " 2>&1";
+    FILE* child = popen(command.c_str(), "r");
+    if(!child)
+        return false;
+    RouteResult results[AUTON_ROUTE_COUNT];
+    char line[512];
+    while(fgets(line, sizeof(line), child))
+        if(strncmp(line, "[bench] ", 8) == 0)
+            parseLine(line + 8, results);
+    pclose(child);
+    result = results[slot - 1];
+    return result.ran;
+}
+
+static bool loadBaseline(const char* filename, RouteResult* results)
+{
+    FILE* file = fopen(filename, "r");
+    if(!file)
+        return false;
+    char line[512];
+    while(fgets(line, sizeof(line), file))
+        parseLine(line, results);
+    fclose(file);
+    return true;
+}
+
+static bool saveBaseline(const char* filename, const RouteResult* results)
+{
+    FILE* file = fopen(filename, "w");
+    if(!file)
+        return false;
+    for(int slot = 1; slot <= AUTON_ROUTE_COUNT; slot++)
+    {
+        const RouteResult& r = results[slot - 1];
+        if(!r.ran)
+            continue;
+        for(size_t i = 0; i < r.motions.size(); i++)
+        {
+            const MotionResult& m = r.motions[i];
+            fprintf(file, "motion %d %s %.3f %.3f %.3f %.6f %d\n", slot, m.name.c_str(), m.start, m.duration, m.settling, m.error, m.exit);
+        }
+        fprintf(file, "route %d %.3f %d %.4f %.4f %.4f %.4f %.4f %.4f\n", slot, r.total, r.timedOut ? 1 : 0,
+            r.x, r.y, r.heading, r.odomX, r.odomY, r.odomHeading);
+    }
+    fclose(file);
+    return true;
+}
+
+/// @brief Prints a route's result, next to its baseline when there is one
+/// @return Returns true if the route regressed past the tolerance
+static bool report(int slot, const RouteResult& r, const RouteResult* base, float tolerance)
+{
+    const AutonRoute& route = autonRoutes[slot - 1];
+    double odomError = sqrt((r.odomX - r.x) * (r.odomX - r.x) + (r.odomY - r.y) * (r.odomY - r.y));
+
+    printf("\n%s: %.3f s%s, %u motions, %.0f ms settling, %d timeouts, %d stalls\n", route.name, r.total / 1000,
+        r.timedOut ? " (cut off at the time limit)" : "", (unsigned)r.motions.size(), r.settling(),
+        r.count(EXITED_TIMEOUT), r.count(EXITED_STALLED));
+    printf("  ended at x %.3f y %.3f heading %.3f, odometry off by %.3f in\n", r.x, r.y, r.heading, odomError);
+
+    bool regressed = false;
+    if(base)
+    {
+        double shift = sqrt((r.x - base->x) * (r.x - base->x) + (r.y - base->y) * (r.y - base->y));
+        double slower = r.total - base->total;
+        // A route cut off at its limit can't get slower, it gets fewer motions done
+        regressed = slower > tolerance || (r.timedOut && !base->timedOut) || r.motions.size() < base->motions.size();
+        printf("  baseline %.3f s, %+.0f ms, settling %+.0f ms, end moved %.3f in%s\n", base->total / 1000, slower,
+            r.settling() - base->settling(), shift, regressed ? "  <-- REGRESSION" : slower < -tolerance ? "  (faster)" : "");
+    }
+
+    if(r.motions.empty())
+        return regressed;
+    printf("  %3s %-26s %9s %9s %9s %9s  %-12s %s\n", "#", "motion", "start s", "time ms", "settle ms", "error", "exit", base ? "vs baseline" : "");
+    for(size_t i = 0; i < r.motions.size(); i++)
+    {
+        const MotionResult& m = r.motions[i];
+        printf("  %3u %-26s %9.3f %9.0f %9.0f %9.3f  %-12s", (unsigned)i + 1, m.name.c_str(), m.start / 1000, m.duration,
+            m.settling, m.error, exitReasonName((ExitReason)m.exit));
+        if(base && i < base->motions.size() && base->motions[i].name == m.name)
+            printf(" %+.0f ms", m.duration - base->motions[i].duration);
+        else if(base)
+            printf(" new");
+        printf("\n");
+    }
+    return regressed;
+}
+
+static int usage()
+{
+    fprintf(stderr, "usage: autonbench [--route n] [--baseline file] [--save file] [--tolerance ms]\n");
+    return 2;
+}
+
+int main(int argc, char** argv)
+{
+    const char* baselinePath = 0;
+    const char* savePath = 0;
+    float tolerance = DEFAULT_TOLERANCE;
+    int only = 0;
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--run") == 0 && i + 1 < argc)
+        {
+            int slot = atoi(argv[++i]);
+            if(slot < 1 || slot > AUTON_ROUTE_COUNT)
+                return usage();
+            return runInSimulator(slot);
+        }
+        else if(strcmp(argv[i], "--route") == 0 && i + 1 < argc)
+            only = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+            baselinePath = argv[++i];
+        else if(strcmp(argv[i], "--save") == 0 && i + 1 < argc)
+            savePath = argv[++i];
+        else if(strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc)
+            tolerance = atof(argv[++i]);
+        else
+            return usage();
+    }
+    if(only < 0 || only > AUTON_ROUTE_COUNT)
+        return usage();
+
+    RouteResult baseline[AUTON_ROUTE_COUNT];
+    bool haveBaseline = baselinePath && loadBaseline(baselinePath, baseline);
+    if(baselinePath && !haveBaseline)
+        printf("no baseline at %s, nothing to compare against\n", baselinePath);
+
+    RouteResult results[AUTON_ROUTE_COUNT];
+    int regressions = 0;
+    double total = 0, baseTotal = 0;
+    for(int slot = 1; slot <= AUTON_ROUTE_COUNT; slot++)
+    {
+        if(only && slot != only)
+            continue;
+        if(!benchmark(argv[0], slot, results[slot - 1]))
+        {
+            printf("\n%s: the simulator gave no result\n", autonRoutes[slot - 1].name);
+            regressions++;
+            continue;
+        }
+        const RouteResult* base = haveBaseline && baseline[slot - 1].ran ? &baseline[slot - 1] : 0;
+        if(report(slot, results[slot - 1], base, tolerance))
+            regressions++;
+        total += results[slot - 1].total;
+        if(base)
+            baseTotal += base->total;
+    }
+
+    printf("\n%.3f s over the routes", total / 1000);
+    if(haveBaseline)
+        printf(", baseline %.3f s, %+.0f ms, %d over the %.0f ms tolerance", baseTotal / 1000, total - baseTotal, regressions, tolerance);
+    printf("\n");
+
+    if(savePath)
+    {
+        if(only && haveBaseline && strcmp(savePath, baselinePath) == 0)
+        {
+            // Keep the other routes' baselines when only one was run
+            for(int slot = 1; slot <= AUTON_ROUTE_COUNT; slot++)
+                if(slot != only)
+                    results[slot - 1] = baseline[slot - 1];
+        }
+        if(!saveBaseline(savePath, results))
+        {
+            fprintf(stderr, "autonbench: can't write %s\n", savePath);
+            return 1;
+        }
+        printf("results saved to %s\n", savePath);
+    }
+    return regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,148 @@
+// Card log decoder
+//
+//   cardlog <log> [-o prefix]
+//
+// Reads a CardLog written to the SD card (Drive::logToCard, or any channel a task
+// logs itself) and writes one CSV per channel, <prefix>.<channel>.csv, with the time
+// in seconds from the log's start and then the channel's fields. The prefix is the
+// log's name without its extension unless -o gives one. Prints each channel's record
+// count, span and rate, and the gaps longer than three record periods, which is where
+// the ring filled and records were dropped.
+#include "CardLog.h"
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+struct Channel
+{
+    std::string name;
+    std::string fields;
+    FILE* csv;
+    uint32_t records;
+    double first, last, longestGap;
+    Channel() : csv(0), records(0), first(0), last(0), longestGap(0) {}
+};
+
+static int usage()
+{
+    fprintf(stderr, "usage: cardlog <log> [-o prefix]\n");
+    return 2;
+}
+
+int main(int argc, char** argv)
+{
+    const char* logPath = 0;
+    std::string prefix;
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            prefix = argv[++i];
+        else if(argv[i][0] != '-' && !logPath)
+            logPath = argv[i];
+        else
+            return usage();
+    }
+    if(!logPath)
+        return usage();
+    if(prefix.empty())
+    {
+        prefix = logPath;
+        size_t dot = prefix.find_last_of('.');
+        if(dot != std::string::npos && prefix.find('/', dot) == std::string::npos)
+            prefix.erase(dot);
+    }
+
+    FILE* file = fopen(logPath, "rb");
+    CardLogHeader header;
+    if(!file || fread(&header, sizeof(header), 1, file) != 1 || header.magic != CARD_LOG_MAGIC)
+    {
+        fprintf(stderr, "cardlog: %s is not a card log\n", logPath);
+        return 1;
+    }
+    if(header.version != CARD_LOG_VERSION)
+    {
+        fprintf(stderr, "cardlog: %s is version %u, this reads version %u\n", logPath, (unsigned)header.version, (unsigned)CARD_LOG_VERSION);
+        return 1;
+    }
+
+    std::vector<Channel> channels;
+    uint32_t first, bad = 0;
+    uint32_t words[CARD_LOG_MAX_VALUES + 2];
+    while(fread(&first, 4, 1, file) == 1)
+    {
+        uint32_t length = first & 0xffff;
+        uint16_t channel = first >> 16;
+        if(length < 2 || length > CARD_LOG_MAX_VALUES + 2 || fread(words, 4, length - 1, file) != length - 1)
+        {
+            bad++;
+            break;
+        }
+        double time = words[0] / 1e6;
+
+        if(channel == CARD_LOG_DEFINE)
+        {
+            if(length < 3)
+                continue;
+            uint32_t number = words[1];
+            const char* text = (const char*)&words[2];
+            size_t textBytes = (length - 3) * 4;
+            std::string name(text, strnlen(text, textBytes));
+            size_t nameBytes = name.size() + 1;
+            std::string fields = nameBytes < textBytes ? std::string(text + nameBytes, strnlen(text + nameBytes, textBytes - nameBytes)) : "";
+            if(number >= channels.size())
+                channels.resize(number + 1);
+            Channel& c = channels[number];
+            c.name = name;
+            c.fields = fields;
+            std::string csvPath = prefix + "." + name + ".csv";
+            c.csv = fopen(csvPath.c_str(), "w");
+            if(!c.csv)
+            {
+                fprintf(stderr, "cardlog: can't write %s\n", csvPath.c_str());
+                return 1;
+            }
+            fprintf(c.csv, "time,%s\n", fields.c_str());
+            continue;
+        }
+
+        if(channel >= channels.size() || !channels[channel].csv)
+        {
+            bad++;
+            continue;
+        }
+        Channel& c = channels[channel];
+        if(c.records == 0)
+            c.first = time;
+        else if(time - c.last > c.longestGap)
+            c.longestGap = time - c.last;
+        c.last = time;
+        c.records++;
+
+        fprintf(c.csv, "%.6f", time);
+        for(uint32_t i = 1; i < length - 1; i++)
+        {
+            float value;
+            memcpy(&value, &words[i], 4);
+            fprintf(c.csv, ",%.9g", value);
+        }
+        fprintf(c.csv, "\n");
+    }
+    fclose(file);
+
+    printf("%s:\n", logPath);
+    for(size_t i = 0; i < channels.size(); i++)
+    {
+        Channel& c = channels[i];
+        if(!c.csv)
+            continue;
+        fclose(c.csv);
+        double span = c.last - c.first;
+        double rate = c.records > 1 && span > 0 ? (c.records - 1) / span : 0;
+        printf("  %-16s %8u records over %.3f s, %.1f Hz -> %s.%s.csv\n", c.name.c_str(), (unsigned)c.records, span, rate, prefix.c_str(), c.name.c_str());
+        if(rate > 0 && c.longestGap > 3 / rate)
+            printf("  %-16s longest gap %.3f s, records were dropped\n", "", c.longestGap);
+    }
+    if(bad)
+        printf("  %u records unreadable, the file ends part way through one or is damaged\n", (unsigned)bad);
+    return 0;
+}
@@ -0,0 +1,151 @@
+// Accuracy check and microbenchmark for src/FastMath.cpp
+//
+//   mathbench [--samples n]
+//
+// Measures the largest error of fastSin, fastCos, fastSinCos and fastAtan2
+// against long double libm, next to the error of double libm itself, and what
+// each call costs against the libm call it stands in for. Exits with 1 when an
+// error goes over the bound documented in FastMath.h. Runs on the host, the
+// brain's libm is slower still so the gap there is wider.
+#include "FastMath.h"
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// The bounds FastMath.h promises
+static const double TRIG_BOUND = 1e-15;
+static const double ATAN_BOUND = 1e-15;
+static const double TRIG_RANGE = 1e4;
+
+// Inputs per timing pass, small enough to stay in cache
+static const int BATCH = 4096;
+static const int PASSES = 200;
+
+/// @brief Deterministic uniform numbers so every run checks the same inputs
+static double uniform(unsigned long long& seed, double low, double high)
+{
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    return low + (high - low) * ((seed >> 11) * (1.0 / 9007199254740992.0));
+}
+
+struct Error
+{
+    double fast, libm;
+    double worstInput;
+    Error() : fast(0), libm(0), worstInput(0) {}
+
+    void add(double fastValue, double libmValue, long double exact, double input)
+    {
+        double fastError = fabsl(fastValue - exact);
+        if(fastError > fast)
+        {
+            fast = fastError;
+            worstInput = input;
+        }
+        double libmError = fabsl(libmValue - exact);
+        if(libmError > libm)
+            libm = libmError;
+    }
+};
+
+static volatile double sink;
+
+/// @brief Fastest pass over the inputs, in nanoseconds per call
+template <typename Call>
+static double timeCall(const std::vector<double>& a, const std::vector<double>& b, Call call)
+{
+    double best = 1e9;
+    for(int pass = 0; pass < PASSES; pass++)
+    {
+        double sum = 0;
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        for(int i = 0; i < BATCH; i++)
+            sum += call(a[i], b[i]);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / BATCH;
+        sink = sum;
+        if(ns < best)
+            best = ns;
+    }
+    return best;
+}
+
+static double callFastSin(double x, double) {return fastSin(x);}
+static double callSin(double x, double) {return sin(x);}
+static double callFastCos(double x, double) {return fastCos(x);}
+static double callCos(double x, double) {return cos(x);}
+static double callFastSinCos(double x, double) {double s, c; fastSinCos(x, s, c); return s + c;}
+static double callSinCos(double x, double) {return sin(x) + cos(x);}
+static double callFastAtan2(double y, double x) {return fastAtan2(y, x);}
+static double callAtan2(double y, double x) {return atan2(y, x);}
+
+int main(int argc, char** argv)
+{
+    long samples = 2000000;
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--samples") == 0 && i + 1 < argc)
+            samples = atol(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: mathbench [--samples n]\n");
+            return 1;
+        }
+    }
+
+    // Accuracy, half the inputs over one turn either way where the robot's headings live
+    unsigned long long seed = 1;
+    Error sine, cosine, sineCos, arctangent;
+    for(long i = 0; i < samples; i++)
+    {
+        double x = i % 2 ? uniform(seed, -2 * M_PI, 2 * M_PI) : uniform(seed, -TRIG_RANGE, TRIG_RANGE);
+        long double exactSin = sinl(x), exactCos = cosl(x);
+        sine.add(fastSin(x), sin(x), exactSin, x);
+        cosine.add(fastCos(x), cos(x), exactCos, x);
+        double s, c;
+        fastSinCos(x, s, c);
+        sineCos.add(s, sin(x), exactSin, x);
+        sineCos.add(c, cos(x), exactCos, x);
+
+        // Field sized vectors and a spread of magnitudes
+        double scale = pow(10.0, uniform(seed, -3, 3));
+        double dy = uniform(seed, -1, 1) * scale, dx = uniform(seed, -1, 1) * scale;
+        arctangent.add(fastAtan2(dy, dx), atan2(dy, dx), atan2l(dy, dx), dy);
+    }
+
+    std::vector<double> angles(BATCH), ys(BATCH), xs(BATCH);
+    for(int i = 0; i < BATCH; i++)
+    {
+        angles[i] = uniform(seed, -2 * M_PI, 2 * M_PI);
+        ys[i] = uniform(seed, -72, 72);
+        xs[i] = uniform(seed, -72, 72);
+    }
+
+    printf("%ld samples, sin and cos over +-%.0f rad\n", samples, TRIG_RANGE);
+    printf("              max error fast   max error libm   ns fast   ns libm\n");
+    printf("sin           %14.3g   %14.3g   %7.2f   %7.2f\n", sine.fast, sine.libm,
+        timeCall(angles, angles, callFastSin), timeCall(angles, angles, callSin));
+    printf("cos           %14.3g   %14.3g   %7.2f   %7.2f\n", cosine.fast, cosine.libm,
+        timeCall(angles, angles, callFastCos), timeCall(angles, angles, callCos));
+    printf("sin and cos   %14.3g   %14.3g   %7.2f   %7.2f\n", sineCos.fast, sineCos.libm,
+        timeCall(angles, angles, callFastSinCos), timeCall(angles, angles, callSinCos));
+    printf("atan2         %14.3g   %14.3g   %7.2f   %7.2f\n", arctangent.fast, arctangent.libm,
+        timeCall(ys, xs, callFastAtan2), timeCall(ys, xs, callAtan2));
+
+    bool passed = true;
+    if(sine.fast > TRIG_BOUND || cosine.fast > TRIG_BOUND || sineCos.fast > TRIG_BOUND)
+    {
+        printf("FAIL: sin/cos over %g, worst at %.17g\n", TRIG_BOUND, sine.fast > cosine.fast ? sine.worstInput : cosine.worstInput);
+        passed = false;
+    }
+    if(arctangent.fast > ATAN_BOUND)
+    {
+        printf("FAIL: atan2 over %g, worst at y %.17g\n", ATAN_BOUND, arctangent.worstInput);
+        passed = false;
+    }
+    if(passed)
+        printf("within the documented bounds\n");
+    return passed ? 0 : 1;
+}
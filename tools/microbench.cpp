@@ -0,0 +1,59 @@
+// Control path benchmark on the host
+//
+//   microbench [calls]
+//
+// Runs runControlBenchmarks from src/Benchmark.cpp inside the simulator, with
+// the chassis from src/main.cpp, and prints the same report the brain prints to
+// its serial console. The kernels are timed on the host's clock, the motion loop
+// iterations drive the simulated robot. Default 1000000 calls per kernel.
+//
+// On the brain, uncomment the runControlBenchmarks line in autonomous() instead.
+#include "vex.h"
+#include "Drive.h"
+#include "Benchmark.h"
+#include "OdomCalibration.h"
+#include <stdlib.h>
+
+using namespace vex;
+
+// The chassis from src/main.cpp
+static Drive chassis
+(
+    motor_group(LFT, LFB, LBB, LBT),
+    motor_group(RFT, RFB, RBB, RBT),
+    PORT20,
+    2.66,
+    1,
+    12,
+    TWO_AT_45,
+    1.955,
+    -3.867,
+    -3.867
+);
+
+static uint32_t calls = 1000000;
+
+static void benchmark()
+{
+    chassis.setDriveConstants(0.7, 0.0001, 1.7, 1.00, 80, 2500);
+    chassis.setTrackWidth(12);
+    chassis.setOdomProfile(ODOM_CALIBRATION);
+    rotation1.resetPosition();
+    rotation2.resetPosition();
+    chassis.startOdometry();
+    wait(100, msec);
+
+    runControlBenchmarks(chassis, calls);
+}
+
+int main(int argc, char** argv)
+{
+    if(argc > 1)
+        calls = atol(argv[1]);
+
+    competition field;
+    inertial1.calibrate();
+    field.autonomous(benchmark);
+    while(true)
+        wait(100, msec);
+}
@@ -0,0 +1,111 @@
+# Host tools
+#
+#   make trajectories              rebuilds include/Trajectories.h from routes/*.route
+#   make odomprofile CAL=<log>     fits include/OdomCalibration.h to a calibrateOdometry log,
+#                                  ODOMFIT_FLAGS passes --straights and the nominal geometry
+#   make odombench                 replays a 60 s run through the odometry and the float integrator
+#                                  it replaced and reports the drift, ODOMBENCH_FLAGS passes the options
+#   make mathbench                 checks src/FastMath.cpp against libm and times both
+#   make microbench                times the control path kernels on the simulated chassis,
+#                                  BENCH_CALLS sets the calls per kernel
+#   make replay LOG=<log>          replays a Drive::recordSensors log through the odometry and compares
+#                                  the poses, REPLAY_FLAGS passes the options
+#   make autonbench                runs every auton route in the simulator and compares it with
+#                                  routes/autonbench.txt, AUTONBENCH_FLAGS passes the options
+#   make autonbaseline             saves the current results as routes/autonbench.txt
+#   make cardlog LOG=<log>         decodes a CardLog from the SD card into a CSV per channel
+#
+# The generated headers are committed, so building for the brain never needs
+# the host tools.
+
+TRAJGEN      = $(SIM_BUILD)/tools/trajgen
+ROUTES       = $(wildcard routes/*.route)
+ODOMFIT      = $(SIM_BUILD)/tools/odomfit
+ODOMBENCH    = $(SIM_BUILD)/tools/odombench
+MATHBENCH    = $(SIM_BUILD)/tools/mathbench
+MICROBENCH   = $(SIM_BUILD)/tools/microbench
+REPLAY       = $(SIM_BUILD)/tools/replay
+AUTONBENCH   = $(SIM_BUILD)/tools/autonbench
+AUTONBASE    = routes/autonbench.txt
+CARDLOG      = $(SIM_BUILD)/tools/cardlog
+
+$(TRAJGEN): tools/trajgen.cpp tools/mktools.mk
+	$(Q)$(MKDIR)
+	$(ECHO) "HOST $@"
+	$(Q)$(HOST_CXX) $(SIM_FLAGS) -Iinclude -o $@ tools/trajgen.cpp
+
+trajectories: $(TRAJGEN) $(ROUTES)
+	$(ECHO) "TRAJ include/Trajectories.h"
+	$(Q)./$(TRAJGEN) -o include/Trajectories.h $(ROUTES)
+
+$(ODOMFIT): tools/odomfit.cpp tools/mktools.mk
+	$(Q)$(MKDIR)
+	$(ECHO) "HOST $@"
+	$(Q)$(HOST_CXX) $(SIM_FLAGS) -o $@ tools/odomfit.cpp
+
+odomprofile: $(ODOMFIT)
+	$(ECHO) "FIT  include/OdomCalibration.h"
+	$(Q)./$(ODOMFIT) -o include/OdomCalibration.h $(ODOMFIT_FLAGS) $(CAL)
+
+# Links the sim build of the odometry, the sim supplies the vex timer the pose snapshot stamps with
+$(ODOMBENCH): tools/odombench.cpp $(SIM_BUILD)/src/odom.o $(SIM_BUILD)/src/FastMath.o $(SIM_BUILD)/src/util.o $(SIM_BUILD)/src/SensorLog.o $(filter $(SIM_BUILD)/sim/%,$(SIM_OBJ)) tools/mktools.mk
+	$(Q)$(MKDIR)
+	$(ECHO) "HOST $@"
+	$(Q)$(HOST_CXX) $(SIM_FLAGS) $(SIM_INC) -o $@ $(filter %.cpp %.o,$^)
+
+odombench: $(ODOMBENCH)
+	$(Q)./$(ODOMBENCH) $(ODOMBENCH_FLAGS)
+
+$(MATHBENCH): tools/mathbench.cpp src/FastMath.cpp include/FastMath.h tools/mktools.mk
+	$(Q)$(MKDIR)
+	$(ECHO) "HOST $@"
+	$(Q)$(HOST_CXX) $(SIM_FLAGS) -Iinclude -o $@ tools/mathbench.cpp src/FastMath.cpp
+
+mathbench: $(MATHBENCH)
+	$(Q)./$(MATHBENCH)
+
+# The sim build with its own main in place of src/main.cpp
+$(MICROBENCH): tools/microbench.cpp $(filter-out $(SIM_BUILD)/src/main.o,$(SIM_OBJ)) tools/mktools.mk
+	$(Q)$(MKDIR)
+	$(ECHO) "HOST $@"
+	$(Q)$(HOST_CXX) $(SIM_FLAGS) $(SIM_INC) -o $@ $(filter %.cpp %.o,$^)
+
+microbench: $(MICROBENCH)
+	$(Q)SIM_PERIOD_MS=600000 ./$(MICROBENCH) $(BENCH_CALLS)
+
+$(REPLAY): tools/replay.cpp $(filter-out $(SIM_BUILD)/src/main.o,$(SIM_OBJ)) tools/mktools.mk
+	$(Q)$(MKDIR)
+	$(ECHO) "HOST $@"
+	$(Q)$(HOST_CXX) $(SIM_FLAGS) $(SIM_INC) -o $@ $(filter %.cpp %.o,$^)
+
+replay: $(REPLAY)
+	$(Q)./$(REPLAY) $(LOG) $(REPLAY_FLAGS)
+
+# src/main.cpp again with its main renamed, so the routes and the robot config link in
+# next to the bench's own main. Linked last like src/main.o in the sim build, so the other
+# sources' statics are constructed before the robot's globals use them
+$(SIM_BUILD)/tools/autonbench-main.o: src/main.cpp $(wildcard include/*.h) tools/mktools.mk
+	$(Q)$(MKDIR)
+	$(ECHO) "HOST $@"
+	$(Q)$(HOST_CXX) $(SIM_FLAGS) $(SIM_INC) -Dmain=robotMain -c -o $@ src/main.cpp
+
+$(AUTONBENCH): tools/autonbench.cpp $(filter-out $(SIM_BUILD)/src/main.o,$(SIM_OBJ)) $(SIM_BUILD)/tools/autonbench-main.o tools/mktools.mk
+	$(Q)$(MKDIR)
+	$(ECHO) "HOST $@"
+	$(Q)$(HOST_CXX) $(SIM_FLAGS) $(SIM_INC) -o $@ $(filter %.cpp %.o,$^)
+
+autonbench: $(AUTONBENCH)
+	$(Q)./$(AUTONBENCH) --baseline $(AUTONBASE) $(AUTONBENCH_FLAGS)
+
+autonbaseline: $(AUTONBENCH)
+	$(Q)./$(AUTONBENCH) --save $(AUTONBASE) $(AUTONBENCH_FLAGS)
+
+$(CARDLOG): tools/cardlog.cpp include/CardLog.h tools/mktools.mk
+	$(Q)$(MKDIR)
+	$(ECHO) "HOST $@"
+	$(Q)$(HOST_CXX) $(SIM_FLAGS) $(SIM_INC) -o $@ tools/cardlog.cpp
+
+cardlog: $(CARDLOG)
+	$(Q)./$(CARDLOG) $(LOG)
+
+.PHONY: trajectories odomprofile odombench mathbench microbench replay autonbench autonbaseline cardlog
@@ -0,0 +1,411 @@
+// Odometry drift benchmark
+//
+//   odombench [--pods 45|vertical] [--start x,y,heading] [--resolution deg] [--save log.csv] [--log log.csv]
+//
+// Replays a 60 s run through the odometry in src/odom.cpp and through a copy of
+// the single precision integrator it replaced, and reports how far each drifts
+// from the truth and what an update costs. Runs on the host.
+//
+// Without --log the run is synthesized: a skills-like string of drives, turns
+// and arcs, integrated exactly in long double every 0.1 ms, with the pods and
+// the inertial heading sampled every 5 ms like the odometry task. --save writes
+// it out, --log replays a saved or recorded one instead. A log is
+//
+//   time_ms,rotation1,rotation2,heading[,x,y,true_heading]
+//
+// and without the truth columns only the gap between the two integrators is
+// reported. --resolution rounds the pods to the sensor resolution, the V5
+// rotation sensor is 0.088 degrees, off by default so only the arithmetic differs.
+#include "odom.h"
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+struct Sample
+{
+    double time;            // ms
+    double pods[2];         // rotation1, rotation2 degrees
+    double heading;         // inertial degrees, 0 - 360
+    bool hasTruth;
+    double x, y, trueHeading;
+};
+
+/// @brief Pod geometry of the run, matches the Drive setup for each odometry type
+struct Geometry
+{
+    bool vertical;
+    double diameter;
+    double angle[2];        // degrees from forward toward the right
+    double lever[2];        // inches per radian clockwise
+};
+
+/// @brief One piece of the synthesized run, speeds follow sin^2 so every piece starts and ends at rest
+struct Piece
+{
+    double duration;        // s
+    double forward;         // peak in/s
+    double turn;            // peak deg/s, clockwise
+};
+
+static const Piece RUN[] = {
+    {1.6, 55, 0}, {0.8, 0, 220}, {1.2, 45, 0}, {1.5, 40, 60}, {0.9, 0, -260},
+    {2.0, 60, 0}, {1.0, -40, 0}, {1.4, 35, -80}, {0.7, 0, 300}, {1.8, 50, 15},
+    {0.6, -30, 0}, {1.1, 0, -200}, {2.2, 55, -25}, {1.3, 40, 90}, {0.9, 0, 180}, {1.0, 0, 200},
+};
+
+// The integrator src/odom.cpp replaced: degrees held in float, both readings scaled
+// to inches every update and the pose accumulated in float. Kept as it was.
+class LegacyOdom
+{
+    public:
+        float forwardDegreesL, forwardDegreesR;
+        float xPosition, yPosition, heading;
+        float wheelDiameter;
+        float leftDistance, rightDistance;
+        float leftPodAngle, rightPodAngle;
+        float gyroWeight;
+        PoseSnapshot snapshot;
+
+        void setPosition(float x, float y, float h)
+        {
+            xPosition = x;
+            yPosition = y;
+            heading = h;
+            snapshot.write(xPosition, yPosition, heading);
+        }
+
+        void updatePositionTwoAt45(float currentLeftDegrees, float currentRightDegrees, float headingGyro)
+        {
+            float deltaLeft = degToInches(currentLeftDegrees - forwardDegreesL, wheelDiameter);
+            float deltaRight = degToInches(currentRightDegrees - forwardDegreesR, wheelDiameter);
+
+            float deltaHeading = degTo180(headingGyro - heading);
+
+            deltaLeft -= leftDistance*degToRad(deltaHeading);
+            deltaRight += rightDistance*degToRad(deltaHeading);
+
+            float leftAngle = degToRad(leftPodAngle);
+            float rightAngle = degToRad(rightPodAngle);
+            float determinant = sin(rightAngle - leftAngle);
+            float deltaForward = (deltaLeft * sin(rightAngle) - deltaRight * sin(leftAngle)) / determinant;
+            float deltaLateral = (deltaRight * cos(leftAngle) - deltaLeft * cos(rightAngle)) / determinant;
+
+            float avgHeading = degToRad(heading+deltaHeading/2.0);
+            float globalDeltaX = deltaForward * sin(avgHeading) + deltaLateral * cos(avgHeading);
+            float globalDeltaY = deltaForward * cos(avgHeading) - deltaLateral * sin(avgHeading);
+            setPosition((globalDeltaX+xPosition), (globalDeltaY+yPosition), headingGyro);
+
+            forwardDegreesR = currentRightDegrees;
+            forwardDegreesL = currentLeftDegrees;
+            heading = headingGyro;
+        }
+
+        void updatePositionTwoVertical(float currentLeftDegrees, float currentRightDegrees, float headingGyro)
+        {
+            float deltaLeft = degToInches(currentLeftDegrees - forwardDegreesL, wheelDiameter);
+            float deltaRight = degToInches(currentRightDegrees - forwardDegreesR, wheelDiameter);
+
+            float podSpacing = leftDistance + rightDistance;
+            float deltaHeading = 0;
+            float deltaForward = (deltaLeft + deltaRight) / 2.0;
+            if(fabs(podSpacing) > 0.01){
+                deltaHeading = (deltaLeft - deltaRight) / podSpacing;
+                deltaForward = (deltaLeft * rightDistance + deltaRight * leftDistance) / podSpacing;
+            }
+
+            if(gyroWeight > 0){
+                float podHeading = heading + deltaHeading * 180.0 / M_PI;
+                deltaHeading += degToRad(gyroWeight * degTo180(headingGyro - podHeading));
+            }
+
+            float chord = deltaForward;
+            if(fabs(deltaHeading) > 1e-4)
+                chord = deltaForward * sin(deltaHeading / 2.0) / (deltaHeading / 2.0);
+
+            float avgHeading = degToRad(heading) + deltaHeading / 2.0;
+            float newHeading = fmod(heading + deltaHeading * 180.0 / M_PI, 360);
+            if(newHeading < 0)
+                newHeading += 360;
+            setPosition(xPosition + chord * sin(avgHeading), yPosition + chord * cos(avgHeading), newHeading);
+
+            forwardDegreesL = currentLeftDegrees;
+            forwardDegreesR = currentRightDegrees;
+        }
+};
+
+static void fail(const char* message, const char* detail)
+{
+    fprintf(stderr, "odombench: %s %s\n", message, detail ? detail : "");
+    exit(1);
+}
+
+/// @brief Integrates the scripted run, repeated out to 60 s, exactly and samples the sensors every 5 ms
+static std::vector<Sample> synthesize(const Geometry& geometry, const double start[3], double resolution)
+{
+    const long double STEP = 1e-4L;
+    const int SUBSTEPS = 50;
+    const long double LENGTH = 60;
+    long double x = start[0], y = start[1], heading = start[2] * M_PI / 180;
+    long double pods[2] = {0, 0};
+    long double podScale = 360.0L / (M_PI * geometry.diameter);
+
+    std::vector<Sample> samples;
+    long double time = 0;
+    int steps = 0;
+    for(size_t i = 0; time < LENGTH; i++)
+    {
+        const Piece& piece = RUN[i % (sizeof(RUN) / sizeof(RUN[0]))];
+        int pieceSteps = (int)(piece.duration / STEP);
+        for(int k = 0; k < pieceSteps && time < LENGTH; k++, steps++)
+        {
+            if(steps % SUBSTEPS == 0)
+            {
+                Sample s;
+                s.time = (double)(time * 1000);
+                for(int p = 0; p < 2; p++)
+                {
+                    s.pods[p] = (double)pods[p];
+                    if(resolution > 0)
+                        s.pods[p] = resolution * floor(s.pods[p] / resolution + 0.5);
+                }
+                long double wrapped = fmodl(heading * 180 / M_PI, 360);
+                s.heading = (double)(wrapped < 0 ? wrapped + 360 : wrapped);
+                s.hasTruth = true;
+                s.x = (double)x;
+                s.y = (double)y;
+                s.trueHeading = s.heading;
+                samples.push_back(s);
+            }
+
+            // Speed at the middle of the step, then the exact arc at that speed
+            long double phase = sinl(M_PI * (k + 0.5L) / pieceSteps);
+            long double forward = piece.forward * phase * phase;
+            long double turn = piece.turn * M_PI / 180 * phase * phase;
+            long double dHeading = turn * STEP;
+            long double chord = forward * STEP * (fabsl(dHeading) > 1e-12L ? sinl(dHeading / 2) / (dHeading / 2) : 1);
+            long double middle = heading + dHeading / 2;
+            x += chord * sinl(middle);
+            y += chord * cosl(middle);
+            heading += dHeading;
+            for(int p = 0; p < 2; p++)
+                pods[p] += (forward * cosl(geometry.angle[p] * M_PI / 180) + geometry.lever[p] * turn) * STEP * podScale;
+            time += STEP;
+        }
+    }
+    return samples;
+}
+
+static std::vector<Sample> readLog(const char* file)
+{
+    FILE* in = fopen(file, "r");
+    if(!in)
+        fail("can't open", file);
+    std::vector<Sample> samples;
+    char buffer[256];
+    while(fgets(buffer, sizeof(buffer), in))
+    {
+        Sample s;
+        int fields = sscanf(buffer, "%lf,%lf,%lf,%lf,%lf,%lf,%lf", &s.time, &s.pods[0], &s.pods[1], &s.heading, &s.x, &s.y, &s.trueHeading);
+        if(fields < 4)
+            continue;
+        s.hasTruth = fields == 7;
+        samples.push_back(s);
+    }
+    fclose(in);
+    if(samples.empty())
+        fail("no samples in", file);
+    return samples;
+}
+
+static void writeLog(const char* file, const std::vector<Sample>& samples)
+{
+    FILE* out = fopen(file, "w");
+    if(!out)
+        fail("can't write", file);
+    fprintf(out, "time_ms,rotation1,rotation2,heading,x,y,true_heading\n");
+    for(size_t i = 0; i < samples.size(); i++)
+    {
+        const Sample& s = samples[i];
+        fprintf(out, "%.1f,%.9f,%.9f,%.9f,%.9f,%.9f,%.9f\n", s.time, s.pods[0], s.pods[1], s.heading, s.x, s.y, s.trueHeading);
+    }
+    fclose(out);
+}
+
+/// @brief Error of a pose against the truth, the worst one over the run is kept
+struct Drift
+{
+    double final, worst, heading;
+    Drift() : final(0), worst(0), heading(0) {}
+
+    void add(double x, double y, double h, const Sample& s)
+    {
+        if(!s.hasTruth)
+            return;
+        final = hypot(x - s.x, y - s.y);
+        if(final > worst)
+            worst = final;
+        heading = fabs(degTo180(h - s.trueHeading));
+    }
+};
+
+static Odom makeOdom(const Geometry& geometry, const Sample& first, const double start[3])
+{
+    Odom odom;
+    if(geometry.vertical)
+    {
+        odom = Odom(geometry.diameter, geometry.diameter, 0, -geometry.lever[1], geometry.lever[0], 0);
+        odom.setGyroWeight(0.02);
+    }
+    else
+    {
+        odom = Odom(geometry.diameter, geometry.lever[0], -geometry.lever[1]);
+        OdomProfile profile = {(float)geometry.diameter, (float)geometry.diameter, (float)geometry.angle[0], (float)geometry.angle[1],
+            (float)geometry.lever[0], (float)geometry.lever[1], 0, 0};
+        odom.setProfile(profile);
+    }
+    odom.setPosition(start[0], start[1], first.heading);
+    odom.setForwardLeftDegrees(first.pods[0]);
+    odom.setForwardRightDegrees(first.pods[1]);
+    return odom;
+}
+
+static LegacyOdom makeLegacy(const Geometry& geometry, const Sample& first, const double start[3])
+{
+    LegacyOdom odom;
+    odom.wheelDiameter = geometry.diameter;
+    odom.leftDistance = geometry.lever[0];
+    odom.rightDistance = -geometry.lever[1];
+    odom.leftPodAngle = geometry.angle[0];
+    odom.rightPodAngle = geometry.angle[1];
+    odom.gyroWeight = geometry.vertical ? 0.02 : 0;
+    odom.setPosition(start[0], start[1], first.heading);
+    odom.forwardDegreesL = first.pods[0];
+    odom.forwardDegreesR = first.pods[1];
+    return odom;
+}
+
+static double nanoseconds(std::chrono::steady_clock::time_point begin, long updates)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / updates;
+}
+
+int main(int argc, char** argv)
+{
+    Geometry geometry = {false, 1.955, {48, -48}, {-3.867, 3.867}};
+    double start[3] = {-48, -60, 90};
+    double resolution = 0;
+    const char* save = 0;
+    const char* log = 0;
+    for(int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if(strcmp(argv[i], "--pods") == 0 && hasValue)
+        {
+            const char* pods = argv[++i];
+            if(strcmp(pods, "vertical") == 0)
+            {
+                Geometry vertical = {true, 2.0, {0, 0}, {3.867, -3.867}};
+                geometry = vertical;
+            }
+            else if(strcmp(pods, "45") != 0)
+                fail("--pods takes 45 or vertical, not", pods);
+        }
+        else if(strcmp(argv[i], "--start") == 0 && hasValue)
+        {
+            if(sscanf(argv[++i], "%lf,%lf,%lf", &start[0], &start[1], &start[2]) != 3)
+                fail("--start takes x,y,heading", 0);
+        }
+        else if(strcmp(argv[i], "--resolution") == 0 && hasValue)
+            resolution = atof(argv[++i]);
+        else if(strcmp(argv[i], "--save") == 0 && hasValue)
+            save = argv[++i];
+        else if(strcmp(argv[i], "--log") == 0 && hasValue)
+            log = argv[++i];
+        else
+        {
+            fprintf(stderr, "usage: odombench [--pods 45|vertical] [--start x,y,heading] [--resolution deg] [--save log.csv] [--log log.csv]\n");
+            return 1;
+        }
+    }
+
+    std::vector<Sample> samples = log ? readLog(log) : synthesize(geometry, start, resolution);
+    if(save)
+        writeLog(save, samples);
+    if(log && samples[0].hasTruth)
+    {
+        start[0] = samples[0].x;
+        start[1] = samples[0].y;
+    }
+
+    // Drift, each sample read the way Drive::updatePosition reads it
+    Odom odom = makeOdom(geometry, samples[0], start);
+    LegacyOdom legacy = makeLegacy(geometry, samples[0], start);
+    Drift odomDrift, legacyDrift;
+    double gap = 0;
+    for(size_t i = 1; i < samples.size(); i++)
+    {
+        const Sample& s = samples[i];
+        if(geometry.vertical)
+        {
+            odom.updatePositionTwoVertical(s.pods[0], s.pods[1], s.heading);
+            legacy.updatePositionTwoVertical(s.pods[0], s.pods[1], s.heading);
+        }
+        else
+        {
+            odom.updatePositionTwoAt45(s.pods[0], s.pods[1], s.heading);
+            legacy.updatePositionTwoAt45(s.pods[0], s.pods[1], s.heading);
+        }
+        Pose pose = odom.getPose();
+        odomDrift.add(pose.x, pose.y, pose.heading, s);
+        legacyDrift.add(legacy.xPosition, legacy.yPosition, legacy.heading, s);
+        gap = hypot(pose.x - legacy.xPosition, pose.y - legacy.yPosition);
+    }
+
+    // Cost, the fastest of many interleaved replays so a busy host doesn't count against either
+    const int REPEATS = 50;
+    long updates = (long)(samples.size() - 1);
+    double odomCost = 1e9, legacyCost = 1e9;
+    for(int r = 0; r < REPEATS; r++)
+    {
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        Odom timed = makeOdom(geometry, samples[0], start);
+        for(size_t i = 1; i < samples.size(); i++)
+        {
+            if(geometry.vertical)
+                timed.updatePositionTwoVertical(samples[i].pods[0], samples[i].pods[1], samples[i].heading);
+            else
+                timed.updatePositionTwoAt45(samples[i].pods[0], samples[i].pods[1], samples[i].heading);
+        }
+        odomCost = fmin(odomCost, nanoseconds(begin, updates));
+
+        begin = std::chrono::steady_clock::now();
+        LegacyOdom timedLegacy = makeLegacy(geometry, samples[0], start);
+        for(size_t i = 1; i < samples.size(); i++)
+        {
+            if(geometry.vertical)
+                timedLegacy.updatePositionTwoVertical(samples[i].pods[0], samples[i].pods[1], samples[i].heading);
+            else
+                timedLegacy.updatePositionTwoAt45(samples[i].pods[0], samples[i].pods[1], samples[i].heading);
+        }
+        legacyCost = fmin(legacyCost, nanoseconds(begin, updates));
+    }
+
+    const Sample& last = samples.back();
+    printf("%s pods, %zu updates over %.1f s\n", geometry.vertical ? "two vertical" : "two at 45", samples.size() - 1, last.time / 1000);
+    if(last.hasTruth)
+    {
+        printf("truth     end x %9.4f y %9.4f heading %8.3f\n", last.x, last.y, last.trueHeading);
+        printf("            final drift   worst drift   heading   ns/update\n");
+        printf("odom       %8.5f in   %8.5f in   %6.4f deg   %6.1f\n", odomDrift.final, odomDrift.worst, odomDrift.heading, odomCost);
+        printf("legacy     %8.5f in   %8.5f in   %6.4f deg   %6.1f\n", legacyDrift.final, legacyDrift.worst, legacyDrift.heading, legacyCost);
+    }
+    else
+    {
+        printf("odom and legacy end %.5f in apart\n", gap);
+        printf("ns/update  odom %.1f, legacy %.1f\n", odomCost, legacyCost);
+    }
+    return 0;
+}
@@ -0,0 +1,286 @@
+// Odometry geometry fitter
+//
+//   odomfit [-o include/OdomCalibration.h] [options] odomcal.csv
+//
+// Reads the log Drive::calibrateOdometry writes to the SD card and fits the
+// geometry of the tracking pods and the drive by least squares, then writes it
+// out as the OdomProfile Drive::setOdomProfile takes. Runs on the host.
+//
+// Each pod reading over a segment is modelled as
+//
+//   degrees = scale * distance + lever * turn
+//
+// with the distance in inches from the straights and the turn in radians from
+// the inertial sensor. A tank drive never moves sideways, so scale only pins
+// down cos(angle) / diameter. With an angled pod the measured diameter is kept
+// and the angle fitted, with a vertical pod (angle 0) the diameter is fitted.
+//
+// Options:
+//
+//   --pod-diameter <in>             measured tracking wheel diameter, default 2
+//   --pod-angles <left>,<right>     nominal mounting angles in degrees, default 45,-45
+//   --wheel-diameter <in>           drive wheel diameter the log was driven with, default 2.66
+//   --wheel-ratio <ratio>           wheel turns per motor turn, default 1
+//   --straights <in>,<in>,...       tape measured length of every straight, in order.
+//                                   Without them the drive encoders are taken as the truth
+//                                   and the drive wheel diameter can't be fitted.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+struct Segment
+{
+    bool spin;
+    float target;
+    bool started;
+    double first[5];    // rotation1, rotation2, left, right, inertial
+    double last[5];
+};
+
+struct PodFit
+{
+    double scale;       // degrees per inch forward
+    double lever;       // degrees per radian clockwise
+    double rms;         // degrees
+};
+
+static void fail(const char* message, const char* detail)
+{
+    fprintf(stderr, "odomfit: %s %s\n", message, detail ? detail : "");
+    exit(1);
+}
+
+/// @brief Reads the first and last sample of every segment
+static std::vector<Segment> readLog(const char* file)
+{
+    FILE* in = fopen(file, "r");
+    if(!in)
+        fail("can't open", file);
+
+    std::vector<Segment> segments;
+    char buffer[256];
+    while(fgets(buffer, sizeof(buffer), in))
+    {
+        int index;
+        char kind[16];
+        float target, time;
+        double v[5];
+        if(sscanf(buffer, "%d,%15[^,],%f,%f,%lf,%lf,%lf,%lf,%lf", &index, kind, &target, &time, &v[0], &v[1], &v[2], &v[3], &v[4]) != 9)
+            continue;
+        if(index < 0)
+            continue;
+        if((int)segments.size() <= index)
+        {
+            Segment empty;
+            empty.started = false;
+            segments.resize(index + 1, empty);
+        }
+        Segment& segment = segments[index];
+        if(!segment.started)
+        {
+            segment.started = true;
+            segment.spin = strcmp(kind, "spin") == 0;
+            segment.target = target;
+            memcpy(segment.first, v, sizeof(v));
+        }
+        memcpy(segment.last, v, sizeof(v));
+    }
+    fclose(in);
+    return segments;
+}
+
+/// @brief Reads a comma separated list of numbers
+static std::vector<double> readList(const char* text)
+{
+    std::vector<double> values;
+    while(*text)
+    {
+        char* end;
+        values.push_back(strtod(text, &end));
+        if(end == text)
+            fail("bad number list", text);
+        text = *end == ',' ? end + 1 : end;
+    }
+    return values;
+}
+
+/// @brief Least squares fit of degrees = scale * distance + lever * turn
+static PodFit fitPod(const std::vector<double>& distance, const std::vector<double>& turn, const std::vector<double>& degrees)
+{
+    double dd = 0, dt = 0, tt = 0, dy = 0, ty = 0;
+    for(size_t i = 0; i < degrees.size(); i++)
+    {
+        dd += distance[i] * distance[i];
+        dt += distance[i] * turn[i];
+        tt += turn[i] * turn[i];
+        dy += distance[i] * degrees[i];
+        ty += turn[i] * degrees[i];
+    }
+    double determinant = dd * tt - dt * dt;
+    if(fabs(determinant) < 1e-9)
+        fail("the log needs both straights and spins", 0);
+
+    PodFit fit;
+    fit.scale = (dy * tt - ty * dt) / determinant;
+    fit.lever = (ty * dd - dy * dt) / determinant;
+
+    double squares = 0;
+    for(size_t i = 0; i < degrees.size(); i++)
+    {
+        double residual = degrees[i] - fit.scale * distance[i] - fit.lever * turn[i];
+        squares += residual * residual;
+    }
+    fit.rms = sqrt(squares / degrees.size());
+    return fit;
+}
+
+/// @brief Turns a pod fit into a diameter, angle and lever
+static void podGeometry(const PodFit& fit, double nominalDiameter, double nominalAngle, double& diameter, double& angle, double& lever)
+{
+    // cos(angle) with the measured diameter
+    double cosine = fit.scale * M_PI * nominalDiameter / 360;
+    if(nominalAngle != 0 && fabs(cosine) <= 1)
+    {
+        diameter = nominalDiameter;
+        angle = acos(fabs(cosine)) * 180 / M_PI * (nominalAngle < 0 ? -1 : 1);
+    }
+    else
+    {
+        if(nominalAngle != 0)
+            printf("  pod reads more than the diameter allows, keeping the %.1f deg angle and fitting the diameter\n", nominalAngle);
+        angle = nominalAngle;
+        diameter = 360 * cos(nominalAngle * M_PI / 180) / (M_PI * fabs(fit.scale));
+    }
+    lever = fit.lever * M_PI * diameter / 360;
+}
+
+int main(int argc, char** argv)
+{
+    const char* output = 0;
+    const char* input = 0;
+    double podDiameter = 2, leftAngle = 45, rightAngle = -45;
+    double wheelDiameter = 2.66, wheelRatio = 1;
+    std::vector<double> measured;
+    for(int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if(strcmp(argv[i], "-o") == 0 && hasValue)
+            output = argv[++i];
+        else if(strcmp(argv[i], "--pod-diameter") == 0 && hasValue)
+            podDiameter = atof(argv[++i]);
+        else if(strcmp(argv[i], "--pod-angles") == 0 && hasValue)
+        {
+            std::vector<double> angles = readList(argv[++i]);
+            if(angles.size() != 2)
+                fail("--pod-angles takes left,right", 0);
+            leftAngle = angles[0];
+            rightAngle = angles[1];
+        }
+        else if(strcmp(argv[i], "--wheel-diameter") == 0 && hasValue)
+            wheelDiameter = atof(argv[++i]);
+        else if(strcmp(argv[i], "--wheel-ratio") == 0 && hasValue)
+            wheelRatio = atof(argv[++i]);
+        else if(strcmp(argv[i], "--straights") == 0 && hasValue)
+            measured = readList(argv[++i]);
+        else
+            input = argv[i];
+    }
+    if(!input)
+    {
+        fprintf(stderr, "usage: odomfit [-o output.h] [--pod-diameter in] [--pod-angles l,r] [--wheel-diameter in] [--wheel-ratio r] [--straights in,...] log.csv\n");
+        return 1;
+    }
+
+    std::vector<Segment> segments = readLog(input);
+
+    // Segment deltas, the encoders in inches with the nominal drive wheel
+    double motorInches = wheelRatio * M_PI * wheelDiameter / 360;
+    std::vector<double> distance, turn, left, right;
+    std::vector<double> encoder, truth;         // straights, for the drive wheel
+    std::vector<double> spinTurn, spinDiff;     // spins, for the track width
+    size_t straights = 0;
+    for(size_t i = 0; i < segments.size(); i++)
+    {
+        const Segment& s = segments[i];
+        if(!s.started)
+            continue;
+        double leftInches = (s.last[2] - s.first[2]) * motorInches;
+        double rightInches = (s.last[3] - s.first[3]) * motorInches;
+        double turned = (s.last[4] - s.first[4]) * M_PI / 180;
+
+        double traveled = (leftInches + rightInches) / 2;
+        if(!s.spin)
+        {
+            encoder.push_back(traveled);
+            if(straights < measured.size())
+                traveled = fabs(measured[straights]) * (s.target < 0 ? -1 : 1);
+            truth.push_back(traveled);
+            straights++;
+        }
+        else
+        {
+            spinTurn.push_back(turned);
+            spinDiff.push_back(leftInches - rightInches);
+        }
+
+        distance.push_back(traveled);
+        turn.push_back(turned);
+        left.push_back(s.last[0] - s.first[0]);
+        right.push_back(s.last[1] - s.first[1]);
+    }
+    if(!measured.empty() && measured.size() != straights)
+        fail("--straights needs one length per straight in the log", 0);
+    if(measured.empty())
+        printf("no --straights given, the drive encoders are taken as the distance\n");
+
+    // Drive wheel from the straights, track width from the spins with the corrected wheel
+    double encoderSquares = 0, encoderTruth = 0;
+    for(size_t i = 0; i < encoder.size(); i++)
+    {
+        encoderSquares += encoder[i] * encoder[i];
+        encoderTruth += encoder[i] * truth[i];
+    }
+    double wheelScale = encoderSquares > 0 ? encoderTruth / encoderSquares : 1;
+    double turnSquares = 0, turnDiff = 0;
+    for(size_t i = 0; i < spinTurn.size(); i++)
+    {
+        turnSquares += spinTurn[i] * spinTurn[i];
+        turnDiff += spinTurn[i] * spinDiff[i] * wheelScale;
+    }
+    double trackWidth = turnSquares > 0 ? turnDiff / turnSquares : 0;
+
+    PodFit leftFit = fitPod(distance, turn, left);
+    PodFit rightFit = fitPod(distance, turn, right);
+    double leftDiameter, leftFitAngle, leftLever;
+    double rightDiameter, rightFitAngle, rightLever;
+    printf("left pod (rotation1):\n");
+    podGeometry(leftFit, podDiameter, leftAngle, leftDiameter, leftFitAngle, leftLever);
+    printf("  diameter %.4f in, angle %.2f deg, lever %.3f in/rad, rms %.3f in\n",
+        leftDiameter, leftFitAngle, leftLever, leftFit.rms * M_PI * leftDiameter / 360);
+    printf("right pod (rotation2):\n");
+    podGeometry(rightFit, podDiameter, rightAngle, rightDiameter, rightFitAngle, rightLever);
+    printf("  diameter %.4f in, angle %.2f deg, lever %.3f in/rad, rms %.3f in\n",
+        rightDiameter, rightFitAngle, rightLever, rightFit.rms * M_PI * rightDiameter / 360);
+    printf("drive: wheel diameter %.4f in, track width %.3f in\n", wheelDiameter * wheelScale, trackWidth);
+    printf("%zu straights, %zu spins\n", straights, spinTurn.size());
+
+    FILE* out = output ? fopen(output, "w") : stdout;
+    if(!out)
+        fail("can't write", output);
+    fprintf(out, "#pragma once\n");
+    fprintf(out, "// Generated by tools/odomfit from %s, run make odomprofile CAL=<log> after a calibration run\n", input);
+    fprintf(out, "#include \"OdomProfile.h\"\n\n");
+    fprintf(out, "const OdomProfile ODOM_CALIBRATION = {\n");
+    fprintf(out, "    %.4f, %.4f,     // pod diameters (in)\n", leftDiameter, rightDiameter);
+    fprintf(out, "    %.3f, %.3f,     // pod angles (deg)\n", leftFitAngle, rightFitAngle);
+    fprintf(out, "    %.3f, %.3f,     // pod levers (in/rad)\n", leftLever, rightLever);
+    fprintf(out, "    %.4f,             // drive wheel diameter (in)\n", wheelDiameter * wheelScale);
+    fprintf(out, "    %.3f              // track width (in)\n", trackWidth);
+    fprintf(out, "};\n");
+    if(output)
+        fclose(out);
+    return 0;
+}
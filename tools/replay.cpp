@@ -0,0 +1,206 @@
+// Sensor log replay
+//
+//   replay <log> [--odometry | --estimator] [--against <log>] [--tolerance in] [--csv file]
+//
+// Feeds a SensorLog recorded by Drive::recordSensors back through the pose update
+// the odometry task runs (Drive::integrateSensors, Drive::resetToSensors) on the
+// chassis from src/main.cpp, and compares every pose with the one recorded. With
+// the code and calibration the log was recorded with the replay is bit-exact, after
+// a change to the odometry math or include/OdomCalibration.h it shows how far the
+// poses move on the same field data.
+//
+// --odometry and --estimator replay through that pose source instead of the one
+// the log was recorded with. --against compares the log sample by sample with
+// another recording of the same run, such as the one the simulator records while
+// it plays this log back (SIM_REPLAY), for the drive's voltage commands after a
+// controller change. --tolerance exits with 1 if a replayed pose ends up further
+// than that many inches from the recorded one. --csv writes both poses per sample.
+#include "vex.h"
+#include "Drive.h"
+#include "SensorLog.h"
+#include "OdomCalibration.h"
+#include <stdlib.h>
+
+using namespace vex;
+
+/// @brief Worst disagreement between two pose or voltage series
+struct Divergence
+{
+    double position;    // inches
+    double heading;     // degrees
+    double volts;
+    int32_t first;      // first sample that differs at all, -1 if none
+    Divergence() : position(0), heading(0), volts(0), first(-1) {}
+
+    void add(int32_t index, double dx, double dy, double dHeading, double dVolts)
+    {
+        dHeading = fabs(dHeading - 360 * floor(dHeading / 360 + 0.5));
+        double distance = sqrt(dx * dx + dy * dy);
+        if((distance > 0 || dHeading > 0 || dVolts > 0) && first < 0)
+            first = index;
+        position = fmax(position, distance);
+        heading = fmax(heading, dHeading);
+        volts = fmax(volts, dVolts);
+    }
+};
+
+static const char* odomName(int32_t odomType)
+{
+    switch(odomType)
+    {
+        case NO_ODOM: return "NO_ODOM";
+        case HORIZONTAL_AND_VERTICAL: return "HORIZONTAL_AND_VERTICAL";
+        case TWO_VERTICAL: return "TWO_VERTICAL";
+        case TWO_AT_45: return "TWO_AT_45";
+        default: return "unknown";
+    }
+}
+
+/// @brief Seconds from the start of recording to a sample
+static double sampleTime(const SensorLog& log, uint32_t index)
+{
+    return (log[index].time - log.getStartTime()) / 1e6;
+}
+
+static int usage()
+{
+    fprintf(stderr, "usage: replay <log> [--odometry | --estimator] [--against <log>] [--tolerance in] [--csv file]\n");
+    return 2;
+}
+
+int main(int argc, char** argv)
+{
+    const char* logPath = 0;
+    const char* againstPath = 0;
+    const char* csvPath = 0;
+    double tolerance = -1;
+    int source = -1;
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--odometry") == 0)
+            source = 0;
+        else if(strcmp(argv[i], "--estimator") == 0)
+            source = 1;
+        else if(strcmp(argv[i], "--against") == 0 && i + 1 < argc)
+            againstPath = argv[++i];
+        else if(strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc)
+            tolerance = atof(argv[++i]);
+        else if(strcmp(argv[i], "--csv") == 0 && i + 1 < argc)
+            csvPath = argv[++i];
+        else if(argv[i][0] != '-' && !logPath)
+            logPath = argv[i];
+        else
+            return usage();
+    }
+    if(!logPath)
+        return usage();
+
+    SensorLog log(1);
+    if(!log.load(logPath) || log.size() == 0)
+    {
+        fprintf(stderr, "replay: can't read a sensor log from %s\n", logPath);
+        return 1;
+    }
+    bool estimator = source < 0 ? log.usedEstimator() : source == 1;
+    printf("%s: %u samples over %.3f s, %s %s\n", logPath, (unsigned)log.size(), sampleTime(log, log.size() - 1),
+        odomName(log.getOdomType()), log.usedEstimator() ? "with the pose estimator" : "odometry");
+
+    // The chassis from src/main.cpp, with the odometry settings from setDriveTrainConstants
+    Drive chassis
+    (
+        motor_group(LFT, LFB, LBB, LBT),
+        motor_group(RFT, RFB, RBB, RBT),
+        PORT20,
+        2.66,
+        1,
+        12,
+        log.getOdomType(),
+        1.955,
+        -3.867,
+        -3.867
+    );
+    chassis.setTrackWidth(12);
+    chassis.setOdomProfile(ODOM_CALIBRATION);
+    chassis.setCartridge(600);
+    if(estimator)
+    {
+        // The estimator takes its inertial baseline from the first read, as usePoseEstimator did on the robot
+        chassis.usePoseEstimator(true);
+        chassis.resetToSensors(0, 0, 0, log[0]);
+    }
+
+    FILE* csv = csvPath ? fopen(csvPath, "w") : 0;
+    if(csvPath && !csv)
+    {
+        fprintf(stderr, "replay: can't write %s\n", csvPath);
+        return 1;
+    }
+    if(csv)
+        fprintf(csv, "time,reset,recordedX,recordedY,recordedHeading,replayedX,replayedY,replayedHeading,leftVolts,rightVolts\n");
+
+    Divergence replayed;
+    uint32_t resets = 0;
+    for(uint32_t i = 0; i < log.size(); i++)
+    {
+        const SensorSample& sample = log[i];
+        bool reset = sample.flags & SENSOR_SAMPLE_RESET;
+        if(reset)
+        {
+            chassis.resetToSensors(sample.x, sample.y, sample.heading, sample);
+            resets++;
+        }
+        else
+            chassis.integrateSensors(sample);
+
+        Pose pose = chassis.chassisOdometry.getPose();
+        replayed.add(i, pose.x - sample.x, pose.y - sample.y, pose.heading - sample.heading, 0);
+        if(csv)
+            fprintf(csv, "%.6f,%d,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g\n", sampleTime(log, i), reset ? 1 : 0,
+                sample.x, sample.y, sample.heading, pose.x, pose.y, pose.heading, sample.leftVolts, sample.rightVolts);
+    }
+    if(csv)
+        fclose(csv);
+
+    const SensorSample& last = log[log.size() - 1];
+    Pose pose = chassis.chassisOdometry.getPose();
+    printf("replayed through %s, %u pose resets\n", estimator ? "the pose estimator" : "odometry", (unsigned)resets);
+    printf("recorded end   x %9.4f in  y %9.4f in  heading %9.4f deg\n", last.x, last.y, last.heading);
+    printf("replayed end   x %9.4f in  y %9.4f in  heading %9.4f deg\n", pose.x, pose.y, pose.heading);
+    if(replayed.first < 0)
+        printf("bit-exact, every replayed pose matches the recording\n");
+    else
+        printf("poses differ from %.3f s, by up to %.6f in and %.6f deg\n", sampleTime(log, replayed.first), replayed.position, replayed.heading);
+
+    if(againstPath)
+    {
+        SensorLog against(1);
+        if(!against.load(againstPath))
+        {
+            fprintf(stderr, "replay: can't read a sensor log from %s\n", againstPath);
+            return 1;
+        }
+        Divergence other;
+        uint32_t shared = log.size() < against.size() ? log.size() : against.size();
+        for(uint32_t i = 0; i < shared; i++)
+        {
+            const SensorSample& a = log[i];
+            const SensorSample& b = against[i];
+            other.add(i, b.x - a.x, b.y - a.y, b.heading - a.heading, fmax(fabs(b.leftVolts - a.leftVolts), fabs(b.rightVolts - a.rightVolts)));
+        }
+        printf("against %s: %u samples, %u compared\n", againstPath, (unsigned)against.size(), (unsigned)shared);
+        if(other.first < 0 && log.size() == against.size())
+            printf("identical poses and drive voltages\n");
+        else if(other.first < 0)
+            printf("identical poses and drive voltages over the shared samples\n");
+        else
+            printf("differ from %.3f s, poses by up to %.6f in and %.6f deg, drive voltage by up to %.4f V\n",
+                sampleTime(log, other.first), other.position, other.heading, other.volts);
+    }
+
+    if(tolerance >= 0 && replayed.position > tolerance)
+    {
+        printf("FAIL: replayed poses are up to %.6f in from the recording, over the %g in tolerance\n", replayed.position, tolerance);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,397 @@
+// Offline trajectory generator
+//
+//   trajgen [-o include/Trajectories.h] routes/*.route
+//
+// Reads route descriptions, turns every trajectory into a time parameterized
+// table of 10 ms ticks and writes them out as constexpr arrays for
+// Drive::followTrajectory. Runs on the host, nothing here goes on the brain.
+//
+// Route format, one command per line, # starts a comment:
+//
+//   trajectory <name>                      starts a new trajectory
+//   start <x> <y>                          first point (inches)
+//   point <x> <y>                          straight piece to the point
+//   quadratic <mx> <my> <x> <y>            quadratic Bezier through a control point
+//   cubic <c1x> <c1y> <c2x> <c2y> <x> <y>  cubic Bezier through two control points
+//   reverse                                drive the trajectory backwards
+//   limits <velocity> <acceleration>       in/s and in/s^2, overrides the defaults
+//   track <width>                          track width in inches
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+static const float TICK = 0.01;         // seconds, the motion loop period
+static const float SPACING = 0.25;      // inches between samples before timing
+static const int LENGTH_STEPS = 400;    // steps per piece when measuring its arc length
+static const float CORNER = 2;          // degrees, a sharper joint between pieces is reported
+
+// One piece of a trajectory, kept as the exact line or Bezier curve so heading and
+// curvature come from its derivatives rather than from differences of sampled points
+struct Piece
+{
+    int order;                  // 1 for a line, 2 quadratic, 3 cubic
+    double x[4], y[4];          // control points, the first is the end of the last piece
+    std::vector<double> lengths;// arc length at each of LENGTH_STEPS + 1 even steps of t
+    int line;
+};
+
+struct Route
+{
+    std::string name;
+    bool started;
+    double startX, startY;
+    std::vector<Piece> pieces;
+    double length;
+    bool reversed;
+    float maxVelocity;
+    float maxAcceleration;
+    float trackWidth;
+    int line;
+};
+
+struct Sample
+{
+    double x, y, heading, curvature, velocity, time;
+};
+
+static void fail(const char* file, int line, const char* message)
+{
+    fprintf(stderr, "%s:%d: %s\n", file, line, message);
+    exit(1);
+}
+
+static double wrap180(double angle)
+{
+    while(angle > 180) angle -= 360;
+    while(angle <= -180) angle += 360;
+    return angle;
+}
+
+/// @brief Evaluates a Bezier curve of any order by de Casteljau
+static double bezier(const double* points, int order, double t)
+{
+    double p[4];
+    for(int i = 0; i <= order; i++)
+        p[i] = points[i];
+    for(int level = order; level > 0; level--)
+        for(int i = 0; i < level; i++)
+            p[i] += (p[i+1] - p[i]) * t;
+    return p[0];
+}
+
+/// @brief Control points of a Bezier curve's derivative, one order lower
+static void derivative(const double* points, int order, double* out)
+{
+    for(int i = 0; i < order; i++)
+        out[i] = order * (points[i+1] - points[i]);
+}
+
+/// @brief Position, first and second derivatives of a piece at t
+static void evaluate(const Piece& piece, double t, double& x, double& y, double& dx, double& dy, double& ddx, double& ddy)
+{
+    double px[3] = {0}, py[3] = {0}, qx[2] = {0}, qy[2] = {0};
+    x = bezier(piece.x, piece.order, t);
+    y = bezier(piece.y, piece.order, t);
+    derivative(piece.x, piece.order, px);
+    derivative(piece.y, piece.order, py);
+    dx = bezier(px, piece.order - 1, t);
+    dy = bezier(py, piece.order - 1, t);
+    if(piece.order < 2)
+    {
+        ddx = ddy = 0;
+        return;
+    }
+    derivative(px, piece.order - 1, qx);
+    derivative(py, piece.order - 1, qy);
+    ddx = bezier(qx, piece.order - 2, t);
+    ddy = bezier(qy, piece.order - 2, t);
+}
+
+/// @brief Heading of travel at t, clockwise from +Y in degrees. Where a control
+/// point sits on the end the derivative vanishes, so it looks just inside the piece.
+static double tangentHeading(const Piece& piece, double t)
+{
+    double x, y, dx, dy, ddx, ddy;
+    evaluate(piece, t, x, y, dx, dy, ddx, ddy);
+    if(dx*dx + dy*dy < 1e-12)
+        evaluate(piece, t < 0.5 ? t + 1e-4 : t - 1e-4, x, y, dx, dy, ddx, ddy);
+    return atan2(dx, dy) * 180.0 / M_PI;
+}
+
+/// @brief Adds a piece starting at the end of the last one and measures its length
+static void addPiece(const char* file, Route& route, int order, const double* x, const double* y, int line)
+{
+    Piece piece;
+    piece.order = order;
+    piece.line = line;
+    piece.x[0] = route.pieces.empty() ? route.startX : route.pieces.back().x[route.pieces.back().order];
+    piece.y[0] = route.pieces.empty() ? route.startY : route.pieces.back().y[route.pieces.back().order];
+    for(int i = 1; i <= order; i++)
+    {
+        piece.x[i] = x[i-1];
+        piece.y[i] = y[i-1];
+    }
+
+    piece.lengths.resize(LENGTH_STEPS + 1);
+    piece.lengths[0] = 0;
+    double lastX = piece.x[0], lastY = piece.y[0];
+    for(int i = 1; i <= LENGTH_STEPS; i++)
+    {
+        double t = (double)i / LENGTH_STEPS;
+        double px = bezier(piece.x, order, t), py = bezier(piece.y, order, t);
+        piece.lengths[i] = piece.lengths[i-1] + sqrt((px - lastX) * (px - lastX) + (py - lastY) * (py - lastY));
+        lastX = px;
+        lastY = py;
+    }
+    if(piece.lengths.back() <= 0)
+        fail(file, line, "piece has no length");
+
+    // The heading table can't turn a corner, it would jump there at full speed
+    if(!route.pieces.empty())
+    {
+        double corner = fabs(wrap180(tangentHeading(piece, 0) - tangentHeading(route.pieces.back(), 1)));
+        if(corner > CORNER)
+            fprintf(stderr, "%s:%d: warning: %.1f degree corner where the pieces join, the heading jumps there\n", file, line, corner);
+    }
+
+    route.length += piece.lengths.back();
+    route.pieces.push_back(piece);
+}
+
+/// @brief Reads every trajectory in a route file
+static void readRoutes(const char* file, std::vector<Route>& routes)
+{
+    FILE* in = fopen(file, "r");
+    if(!in)
+        fail(file, 0, "can't open");
+
+    char buffer[256];
+    int line = 0;
+    while(fgets(buffer, sizeof(buffer), in))
+    {
+        line++;
+        char* hash = strchr(buffer, '#');
+        if(hash)
+            *hash = 0;
+
+        char command[32];
+        double v[6];
+        char name[128];
+        if(sscanf(buffer, "%31s", command) != 1)
+            continue;
+
+        if(strcmp(command, "trajectory") == 0)
+        {
+            if(sscanf(buffer, "%*s %127s", name) != 1)
+                fail(file, line, "trajectory needs a name");
+            Route route;
+            route.name = name;
+            route.started = false;
+            route.startX = route.startY = 0;
+            route.length = 0;
+            route.reversed = false;
+            route.maxVelocity = 60;
+            route.maxAcceleration = 150;
+            route.trackWidth = 12;
+            route.line = line;
+            routes.push_back(route);
+            continue;
+        }
+        if(routes.empty())
+            fail(file, line, "expected trajectory first");
+        Route& route = routes.back();
+
+        if(strcmp(command, "start") == 0 && sscanf(buffer, "%*s %lf %lf", &v[0], &v[1]) == 2)
+        {
+            if(route.started)
+                fail(file, line, "start must come before the path");
+            route.started = true;
+            route.startX = v[0];
+            route.startY = v[1];
+        }
+        else if(strcmp(command, "reverse") == 0)
+            route.reversed = true;
+        else if(strcmp(command, "limits") == 0 && sscanf(buffer, "%*s %lf %lf", &v[0], &v[1]) == 2)
+        {
+            route.maxVelocity = v[0];
+            route.maxAcceleration = v[1];
+        }
+        else if(strcmp(command, "track") == 0 && sscanf(buffer, "%*s %lf", &v[0]) == 1)
+            route.trackWidth = v[0];
+        else if(!route.started)
+            fail(file, line, "path needs a start");
+        else if(strcmp(command, "point") == 0 && sscanf(buffer, "%*s %lf %lf", &v[0], &v[1]) == 2)
+        {
+            double x[1] = {v[0]}, y[1] = {v[1]};
+            addPiece(file, route, 1, x, y, line);
+        }
+        else if(strcmp(command, "quadratic") == 0 && sscanf(buffer, "%*s %lf %lf %lf %lf", &v[0], &v[1], &v[2], &v[3]) == 4)
+        {
+            double x[2] = {v[0], v[2]}, y[2] = {v[1], v[3]};
+            addPiece(file, route, 2, x, y, line);
+        }
+        else if(strcmp(command, "cubic") == 0 && sscanf(buffer, "%*s %lf %lf %lf %lf %lf %lf", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) == 6)
+        {
+            double x[3] = {v[0], v[2], v[4]}, y[3] = {v[1], v[3], v[5]};
+            addPiece(file, route, 3, x, y, line);
+        }
+        else
+            fail(file, line, "bad command");
+    }
+    fclose(in);
+}
+
+/// @brief Resamples the path evenly by arc length and times it. Every sample
+/// takes its heading and curvature from the piece's derivatives there and gets
+/// the highest speed where neither wheel passes the velocity limit on that
+/// curvature, then a forward and a backward pass apply the acceleration limit
+/// so the trajectory starts and ends at rest.
+static std::vector<Sample> timePath(const Route& route)
+{
+    int count = (int)ceil(route.length / SPACING) + 1;
+    double spacing = route.length / (count - 1);
+
+    std::vector<Sample> samples(count);
+    size_t piece = 0;
+    double pieceStart = 0;
+    for(int i = 0; i < count; i++)
+    {
+        double distance = i * spacing;
+        while(piece < route.pieces.size() - 1 && pieceStart + route.pieces[piece].lengths.back() < distance)
+            pieceStart += route.pieces[piece++].lengths.back();
+
+        // Arc length back to t through the length table
+        const Piece& p = route.pieces[piece];
+        double along = fmin(fmax(distance - pieceStart, 0), p.lengths.back());
+        int step = 0;
+        while(step < LENGTH_STEPS - 1 && p.lengths[step+1] < along)
+            step++;
+        double stepLength = p.lengths[step+1] - p.lengths[step];
+        double t = (step + (stepLength > 0 ? (along - p.lengths[step]) / stepLength : 0)) / LENGTH_STEPS;
+
+        // Heading of travel, clockwise from +Y, and curvature as its change per inch
+        double dx, dy, ddx, ddy;
+        evaluate(p, t, samples[i].x, samples[i].y, dx, dy, ddx, ddy);
+        double speed = sqrt(dx*dx + dy*dy);
+        samples[i].heading = tangentHeading(p, t);
+        samples[i].curvature = speed > 1e-6 ? (dy * ddx - dx * ddy) / (speed * speed * speed) : 0;
+    }
+
+    for(int i = 0; i < count; i++)
+        samples[i].velocity = route.maxVelocity / (1 + fabs(samples[i].curvature) * route.trackWidth / 2);
+    samples[0].velocity = 0;
+    samples[count-1].velocity = 0;
+    for(int i = 1; i < count; i++)
+        samples[i].velocity = fmin(samples[i].velocity, sqrt(samples[i-1].velocity * samples[i-1].velocity + 2 * route.maxAcceleration * spacing));
+    for(int i = count - 2; i >= 0; i--)
+        samples[i].velocity = fmin(samples[i].velocity, sqrt(samples[i+1].velocity * samples[i+1].velocity + 2 * route.maxAcceleration * spacing));
+
+    samples[0].time = 0;
+    for(int i = 1; i < count; i++)
+    {
+        double average = (samples[i].velocity + samples[i-1].velocity) / 2;
+        samples[i].time = samples[i-1].time + (average > 0 ? spacing / average : 0);
+    }
+    return samples;
+}
+
+/// @brief Writes one trajectory as 10 ms ticks
+static void writeTrajectory(FILE* out, const Route& route, const std::vector<Sample>& samples)
+{
+    double duration = samples.back().time;
+    int ticks = (int)ceil(duration / TICK) + 1;
+    double sign = route.reversed ? -1 : 1;
+
+    fprintf(out, "// %s: %.1f in, %.2f s\n", route.name.c_str(), route.length, duration);
+    fprintf(out, "constexpr TrajectoryPoint %s_points[] = {\n", route.name.c_str());
+
+    int i = 0;
+    for(int tick = 0; tick < ticks; tick++)
+    {
+        double time = fmin(tick * TICK, duration);
+        while(i < (int)samples.size() - 2 && samples[i+1].time < time)
+            i++;
+        const Sample& a = samples[i];
+        const Sample& b = samples[i+1];
+
+        // The timing above has the speed change evenly over each piece, so the
+        // position is the integral of that speed, not a straight share of the time.
+        // Interpolating position by time would put it ahead of the velocity while
+        // speeding up, which RAMSETE reads as an along track error. The same ramp
+        // gives the acceleration, constant over the piece, rather than differencing
+        // the velocity between ticks.
+        double pieceTime = b.time - a.time;
+        double tau = fmin(fmax(time - a.time, 0), pieceTime);
+        double acceleration = pieceTime > 0 ? (b.velocity - a.velocity) / pieceTime : 0;
+        double velocity = a.velocity + acceleration * tau;
+        double pieceLength = pieceTime * (a.velocity + b.velocity) / 2;
+        double t = pieceLength > 0 ? (a.velocity + velocity) / 2 * tau / pieceLength : 0;
+        if(t > 1) t = 1;
+
+        double x = a.x + (b.x - a.x) * t;
+        double y = a.y + (b.y - a.y) * t;
+        double heading = a.heading + wrap180(b.heading - a.heading) * t;
+        double curvature = a.curvature + (b.curvature - a.curvature) * t;
+
+        // Backwards the robot faces away from the direction of travel, which also
+        // flips which way it curves
+        if(route.reversed)
+        {
+            heading = wrap180(heading + 180);
+            curvature = -curvature;
+        }
+        if(heading < 0)
+            heading += 360;
+
+        fprintf(out, "    {%.3f, %.3f, %.2f, %.2f, %.1f, %.5f},\n", x, y, heading, sign * velocity, sign * acceleration, curvature);
+    }
+    fprintf(out, "};\n");
+    fprintf(out, "constexpr Trajectory %s = {%s_points, %d, %.3ff};\n\n", route.name.c_str(), route.name.c_str(), ticks, TICK);
+}
+
+int main(int argc, char** argv)
+{
+    const char* output = 0;
+    std::vector<const char*> files;
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            output = argv[++i];
+        else
+            files.push_back(argv[i]);
+    }
+    if(files.empty())
+    {
+        fprintf(stderr, "usage: trajgen [-o output.h] route...\n");
+        return 1;
+    }
+
+    std::vector<Route> routes;
+    for(size_t i = 0; i < files.size(); i++)
+    {
+        size_t first = routes.size();
+        readRoutes(files[i], routes);
+        for(size_t r = first; r < routes.size(); r++)
+            if(routes[r].pieces.empty())
+                fail(files[i], routes[r].line, "trajectory needs at least two points");
+    }
+
+    FILE* out = output ? fopen(output, "w") : stdout;
+    if(!out)
+        fail(output, 0, "can't write");
+
+    fprintf(out, "#pragma once\n");
+    fprintf(out, "// Generated by tools/trajgen from the routes folder, run make trajectories after editing a route\n");
+    fprintf(out, "#include \"Trajectory.h\"\n\n");
+    fprintf(out, "namespace trajectories {\n\n");
+    for(size_t i = 0; i < routes.size(); i++)
+        writeTrajectory(out, routes[i], timePath(routes[i]));
+    fprintf(out, "}\n");
+
+    if(output)
+        fclose(out);
+    return 0;
+}